@@ -77,6 +77,7 @@ node_t * ROXML_INT roxml_create_node(int pos, void *src, int type)
 	n->src.src = src;
 	n->pos = pos;
 	n->end = pos;
+	n->nb_chld = -1;
 
 	return n;
 }
@@ -1148,6 +1149,25 @@ node_t * ROXML_INT roxml_parent_node(node_t *parent, node_t * n, int position)
 		n->ns = parent->ns;
 	}
 
+	if((parent->nb_chld >= 0) && (roxml_get_type(n) == ROXML_ELM_NODE)) {
+		parent->nb_chld++;
+	}
+
+	if((position == 0) && ((n->type & ROXML_ATTR_NODE) == 0)) {
+		/* append after the last child: no need to count the children */
+		if(parent->chld == NULL) {
+			parent->chld = n;
+			n->sibl = NULL;
+			parent->next = n;
+			return n;
+		} else if(parent->next && (parent->next->prnt == parent) && (parent->next->sibl == NULL)) {
+			parent->next->sibl = n;
+			n->sibl = NULL;
+			parent->next = n;
+			return n;
+		}
+	}
+
 	if(n->type & ROXML_ATTR_NODE) {
 		nb = roxml_get_attr_nb(n->prnt);
 	} else {
@@ -1468,6 +1488,7 @@ void ROXML_INT roxml_del_txt_node(node_t * n)
 		}
 		current->sibl = n->sibl;
 	}
+	roxml_reset_last_chld(n->prnt, n);
 } 
 
 void ROXML_INT roxml_del_std_node(node_t * n)
@@ -1481,10 +1502,33 @@ void ROXML_INT roxml_del_std_node(node_t * n)
 		}
 		current->sibl = n->sibl;
 	}
+	roxml_reset_last_chld(n->prnt, n);
 	roxml_del_tree(n->chld);
 	roxml_del_tree(n->attr);
 } 
 
+void ROXML_INT roxml_reset_last_chld(node_t * parent, node_t * n)
+{
+	if(parent->next == n) {
+		node_t *last = parent->chld;
+		while(last && last->sibl) {
+			last = last->sibl;
+		}
+		parent->next = last;
+	}
+	parent->nb_chld = -1;
+}
+
+int ROXML_INT roxml_name_match(node_t * n, char * name)
+{
+	char node_name[INTERNAL_BUF_SIZE];
+	if(name == NULL) {
+		return 1;
+	}
+	roxml_get_name(n, node_name, INTERNAL_BUF_SIZE);
+	return (strcmp(node_name, name) == 0);
+}
+
 void roxml_compute_and(node_t * root, node_t **node_set, int *count, int cur_req_id, int prev_req_id)
 {
 	int i = 0;
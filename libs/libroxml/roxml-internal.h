@@ -355,6 +355,27 @@ void ROXML_INT roxml_del_txt_node		(node_t * n);
  */
 void ROXML_INT roxml_del_std_node		(node_t * n); 
 
+/** \brief last child update function
+ *
+ * \fn roxml_reset_last_chld(node_t * parent, node_t * n); 
+ * this function keeps the reference to the last child of a node and its count of
+ * children correct when one of its children is removed
+ * \param parent the node that had the child
+ * \param n the child removed
+ * \return 
+ */
+void ROXML_INT roxml_reset_last_chld		(node_t * parent, node_t * n); 
+
+/** \brief node name comparison function
+ *
+ * \fn roxml_name_match(node_t * n, char * name); 
+ * this function checks the name of a node without allocating memory
+ * \param n the node to check
+ * \param name the name expected, NULL matches any name
+ * \return 1 if the name matches, 0 else
+ */
+int ROXML_INT roxml_name_match		(node_t * n, char * name); 
+
 /** \brief node type setter function
  *
  * \fn roxml_set_type(node_t * n, int type); 
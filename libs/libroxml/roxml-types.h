@@ -155,6 +155,7 @@ typedef struct node {
 	struct node *attr;		/*!< ref to attribute */
 	struct node *next;		/*!< ref to last chld (internal use) */
 	struct node *ns;		/*!< ref to namespace definition */
+	int nb_chld;			/*!< number of element children, -1 when not counted yet (internal use) */
 	void *priv;			/*!< ref to xpath tok (internal use) or alias for namespaces */
 } node_t;
 
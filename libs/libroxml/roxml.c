@@ -414,9 +414,7 @@ node_t * ROXML_API roxml_get_nodes(node_t *n, int type, char * name, int nth)
 		if(n->attr && (type & ROXML_ATTR_NODE)) {
 			ptr = n->attr;
 			while(ptr) {
-				int ans = strcmp(roxml_get_name(ptr, NULL, 0), name);
-				roxml_release(RELEASE_LAST);
-				if(ans == 0)	{
+				if(roxml_name_match(ptr, name))	{
 					return ptr;
 				}
 				ptr = ptr->sibl;
@@ -424,12 +422,8 @@ node_t * ROXML_API roxml_get_nodes(node_t *n, int type, char * name, int nth)
 		}
 		ptr = n->chld;
 		while(ptr) {
-			if(roxml_get_type(ptr) & type) {
-				int ans = strcmp(roxml_get_name(ptr, NULL, 0), name);
-				roxml_release(RELEASE_LAST);
-				if(ans == 0)	{
-					return ptr;
-				}
+			if((roxml_get_type(ptr) & type) && roxml_name_match(ptr, name)) {
+				return ptr;
 			}
 			ptr = ptr->sibl;
 		}
@@ -521,7 +515,14 @@ node_t * ROXML_API roxml_get_attr(node_t *n, char * name, int nth)
 
 int ROXML_API roxml_get_chld_nb(node_t *n)
 {
-	return roxml_get_nodes_nb(n, ROXML_ELM_NODE);
+	if(n && (n->nb_chld >= 0)) {
+		return n->nb_chld;
+	}
+	if(n) {
+		n->nb_chld = roxml_get_nodes_nb(n, ROXML_ELM_NODE);
+		return n->nb_chld;
+	}
+	return -1;
 }
 
 node_t * ROXML_API roxml_get_chld(node_t *n, char * name, int nth)
@@ -529,6 +530,50 @@ node_t * ROXML_API roxml_get_chld(node_t *n, char * name, int nth)
 	return roxml_get_nodes(n, ROXML_ELM_NODE, name, nth);
 }
 
+node_t * ROXML_API roxml_get_first_node(node_t *n, int type, char * name)
+{
+	node_t *ptr = NULL;
+
+	if(n == NULL) {
+		return NULL;
+	}
+
+	if(type & ROXML_ATTR_NODE) {
+		ptr = n->attr;
+	} else {
+		ptr = n->chld;
+	}
+	while(ptr && !((roxml_get_type(ptr) & type) && roxml_name_match(ptr, name))) {
+		ptr = ptr->sibl;
+	}
+	return ptr;
+}
+
+node_t * ROXML_API roxml_get_next_node(node_t *n, int type, char * name)
+{
+	node_t *ptr = NULL;
+
+	if(n == NULL) {
+		return NULL;
+	}
+
+	ptr = n->sibl;
+	while(ptr && !((roxml_get_type(ptr) & type) && roxml_name_match(ptr, name))) {
+		ptr = ptr->sibl;
+	}
+	return ptr;
+}
+
+node_t * ROXML_API roxml_get_first_chld(node_t *n, char * name)
+{
+	return roxml_get_first_node(n, ROXML_ELM_NODE, name);
+}
+
+node_t * ROXML_API roxml_get_next_chld(node_t *n, char * name)
+{
+	return roxml_get_next_node(n, ROXML_ELM_NODE, name);
+}
+
 node_t * ROXML_API roxml_get_prev_sibling(node_t *n)
 {
 	node_t * prev = NULL;
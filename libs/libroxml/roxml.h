@@ -481,12 +481,72 @@ node_t*	ROXML_API roxml_get_chld		(node_t *n, char * name, int nth);
 /** \brief chlds number getter function
  *
  * \fn int ROXML_API roxml_get_chld_nb(node_t *n);
- * This function return the number of chlidren for a given node
+ * This function return the number of chlidren for a given node, the count is
+ * cached in the node and kept up to date when children are added or removed
  * \param n is one node of the tree
  * \return  the number of chlildren
  */
 int 	ROXML_API roxml_get_chld_nb		(node_t *n);
 
+/** \brief first node getter function
+ *
+ * \fn node_t* ROXML_API roxml_get_first_node(node_t *n, int type, char * name);
+ * This function returns the first child (or the first attribute if type contains
+ * ROXML_ATTR_NODE) of a given node matching a type and optionally a name.
+ * Together with roxml_get_next_node it walks all the children of a node in linear
+ * time, while a loop on roxml_get_chld with an increasing nth is quadratic.
+ * \param n is one node of the tree
+ * \param type is the bitmask of the node types to look for
+ * \param name is the name of the node to get, NULL for any name
+ * \return the first node matching or NULL
+ * \see roxml_get_next_node
+ *
+ * example:
+ * \code
+ *	node_t * item = roxml_get_first_node(root, ROXML_ELM_NODE, NULL);
+ *	while(item) {
+ *		// use item here
+ *		item = roxml_get_next_node(item, ROXML_ELM_NODE, NULL);
+ *	}
+ * \endcode
+ */
+node_t*	ROXML_API roxml_get_first_node		(node_t *n, int type, char * name);
+
+/** \brief next node getter function
+ *
+ * \fn node_t* ROXML_API roxml_get_next_node(node_t *n, int type, char * name);
+ * This function returns the next sibling of a given node matching a type and
+ * optionally a name.
+ * \param n is one node of the tree
+ * \param type is the bitmask of the node types to look for
+ * \param name is the name of the node to get, NULL for any name
+ * \return the next node matching or NULL
+ * \see roxml_get_first_node
+ */
+node_t*	ROXML_API roxml_get_next_node		(node_t *n, int type, char * name);
+
+/** \brief first chld getter function
+ *
+ * \fn node_t* ROXML_API roxml_get_first_chld(node_t *n, char * name);
+ * This function returns the first child element of a given node, optionally by name.
+ * \param n is one node of the tree
+ * \param name is the name of the child to get, NULL for any name
+ * \return the first child element matching or NULL
+ * \see roxml_get_first_node
+ */
+node_t*	ROXML_API roxml_get_first_chld		(node_t *n, char * name);
+
+/** \brief next chld getter function
+ *
+ * \fn node_t* ROXML_API roxml_get_next_chld(node_t *n, char * name);
+ * This function returns the next sibling element of a given node, optionally by name.
+ * \param n is one node of the tree
+ * \param name is the name of the sibling to get, NULL for any name
+ * \return the next sibling element matching or NULL
+ * \see roxml_get_next_node
+ */
+node_t*	ROXML_API roxml_get_next_chld		(node_t *n, char * name);
+
 /** \brief process-instruction getter function
  *
  * \fn node_t* ROXML_API roxml_get_pi(node_t *n, int nth);
@@ -6,7 +6,7 @@
 // Copyright   : (C) 2010-2020 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 28/2/2016
+// Last change : 17/10/2026
 // Description : Collection of functions for air navigation calculation
 //============================================================================
 
@@ -17,6 +17,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "AirCalc.h"
+#ifdef AIRCALC_FAST_TRIG
+#include "FastTrig.h"
+#endif
 
 //Internal AirCalc calculation defines
 #define EARTH_RADIUS_KM 6371
@@ -131,7 +134,21 @@ double absAngle(const double angle) { //to put angle in the range between 0 and
 //}
 
 double calcGreatCircleRoute(const double lat1, const double lon1, const double lat2, const double lon2, double *d) { //Ortodrome
-	*d=calcAngularDist(lat1,lon1,lat2,lon2);
+#ifdef AIRCALC_FAST_TRIG
+	return FastTrigGreatCircleRoute(lat1,lon1,lat2,lon2,d);
+#else
+	return calcGreatCircleRouteTrig(lat1,sin(lat1),cos(lat1),lon1,lat2,lon2,d);
+#endif
+}
+
+// Versions with the sine and cosine of the latitude of the point 1 already calculated,
+// as the Navigator keeps them for all the waypoints of the flight plan.
+double calcGreatCircleRouteTrig(const double lat1, const double sinLat1, const double cosLat1, const double lon1, const double lat2, const double lon2, double *d) {
+#ifdef AIRCALC_FAST_TRIG
+	return FastTrigGreatCircleRoute(lat1,lon1,lat2,lon2,d);
+#else
+	double sinLat2=sin(lat2);
+	*d=acos(sinLat1*sinLat2+cosLat1*cos(lat2)*cos(lon1-lon2));
 	if(lat1+lat2==0 && fabs(lon1-lon2)==M_PI && fabs(lat1)!=M_PI_2) return 0; //Course between antipodal points is undefined!
 	if(d==0 || lat1==-M_PI_2) return TWO_PI; // distance null or starting from S pole
 	if (lat1==M_PI_2) return M_PI; //starting from N pole
@@ -139,12 +156,16 @@ double calcGreatCircleRoute(const double lat1, const double lon1, const double l
 		if(lat1>lat2) return M_PI;
 		else return TWO_PI;
 	}
-	double tc=acos((sin(lat2)-sin(lat1)*cos(*d))/(sin(*d)*cos(lat1)));
+	double tc=acos((sinLat2-sinLat1*cos(*d))/(sin(*d)*cosLat1));
 	if(sin(lon2-lon1)>0) tc=TWO_PI-tc;
 	return tc;
+#endif
 }
 
 double calcGreatCircleCourse(const double lat1, const double lon1, const double lat2, const double lon2) { //not require pre-computation of distance
+#ifdef AIRCALC_FAST_TRIG
+	return FastTrigGreatCircleCourse(lat1,lon1,lat2,lon2);
+#else
 	if(lat2==M_PI_2) return TWO_PI; //we are going to N pole
 	if(lat2==-M_PI_2) return M_PI; //we are going to S pole
 	if(lon1==lon2) {
@@ -152,6 +173,7 @@ double calcGreatCircleCourse(const double lat1, const double lon1, const double
 			else return TWO_PI;
 	}
 	return absAngle(atan2(sin(lon1-lon2)*cos(lat2),cos(lat1)*sin(lat2)-sin(lat1)*cos(lat2)*cos(lon1-lon2)));
+#endif
 }
 
 double calcGreatCircleFinalCourse(const double lat1, const double lon1, const double lat2, const double lon2) {
@@ -159,13 +181,74 @@ double calcGreatCircleFinalCourse(const double lat1, const double lon1, const do
 }
 
 double calcAngularDist(const double lat1, const double lon1, const double lat2, const double lon2) {
+#ifdef AIRCALC_FAST_TRIG
+	return FastTrigAngularDist(lat1,lon1,lat2,lon2);
+#else
 	return acos(sin(lat1)*sin(lat2)+cos(lat1)*cos(lat2)*cos(lon1-lon2));
+#endif
 }
 
 double calcSmallAngularDist(const double lat1, const double lon1, const double lat2, const double lon2) { //less subject to rounding error for short distances
 	return 2*asin(sqrt(pow(sin((lat1-lat2)/2),2)+cos(lat1)*cos(lat2)*pow(sin((lon1-lon2)/2),2)));
 }
 
+// Batch versions: from the point 1 to the num points of the arrays lats and lons.
+// The trigonometry of the point 1 is calculated only once for all the points.
+void calcAngularDistBatch(const double lat1, const double lon1, const double *lats, const double *lons, double *dists, const int num) {
+	int i;
+#ifdef AIRCALC_FAST_TRIG
+	for(i=0;i<num;i++) dists[i]=FastTrigAngularDist(lat1,lon1,lats[i],lons[i]);
+#else
+	double sinLat1=sin(lat1), cosLat1=cos(lat1);
+	for(i=0;i<num;i++) dists[i]=acos(sinLat1*sin(lats[i])+cosLat1*cos(lats[i])*cos(lon1-lons[i]));
+#endif
+}
+
+void calcGreatCircleCourseBatch(const double lat1, const double lon1, const double *lats, const double *lons, double *courses, const int num) {
+	int i;
+#ifdef AIRCALC_FAST_TRIG
+	for(i=0;i<num;i++) courses[i]=FastTrigGreatCircleCourse(lat1,lon1,lats[i],lons[i]);
+#else
+	double sinLat1=sin(lat1), cosLat1=cos(lat1);
+	for(i=0;i<num;i++) {
+		if(lats[i]==M_PI_2) courses[i]=TWO_PI; //same special cases of calcGreatCircleCourse
+		else if(lats[i]==-M_PI_2) courses[i]=M_PI;
+		else if(lon1==lons[i]) courses[i]=(lat1>lats[i])?M_PI:TWO_PI;
+		else {
+			double cosLat2=cos(lats[i]), dlon=lon1-lons[i];
+			courses[i]=absAngle(atan2(sin(dlon)*cosLat2,cosLat1*sin(lats[i])-sinLat1*cosLat2*cos(dlon)));
+		}
+	}
+#endif
+}
+
+int calcNearestPoint(const double lat1, const double lon1, const double *lats, const double *lons, const int num, double *dist) { //returns the index of the nearest point, the last one if more are at the same distance
+	int i, nearest=-1;
+#ifdef AIRCALC_FAST_TRIG
+	double shortest=0;
+	for(i=0;i<num;i++) {
+		double d=FastTrigAngularDist(lat1,lon1,lats[i],lons[i]);
+		if(nearest<0 || d<=shortest) {
+			shortest=d;
+			nearest=i;
+		}
+	}
+	if(dist!=NULL) *dist=shortest;
+#else
+	double cosLat1=cos(lat1), smallest=0;
+	for(i=0;i<num;i++) { //the haversine grows with the distance: no need of asin and sqrt for each point
+		double sinHalfDlat=sin((lat1-lats[i])/2), sinHalfDlon=sin((lon1-lons[i])/2);
+		double h=sinHalfDlat*sinHalfDlat+cosLat1*cos(lats[i])*sinHalfDlon*sinHalfDlon;
+		if(nearest<0 || h<=smallest) {
+			smallest=h;
+			nearest=i;
+		}
+	}
+	if(dist!=NULL) *dist=2*asin(sqrt(smallest));
+#endif
+	return nearest;
+}
+
 double Rad2Km(const double rad) {
 	return rad*EARTH_RADIUS_KM;
 }
@@ -221,8 +304,19 @@ bool isAngleBetween(double low, double angle, double hi) {
 }
 
 double calcGCCrossTrackError(const double lat1, const double lon1, const double lon2, const double latX, const double lonX, const double course12, double *atd) {
+#ifdef AIRCALC_FAST_TRIG
+	return FastTrigGCCrossTrackError(lat1,lon1,lon2,latX,lonX,course12,atd);
+#else
+	return calcGCCrossTrackErrorTrig(lat1,sin(lat1),cos(lat1),lon1,lon2,latX,lonX,course12,atd);
+#endif
+}
+
+double calcGCCrossTrackErrorTrig(const double lat1, const double sinLat1, const double cosLat1, const double lon1, const double lon2, const double latX, const double lonX, const double course12, double *atd) {
+#ifdef AIRCALC_FAST_TRIG
+	return FastTrigGCCrossTrackError(lat1,lon1,lon2,latX,lonX,course12,atd);
+#else
 	double dist1X,xtd; //positive XTD means right of course, negative means left
-	double course1X=calcGreatCircleRoute(lat1,lon1,latX,lonX,&dist1X);
+	double course1X=calcGreatCircleRouteTrig(lat1,sinLat1,cosLat1,lon1,latX,lonX,&dist1X);
 	if(lat1!=M_PI_2 && lat1!=-M_PI_2) xtd=asin(sin(dist1X)*sin(course1X-course12));
 	else { //If the point 1 is the N or S Pole replace crs_1X-crs_12 with lonX-lon2 or lon2-lonX, respectively
 		double diff;
@@ -235,6 +329,7 @@ double calcGCCrossTrackError(const double lat1, const double lon1, const double
 	//For very short distances
 	// *atd=asin(sqrt(pow(sin(dist1X),2)-pow(sin(xtd),2))/cos(xtd));
 	return xtd;
+#endif
 }
 
 void convertDecimal2DegMin(const double dec, int *deg, double *min) {
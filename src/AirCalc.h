@@ -6,7 +6,7 @@
 // Copyright   : (C) 2010-2020 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 28/2/2016
+// Last change : 17/10/2026
 // Description : Header of AirCalc.c
 //============================================================================
 
@@ -40,6 +40,9 @@ double latDegMinSec2rad(const int deg, const int min, const float sec, const boo
 double lonDegMinSec2rad(const int deg, const int min, const float sec, const bool E);
 double calcAngularDist(const double lat1, const double lon1, const double lat2, const double lon2);
 double calcSmallAngularDist(const double lat1, const double lon1, const double lat2, const double lon2);
+void calcAngularDistBatch(const double lat1, const double lon1, const double *lats, const double *lons, double *dists, const int num);
+void calcGreatCircleCourseBatch(const double lat1, const double lon1, const double *lats, const double *lons, double *courses, const int num);
+int calcNearestPoint(const double lat1, const double lon1, const double *lats, const double *lons, const int num, double *dist);
 double Rad2Km(const double rad);
 double Km2Rad(const double km);
 double Rad2m(const double rad);
@@ -51,11 +54,13 @@ double Deg2Rad(const double deg);
 double absAngle(const double angle);
 //double calcRhumbLineRoute(const double lat1, const double lon1, const double lat2, const double lon2, double *d);
 double calcGreatCircleRoute(const double lat1, const double lon1, const double lat2, const double lon2, double *d);
+double calcGreatCircleRouteTrig(const double lat1, const double sinLat1, const double cosLat1, const double lon1, const double lat2, const double lon2, double *d);
 double calcGreatCircleCourse(const double lat1, const double lon1, const double lat2, const double lon2);
 double calcGreatCircleFinalCourse(const double lat1, const double lon1, const double lat2, const double lon2);
 bool calcIntermediatePoint(const double lat1, const double lon1, const double lat2, const double lon2, const double atd, const double d, double *latI, double *lonI);
 bool isAngleBetween(double low, double angle, double hi);
 double calcGCCrossTrackError(const double lat1, const double lon1, const double lon2, const double latX, const double lonX, const double course12, double *atd);
+double calcGCCrossTrackErrorTrig(const double lat1, const double sinLat1, const double cosLat1, const double lon1, const double lon2, const double latX, const double lonX, const double course12, double *atd);
 void convertDecimal2DegMin(const double dec, int *deg, double *min);
 void convertDecimal2DegMinSec(const double dec, int *deg, int *min, float *sec);
 void convertRad2DegMinSec(const double rad, int *deg, int *min, float *sec);
@@ -0,0 +1,230 @@
+//============================================================================
+// Name        : AirCalcBench.c
+// Since       : 17/10/2026
+// Author      : Alberto Realis-Luc <alberto.realisluc@gmail.com>
+// Web         : https://www.alus.it/airnavigator/
+// Copyright   : (C) 2010-2026 Alberto Realis-Luc
+// License     : GNU GPL v2
+// Repository  : https://github.com/alus-it/AirNavigator.git
+// Last change : 17/10/2026
+// Description : Errors and speed of the float table based trigonometry of
+//               FastTrig against the double AirCalc, run with: make bench
+//============================================================================
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <sys/time.h>
+#include "Common.h"
+#include "AirCalc.h"
+#include "FastTrig.h"
+
+#define BENCH_LEGS     200000
+#define MIN_LEG_M      100     //length of the legs: from 100 m...
+#define MAX_LEG_M      1000000 //...to 1000 Km
+#define MAX_LAT_DEG    70
+#define MIN_COURSE_M   1000    //the course is compared only on the legs longer than this
+#define BATCH_POINTS   1000    //waypoints of the batch calculations
+
+struct benchLeg {
+	double lat1,lon1,lat2,lon2; //leg from point 1 to point 2
+	double latX,lonX;           //actual position near the leg
+	double course12,dist12;
+};
+
+struct legResult {
+	double dist,course,xtd,atd;
+};
+
+struct legErrors { //maximum errors in meters and radians
+	double dist,course,xtd,atd;
+	int nan;
+};
+
+double randomBetween(double min, double max);
+double angleDiff(double a, double b);
+void makeLeg(struct benchLeg *leg);
+void checkPrimitives(void);
+void truthLeg(const struct benchLeg *l, struct legResult *truth);
+void addErrors(const struct legResult *truth, const struct legResult *res, struct legErrors *err);
+void printErrors(const char *name, const struct legErrors *err);
+void checkLegs(const struct benchLeg *legs, int num);
+void timeLegs(const struct benchLeg *legs, int num);
+void timeBatch(const struct benchLeg *legs, int num);
+
+static volatile double sink; //to not let the compiler remove the calculations timed
+
+double randomBetween(double min, double max) {
+	return min+(max-min)*(rand()/(double)RAND_MAX);
+}
+
+double angleDiff(double a, double b) { //smallest difference between two angles
+	double diff=absAngle(a-b);
+	return (diff>M_PI)?TWO_PI-diff:diff;
+}
+
+void makeLeg(struct benchLeg *leg) {
+	double d=m2Rad(exp(randomBetween(log(MIN_LEG_M),log(MAX_LEG_M)))); //as many short legs as long ones
+	double tc=randomBetween(0,TWO_PI);
+	leg->lat1=Deg2Rad(randomBetween(-MAX_LAT_DEG,MAX_LAT_DEG));
+	leg->lon1=Deg2Rad(randomBetween(-180,180));
+	leg->lat2=asin(sin(leg->lat1)*cos(d)+cos(leg->lat1)*sin(d)*cos(tc)); //destination point given the course and the distance
+	double dlon=atan2(sin(tc)*sin(d)*cos(leg->lat1),cos(d)-sin(leg->lat1)*sin(leg->lat2));
+	leg->lon2=absAngle(leg->lon1-dlon+M_PI)-M_PI; //West longitudes are positive
+	leg->course12=tc;
+	leg->dist12=d;
+	double atd=randomBetween(-0.2,1.2)*leg->dist12; //somewhere along the leg, also a bit before and after it
+	if(!calcIntermediatePoint(leg->lat1,leg->lon1,leg->lat2,leg->lon2,fabs(atd),leg->dist12,&leg->latX,&leg->lonX)) {
+		leg->latX=leg->lat2;
+		leg->lonX=leg->lon2;
+	}
+	leg->latX+=randomBetween(-0.1,0.1)*leg->dist12; //and off the track
+	leg->lonX+=randomBetween(-0.1,0.1)*leg->dist12;
+}
+
+void checkPrimitives(void) {
+	double maxSin=0,maxCos=0,maxAtan=0;
+	for(int i=0;i<=1000000;i++) {
+		float a=-4*M_PI+i*(8*M_PI/1000000);
+		float s,c;
+		FastTrigSinCos(a,&s,&c);
+		if(fabs(s-sin(a))>maxSin) maxSin=fabs(s-sin(a));
+		if(fabs(c-cos(a))>maxCos) maxCos=fabs(c-cos(a));
+		float y=randomBetween(-1000,1000), x=randomBetween(-1000,1000);
+		if(fabs(FastTrigAtan2(y,x)-atan2(y,x))>maxAtan) maxAtan=fabs(FastTrigAtan2(y,x)-atan2(y,x));
+	}
+	printf("Max error of FastTrigSin %.2e, FastTrigCos %.2e, FastTrigAtan2 %.2e rad\n",maxSin,maxCos,maxAtan);
+}
+
+void truthLeg(const struct benchLeg *l, struct legResult *truth) { //well conditioned formulas in long double
+	long double sinHalfDlat=sinl((l->lat1-(long double)l->latX)/2), sinHalfDlon=sinl((l->lon1-(long double)l->lonX)/2);
+	long double d=2*asinl(sqrtl(sinHalfDlat*sinHalfDlat+cosl(l->lat1)*cosl(l->latX)*sinHalfDlon*sinHalfDlon));
+	long double course=atan2l(sinl(l->lon1-(long double)l->lonX)*cosl(l->latX),
+			cosl(l->lat1)*sinl(l->latX)-sinl(l->lat1)*cosl(l->latX)*cosl(l->lon1-(long double)l->lonX));
+	long double along=fabsl(atan2l(sinl(d)*cosl(course-l->course12),cosl(d)));
+	truth->dist=d;
+	truth->course=absAngle(course);
+	truth->xtd=asinl(sinl(d)*sinl(course-l->course12));
+	truth->atd=isAngleBetween(l->course12+M_PI_4,truth->course,l->course12+M_PI)?-along:along;
+}
+
+void addErrors(const struct legResult *truth, const struct legResult *res, struct legErrors *err) {
+	if(isnan(res->dist) || isnan(res->course) || isnan(res->xtd) || isnan(res->atd)) {
+		err->nan++;
+		return;
+	}
+	if(Rad2m(fabs(res->dist-truth->dist))>err->dist) err->dist=Rad2m(fabs(res->dist-truth->dist));
+	if(Rad2m(truth->dist)>=MIN_COURSE_M && angleDiff(res->course,truth->course)>err->course) err->course=angleDiff(res->course,truth->course);
+	if(Rad2m(fabs(res->xtd-truth->xtd))>err->xtd) err->xtd=Rad2m(fabs(res->xtd-truth->xtd));
+	if(Rad2m(fabs(res->atd-truth->atd))>err->atd) err->atd=Rad2m(fabs(res->atd-truth->atd));
+}
+
+void printErrors(const char *name, const struct legErrors *err) {
+	printf("%-15s max error: distance %7.3f m, course %8.5f deg, cross track %7.3f m, along track %7.3f m, NaN %d\n",
+			name,err->dist,Rad2Deg(err->course),err->xtd,err->atd,err->nan);
+}
+
+void checkLegs(const struct benchLeg *legs, int num) {
+	struct legErrors refErr={0,0,0,0,0}, fastErr={0,0,0,0,0};
+	for(int i=0;i<num;i++) {
+		const struct benchLeg *l=&legs[i];
+		struct legResult truth,ref,fast;
+		truthLeg(l,&truth);
+		ref.course=calcGreatCircleRoute(l->lat1,l->lon1,l->latX,l->lonX,&ref.dist);
+		ref.xtd=calcGCCrossTrackError(l->lat1,l->lon1,l->lon2,l->latX,l->lonX,l->course12,&ref.atd);
+		fast.course=FastTrigGreatCircleRoute(l->lat1,l->lon1,l->latX,l->lonX,&fast.dist);
+		fast.xtd=FastTrigGCCrossTrackError(l->lat1,l->lon1,l->lon2,l->latX,l->lonX,l->course12,&fast.atd);
+		addErrors(&truth,&ref,&refErr);
+		addErrors(&truth,&fast,&fastErr);
+	}
+	printf("Against long double on %d legs from %d m to %d Km, course on the legs longer than %d m:\n",num,MIN_LEG_M,MAX_LEG_M/1000,MIN_COURSE_M);
+	printErrors("double AirCalc",&refErr);
+	printErrors("FastTrig",&fastErr);
+}
+
+void timeLegs(const struct benchLeg *legs, int num) {
+	struct timeval start;
+	double sum=0,d,atd;
+	long long us[4];
+	gettimeofday(&start,NULL);
+	for(int i=0;i<num;i++) sum+=calcGreatCircleRoute(legs[i].lat1,legs[i].lon1,legs[i].latX,legs[i].lonX,&d)+d;
+	us[0]=elapsedUs(&start);
+	gettimeofday(&start,NULL);
+	for(int i=0;i<num;i++) sum+=FastTrigGreatCircleRoute(legs[i].lat1,legs[i].lon1,legs[i].latX,legs[i].lonX,&d)+d;
+	us[1]=elapsedUs(&start);
+	gettimeofday(&start,NULL);
+	for(int i=0;i<num;i++) sum+=calcGCCrossTrackError(legs[i].lat1,legs[i].lon1,legs[i].lon2,legs[i].latX,legs[i].lonX,legs[i].course12,&atd)+atd;
+	us[2]=elapsedUs(&start);
+	gettimeofday(&start,NULL);
+	for(int i=0;i<num;i++) sum+=FastTrigGCCrossTrackError(legs[i].lat1,legs[i].lon1,legs[i].lon2,legs[i].latX,legs[i].lonX,legs[i].course12,&atd)+atd;
+	us[3]=elapsedUs(&start);
+	sink=sum;
+	printf("calcGreatCircleRoute:  double %7.1f ns, FastTrig %7.1f ns per call\n",us[0]*1000.0/num,us[1]*1000.0/num);
+	printf("calcGCCrossTrackError: double %7.1f ns, FastTrig %7.1f ns per call\n",us[2]*1000.0/num,us[3]*1000.0/num);
+}
+
+void timeBatch(const struct benchLeg *legs, int num) { //from each actual position to all the points of the first legs
+	double lats[BATCH_POINTS], lons[BATCH_POINTS], dists[BATCH_POINTS], courses[BATCH_POINTS];
+	struct timeval start;
+	double sum=0;
+	long long us[4];
+	int points=(num<BATCH_POINTS)?num:BATCH_POINTS, rounds=num/points, different=0;
+	int *nearest=(int*)malloc(rounds*sizeof(int));
+	if(nearest==NULL) return;
+	for(int i=0;i<points;i++) {
+		lats[i]=legs[i].lat2;
+		lons[i]=legs[i].lon2;
+	}
+	gettimeofday(&start,NULL);
+	for(int r=0;r<rounds;r++) for(int i=0;i<points;i++) {
+		dists[i]=calcAngularDist(legs[r].latX,legs[r].lonX,lats[i],lons[i]);
+		courses[i]=calcGreatCircleCourse(legs[r].latX,legs[r].lonX,lats[i],lons[i]);
+		sum+=dists[i]+courses[i];
+	}
+	us[0]=elapsedUs(&start);
+	gettimeofday(&start,NULL);
+	for(int r=0;r<rounds;r++) {
+		calcAngularDistBatch(legs[r].latX,legs[r].lonX,lats,lons,dists,points);
+		calcGreatCircleCourseBatch(legs[r].latX,legs[r].lonX,lats,lons,courses,points);
+		sum+=dists[points-1]+courses[points-1];
+	}
+	us[1]=elapsedUs(&start);
+	gettimeofday(&start,NULL);
+	for(int r=0;r<rounds;r++) { //the nearest point as it was searched by NavFindNextWP
+		nearest[r]=0;
+		double shortest=calcAngularDist(legs[r].latX,legs[r].lonX,lats[0],lons[0]);
+		for(int i=1;i<points;i++) {
+			double d=calcAngularDist(legs[r].latX,legs[r].lonX,lats[i],lons[i]);
+			if(d<=shortest) {
+				shortest=d;
+				nearest[r]=i;
+			}
+		}
+	}
+	us[2]=elapsedUs(&start);
+	gettimeofday(&start,NULL);
+	for(int r=0;r<rounds;r++) if(calcNearestPoint(legs[r].latX,legs[r].lonX,lats,lons,points,NULL)!=nearest[r]) different++;
+	us[3]=elapsedUs(&start);
+	free(nearest);
+	sink=sum;
+	printf("%d positions to %d points: distance and course one by one %7.1f ns, batch %7.1f ns per point\n",rounds,points,
+			us[0]*1000.0/(rounds*points),us[1]*1000.0/(rounds*points));
+	printf("Nearest point: calcAngularDist loop %7.1f ns, calcNearestPoint %7.1f ns per point, different results %d\n",
+			us[2]*1000.0/(rounds*points),us[3]*1000.0/(rounds*points),different);
+}
+
+int main(int argc, char** argv) { //argument: [number of legs]
+	int num=(argc>1)?atoi(argv[1]):BENCH_LEGS;
+	if(num<1) num=BENCH_LEGS;
+	struct benchLeg *legs=(struct benchLeg*)malloc(num*sizeof(struct benchLeg));
+	if(legs==NULL) return EXIT_FAILURE;
+	srand(1); //always the same legs
+	for(int i=0;i<num;i++) makeLeg(&legs[i]);
+	checkPrimitives();
+	checkLegs(legs,num);
+	timeLegs(legs,num);
+	timeBatch(legs,num);
+	free(legs);
+	return EXIT_SUCCESS;
+}
@@ -3,11 +3,11 @@
 // Since       : 14/9/2011
 // Author      : Alberto Realis-Luc <alberto.realisluc@gmail.com>
 // Web         : https://www.alus.it/airnavigator/
-// Copyright   : (C) 2010-2020 Alberto Realis-Luc
+// Copyright   : (C) 2010-2026 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 28/2/2016
-// Description : Produces tracelogFiles as XML GPX files
+// Last change : 17/10/2026
+// Description : Records the track in a binary file, converted to GPX at the end
 //============================================================================
 
 
@@ -15,14 +15,42 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/time.h>
 #include "BlackBox.h"
 #include "Configuration.h"
 #include "AirCalc.h"
 
 #define MIN_DIST 0.00000109872 // 7 m in Rad
 
+// Binary track file: a header and then records all of TRACK_RECORD_SIZE bytes, little endian.
+// A key record sets date, position and time; each point record is the difference from the
+// previous point, so the values are stored with the same precision written in the GPX.
+// The file is only appended: each group of records written together ends with a commit record
+// with their CRC32, so after a power loss the track can be recovered until the last valid group.
+#define TRACK_MAGIC        "ANTK"
+#define TRACK_VERSION      1
+#define TRACK_HEADER_SIZE  80
+#define TRACK_INFO_SIZE    32   //model and serial number of the device in the header
+#define TRACK_RECORD_SIZE  16
+#define REC_KEY            0x01 //day, month, year-1900, lat, lon (micro degrees) and milliseconds since midnight
+#define REC_POINT          0x02 //dlat, dlon, dms (16 bit), altitude dm (32 bit), speed cm/s, course centi degrees (16 bit)
+#define REC_COMMIT         0x03 //number of records of the group (16 bit), group sequence number, CRC32 of the group and of the first 8 bytes of the commit
+#define REC_TYPE_MASK      0x0F
+#define REC_ALT            0x10 //the optional values present in the point
+#define REC_SPEED          0x20
+#define REC_COURSE         0x40
+
+#define TRACK_RING_SIZE    256  //track points that can wait to be written
+#define TRACK_HIGH_WATER   (TRACK_RING_SIZE*3/4) //points that make the writer write before the sync interval
+#define TRACK_GROUP_MAX    (2*TRACK_RING_SIZE+1) //records in a group: two per point in the worst case and the commit
+
 enum blackBoxStatus {
 	BBS_NOT_SET,
 	BBS_WAIT_FIX,
@@ -31,34 +59,79 @@ enum blackBoxStatus {
 	BBS_PAUSED
 };
 
+struct trackPoint { //values already rounded as they are written in the GPX
+	int lat,lon;           //micro degrees, East longitudes positive
+	int year,month,day;
+	long ms;               //milliseconds since midnight
+	int alt;               //dm
+	unsigned short speed;  //cm/s
+	unsigned short course; //centi degrees
+	unsigned char flags;   //which of the optional values are present
+};
+
 struct BlackBoxStruct {
-	double lastlat, lastlon, minlat, minlon, maxlat, maxlon;
+	double lastlat, lastlon;
 	float currTimestamp,lastTimestamp;
 	double updateDist; //here in rad
 	int cyear,cmonth,cday,chour,cmin,csec; //creation time of the track file
 	char *filename;
+	char *trackPath;                       //binary track file, the GPX is made from it when closing
 	long trackPointCounter;
-	FILE *tracklogFile;
+	int trackFile;
 	enum blackBoxStatus status;
+	struct trackPoint current;             //point being recorded: written when committed
+	pthread_t writer;
+	volatile bool writerRunning;
+	pthread_mutex_t mutex;                 //protects the ring and the flush request
+	pthread_cond_t signal;                 //signaled when a batch is ready, a flush is requested or when closing
+	struct trackPoint ring[TRACK_RING_SIZE];
+	int head,count;                        //next point to be written by the writer and points waiting
+	bool flushRequested;
+	unsigned long lostPoints;              //points dropped because the ring was full
+	struct trackPoint previous;            //last point encoded by the writer
+	bool havePrevious;
+	long groups;                           //groups committed in the file
+	unsigned char buffer[TRACK_GROUP_MAX*TRACK_RECORD_SIZE]; //records to be written
+};
+
+struct gpxTrack { //state of the conversion of a track file
+	FILE *gpx;
+	struct trackPoint point;               //last point decoded
+	bool haveKey;
+	long points;
+	double minlat, minlon, maxlat, maxlon;
 };
 
 bool openRecordingFile(void);
 void recordPos(double lat, double lon, float timestamp, int year, int month, int day, int hour, int min, float sec);
+void pushPoint(const struct trackPoint *point);
+void* writerLoop(void *ptr);
+int encodePoint(const struct trackPoint *point, unsigned char *rec);
+int commitGroup(unsigned char *group, int len);
+unsigned int crc32(const unsigned char *buf, size_t len);
+void putShort(unsigned char *buf, int value);
+void putLong(unsigned char *buf, long value);
+int getShort(const unsigned char *buf);
+long getLong(const unsigned char *buf);
+bool writeAll(int fd, const unsigned char *buf, size_t len);
+void writeGPXheader(FILE *gpx, const unsigned char *header);
+void writeGPXpoint(FILE *gpx, const struct trackPoint *p);
+void decodeRecord(const unsigned char *rec, struct gpxTrack *track);
 
 static struct BlackBoxStruct BlackBox = {
 	.filename=NULL,
-	.tracklogFile=NULL,
-	.status=BBS_NOT_SET
+	.trackPath=NULL,
+	.trackFile=-1,
+	.status=BBS_NOT_SET,
+	.writerRunning=false,
+	.mutex=PTHREAD_MUTEX_INITIALIZER,
+	.signal=PTHREAD_COND_INITIALIZER
 };
 
 void BlackBoxStart(void) {
 	if(BlackBox.status!=BBS_NOT_SET) return;
 	BlackBox.lastTimestamp=-config.recordTimeInterval;
 	BlackBox.trackPointCounter=0;
-	BlackBox.minlat=90;
-	BlackBox.minlon=180;
-	BlackBox.maxlat=-90;
-	BlackBox.maxlon=-180;
 	BlackBox.updateDist=m2Rad(config.recordMinDist);
 	if(BlackBox.updateDist<MIN_DIST) BlackBox.updateDist=MIN_DIST;
 	struct tm time_str;
@@ -70,29 +143,49 @@ void BlackBoxStart(void) {
 	BlackBox.chour=time_str.tm_hour; //hour
 	BlackBox.cmin=time_str.tm_min; //minute
 	BlackBox.csec=time_str.tm_sec;
-	asprintf(&BlackBox.filename,"Track_%d-%02d-%02d_%02d-%02d-%02d.gpx",BlackBox.cyear,BlackBox.cmonth,BlackBox.cday,BlackBox.chour,BlackBox.cmin,BlackBox.csec);
+	asprintf(&BlackBox.filename,"Track_%d-%02d-%02d_%02d-%02d-%02d",BlackBox.cyear,BlackBox.cmonth,BlackBox.cday,BlackBox.chour,BlackBox.cmin,BlackBox.csec);
 	BlackBox.status=BBS_WAIT_FIX;
 }
 
 bool openRecordingFile(void) {
-	char *path;
-	asprintf(&path,"%sTracks/%s",BASE_PATH,BlackBox.filename);
-	BlackBox.tracklogFile=fopen(path,"w");
-	free(path);
-	if(BlackBox.tracklogFile==NULL) {
+	unsigned char header[TRACK_HEADER_SIZE];
+	asprintf(&BlackBox.trackPath,"%sTracks/%s.trk",BASE_PATH,BlackBox.filename);
+	BlackBox.trackFile=open(BlackBox.trackPath,O_WRONLY|O_CREAT|O_TRUNC|O_APPEND,0644);
+	if(BlackBox.trackFile<0) {
 		printLog("BlackBox ERROR: Unable to write track file.\n");
 		BlackBoxClose();
 		return false;
 	}
-	fprintf(BlackBox.tracklogFile,"<?xml version=\"1.0\" encoding=\"ISO-8859-1\" standalone=\"yes\"?>\n"
-			"<gpx version=\"1.1\" creator=\"AirNavigator by Alus.it\"\n"
-			"xmlns=\"http://www.topografix.com/GPX/1/1\"\n"
-			"xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\"\n"
-			"xsi:schemaLocation=\"http://www.topografix.com/GPX/1/1 http://www.topografix.com/GPX/1/1/gpx.xsd\">\n"
-			"<trk>\n"
-			"<name>Track created on %d/%02d/%4d at %2d:%02d:%02d</name>\n"
-			"<src>%s - Device serial number ID: %s</src>\n"
-			"<trkseg>\n",BlackBox.cday,BlackBox.cmonth,BlackBox.cyear,BlackBox.chour,BlackBox.cmin,BlackBox.csec,config.tomtomModel,config.serialNumber);
+	memset(header,0,TRACK_HEADER_SIZE);
+	memcpy(header,TRACK_MAGIC,4);
+	header[4]=TRACK_VERSION;
+	header[5]=TRACK_RECORD_SIZE;
+	putShort(&header[6],BlackBox.cyear);
+	header[8]=BlackBox.cmonth;
+	header[9]=BlackBox.cday;
+	header[10]=BlackBox.chour;
+	header[11]=BlackBox.cmin;
+	header[12]=BlackBox.csec;
+	if(config.tomtomModel!=NULL) strncpy((char*)&header[16],config.tomtomModel,TRACK_INFO_SIZE-1);
+	if(config.serialNumber!=NULL) strncpy((char*)&header[16+TRACK_INFO_SIZE],config.serialNumber,TRACK_INFO_SIZE-1);
+	if(!writeAll(BlackBox.trackFile,header,TRACK_HEADER_SIZE)) {
+		printLog("BlackBox ERROR: Unable to write track file.\n");
+		BlackBoxClose();
+		return false;
+	}
+	BlackBox.head=0;
+	BlackBox.count=0;
+	BlackBox.flushRequested=false;
+	BlackBox.lostPoints=0;
+	BlackBox.havePrevious=false;
+	BlackBox.groups=0;
+	BlackBox.writerRunning=true;
+	if(pthread_create(&BlackBox.writer,NULL,writerLoop,(void*)NULL)) {
+		BlackBox.writerRunning=false;
+		printLog("BlackBox ERROR: unable to create the writer thread.\n");
+		BlackBoxClose();
+		return false;
+	}
 	BlackBox.status=BBS_WAIT_POS;
 	return true;
 }
@@ -100,10 +193,14 @@ bool openRecordingFile(void) {
 void BlackBoxPause(void) {
 	if(BlackBox.status==BBS_WAIT_OPT) BlackBoxCommit();
 	BlackBox.status=BBS_PAUSED;
+	pthread_mutex_lock(&BlackBox.mutex); //write now what has been recorded until here
+	BlackBox.flushRequested=true;
+	pthread_cond_signal(&BlackBox.signal);
+	pthread_mutex_unlock(&BlackBox.mutex);
 }
 
 void BlackBoxResume(void) {
-	if(BlackBox.status==BBS_PAUSED && BlackBox.tracklogFile!=NULL) BlackBox.status=BBS_WAIT_POS;
+	if(BlackBox.status==BBS_PAUSED && BlackBox.trackFile>=0) BlackBox.status=BBS_WAIT_POS;
 }
 
 bool BlackBoxIsStarted(void) {
@@ -119,14 +216,13 @@ void recordPos(double lat, double lon, float timestamp, int year, int month, int
 	BlackBox.lastlat=lat;
 	BlackBox.lastlon=lon;
 	BlackBox.lastTimestamp=timestamp;
-	lat=Rad2Deg(lat);
-	lon=-Rad2Deg(lon); //For the GPX standard East longitudes are positive
-	if(lat<BlackBox.minlat) BlackBox.minlat=lat;
-	if(lon<BlackBox.minlon) BlackBox.minlon=lon;
-	if(lat>BlackBox.maxlat) BlackBox.maxlat=lat;
-	if(lon>BlackBox.maxlon) BlackBox.maxlon=lon;
-	fprintf(BlackBox.tracklogFile,"<trkpt lat=\"%f\" lon=\"%f\">\n"
-			"<time>%d-%02d-%02dT%02d:%02d:%06.3fZ</time>\n",lat,lon,year,month,day,hour,min,sec);
+	BlackBox.current.lat=(int)floor(Rad2Deg(lat)*1000000+0.5);
+	BlackBox.current.lon=(int)floor(-Rad2Deg(lon)*1000000+0.5); //For the GPX standard East longitudes are positive
+	BlackBox.current.year=year;
+	BlackBox.current.month=month;
+	BlackBox.current.day=day;
+	BlackBox.current.ms=(hour*3600L+min*60L)*1000+(long)floor(sec*1000+0.5);
+	BlackBox.current.flags=0;
 	BlackBox.status=BBS_WAIT_OPT;
 }
 
@@ -166,53 +262,331 @@ bool BlackBoxRecordPos(double lat, double lon, float timestamp, int hour, int mi
 
 bool BlackBoxRecordAlt(double alt) {
 	if(BlackBox.status!=BBS_WAIT_OPT) return false;
-	fprintf(BlackBox.tracklogFile,"<ele>%.1f</ele>\n",alt);
+	BlackBox.current.alt=(int)floor(alt*10+0.5);
+	BlackBox.current.flags|=REC_ALT;
 	return true;
 }
 
 bool BlackBoxRecordSpeed(double speed) { //Speed in m/s
 	if(BlackBox.status!=BBS_WAIT_OPT) return false;
-	fprintf(BlackBox.tracklogFile,"<speed>%.2f</speed>\n",speed);
+	long cms=(long)floor(speed*100+0.5);
+	BlackBox.current.speed=(cms<0)?0:(cms>65535)?65535:cms;
+	BlackBox.current.flags|=REC_SPEED;
 	return true;
 }
 
 bool BlackBoxRecordCourse(double course) {
 	if(BlackBox.status!=BBS_WAIT_OPT) return false;
-	fprintf(BlackBox.tracklogFile,"<course>%.2f</course>\n",course);
+	long centiDeg=(long)floor(course*100+0.5);
+	BlackBox.current.course=(centiDeg<0)?0:(centiDeg>65535)?65535:centiDeg;
+	BlackBox.current.flags|=REC_COURSE;
 	return true;
 }
 
 bool BlackBoxCommit(void) {
 	if(BlackBox.status!=BBS_WAIT_OPT) return false;
-	fprintf(BlackBox.tracklogFile,"</trkpt>\n");
+	pushPoint(&BlackBox.current);
 	BlackBox.status=BBS_WAIT_POS;
 	return true;
 }
 
+void pushPoint(const struct trackPoint *point) { //called by the GPS thread: the file is written by the writer thread
+	pthread_mutex_lock(&BlackBox.mutex);
+	if(BlackBox.count<TRACK_RING_SIZE) {
+		BlackBox.ring[(BlackBox.head+BlackBox.count)%TRACK_RING_SIZE]=*point;
+		BlackBox.count++;
+		if(BlackBox.count==TRACK_HIGH_WATER) pthread_cond_signal(&BlackBox.signal);
+	} else BlackBox.lostPoints++; //the SD is not keeping up: better to lose a point than to block the GPS thread
+	pthread_mutex_unlock(&BlackBox.mutex);
+}
+
+void putShort(unsigned char *buf, int value) {
+	buf[0]=value&0xFF;
+	buf[1]=(value>>8)&0xFF;
+}
+
+void putLong(unsigned char *buf, long value) {
+	buf[0]=value&0xFF;
+	buf[1]=(value>>8)&0xFF;
+	buf[2]=(value>>16)&0xFF;
+	buf[3]=(value>>24)&0xFF;
+}
+
+int getShort(const unsigned char *buf) {
+	return (short)(buf[0]|(buf[1]<<8));
+}
+
+long getLong(const unsigned char *buf) {
+	return (long)(int)(buf[0]|(buf[1]<<8)|(buf[2]<<16)|((unsigned)buf[3]<<24));
+}
+
+int encodePoint(const struct trackPoint *point, unsigned char *rec) { //returns the number of bytes of the records
+	int len=0;
+	struct trackPoint *prev=&BlackBox.previous;
+	long dlat=point->lat-prev->lat, dlon=point->lon-prev->lon, dms=point->ms-prev->ms;
+	if(!BlackBox.havePrevious || point->day!=prev->day || point->month!=prev->month || point->year!=prev->year ||
+			dlat<-32768 || dlat>32767 || dlon<-32768 || dlon>32767 || dms<0 || dms>65535) { //the difference does not fit: new key
+		memset(rec,0,TRACK_RECORD_SIZE);
+		rec[0]=REC_KEY;
+		rec[1]=point->day;
+		rec[2]=point->month;
+		rec[3]=point->year-1900;
+		putLong(&rec[4],point->lat);
+		putLong(&rec[8],point->lon);
+		putLong(&rec[12],point->ms);
+		len=TRACK_RECORD_SIZE;
+		dlat=dlon=dms=0;
+		BlackBox.havePrevious=true;
+	}
+	unsigned char *r=rec+len;
+	r[0]=REC_POINT|point->flags;
+	r[1]=0;
+	putShort(&r[2],dlat);
+	putShort(&r[4],dlon);
+	putShort(&r[6],dms);
+	putLong(&r[8],(point->flags&REC_ALT)?point->alt:0);
+	putShort(&r[12],(point->flags&REC_SPEED)?point->speed:0);
+	putShort(&r[14],(point->flags&REC_COURSE)?point->course:0);
+	*prev=*point;
+	return len+TRACK_RECORD_SIZE;
+}
+
+bool writeAll(int fd, const unsigned char *buf, size_t len) {
+	while(len>0) {
+		ssize_t written=write(fd,buf,len);
+		if(written<0) return false;
+		buf+=written;
+		len-=written;
+	}
+	return true;
+}
+
+unsigned int crc32(const unsigned char *buf, size_t len) {
+	unsigned int crc=0xFFFFFFFF;
+	while(len-->0) {
+		crc^=*buf++;
+		for(int i=0;i<8;i++) crc=(crc>>1)^(0xEDB88320&(0-(crc&1)));
+	}
+	return ~crc;
+}
+
+int commitGroup(unsigned char *group, int len) { //adds the commit record after the len bytes of the group and returns its size
+	unsigned char *rec=group+len;
+	memset(rec,0,TRACK_RECORD_SIZE);
+	rec[0]=REC_COMMIT;
+	putShort(&rec[2],len/TRACK_RECORD_SIZE);
+	putLong(&rec[4],BlackBox.groups++);
+	putLong(&rec[8],crc32(group,len+8));
+	return TRACK_RECORD_SIZE;
+}
+
+void* writerLoop(void *ptr) { //group commit: one write and one fdatasync for all the points waiting, it will be ran in a separate thread
+	struct timespec deadline;
+	struct timeval now;
+	bool running=true;
+	long syncUs=(long)(config.recordSyncInterval*1000000);
+	if(syncUs<1000000) syncUs=1000000;
+	while(running) {
+		gettimeofday(&now,NULL);
+		long us=now.tv_usec+syncUs%1000000;
+		deadline.tv_sec=now.tv_sec+syncUs/1000000+us/1000000;
+		deadline.tv_nsec=(us%1000000)*1000;
+		pthread_mutex_lock(&BlackBox.mutex);
+		while(BlackBox.writerRunning && BlackBox.count<TRACK_HIGH_WATER && !BlackBox.flushRequested)
+			if(pthread_cond_timedwait(&BlackBox.signal,&BlackBox.mutex,&deadline)!=0) break; //sync interval elapsed: write what there is
+		running=BlackBox.writerRunning;
+		BlackBox.flushRequested=false;
+		int len=0;
+		for(;BlackBox.count>0;BlackBox.count--) { //encode here: the GPS thread waits at most for this
+			len+=encodePoint(&BlackBox.ring[BlackBox.head],BlackBox.buffer+len);
+			BlackBox.head=(BlackBox.head+1)%TRACK_RING_SIZE;
+		}
+		pthread_mutex_unlock(&BlackBox.mutex);
+		if(len>0) {
+			len+=commitGroup(BlackBox.buffer,len);
+			if(!writeAll(BlackBox.trackFile,BlackBox.buffer,len)) printLog("BlackBox ERROR: Unable to write the track points.\n");
+			fdatasync(BlackBox.trackFile);
+		}
+	}
+	pthread_exit(NULL);
+	return NULL;
+}
+
+void writeGPXheader(FILE *gpx, const unsigned char *header) {
+	fprintf(gpx,"<?xml version=\"1.0\" encoding=\"ISO-8859-1\" standalone=\"yes\"?>\n"
+			"<gpx version=\"1.1\" creator=\"AirNavigator by Alus.it\"\n"
+			"xmlns=\"http://www.topografix.com/GPX/1/1\"\n"
+			"xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\"\n"
+			"xsi:schemaLocation=\"http://www.topografix.com/GPX/1/1 http://www.topografix.com/GPX/1/1/gpx.xsd\">\n"
+			"<trk>\n"
+			"<name>Track created on %d/%02d/%4d at %2d:%02d:%02d</name>\n"
+			"<src>%.31s - Device serial number ID: %.31s</src>\n"
+			"<trkseg>\n",header[9],header[8],getShort(&header[6]),header[10],header[11],header[12],(const char*)&header[16],(const char*)&header[16+TRACK_INFO_SIZE]);
+}
+
+void writeGPXpoint(FILE *gpx, const struct trackPoint *p) {
+	fprintf(gpx,"<trkpt lat=\"%f\" lon=\"%f\">\n"
+			"<time>%d-%02d-%02dT%02ld:%02ld:%06.3fZ</time>\n",p->lat/1000000.0,p->lon/1000000.0,p->year,p->month,p->day,
+			p->ms/3600000,(p->ms/60000)%60,(p->ms%60000)/1000.0);
+	if(p->flags&REC_ALT) fprintf(gpx,"<ele>%.1f</ele>\n",p->alt/10.0);
+	if(p->flags&REC_SPEED) fprintf(gpx,"<speed>%.2f</speed>\n",p->speed/100.0);
+	if(p->flags&REC_COURSE) fprintf(gpx,"<course>%.2f</course>\n",p->course/100.0);
+	fprintf(gpx,"</trkpt>\n");
+}
+
+void decodeRecord(const unsigned char *rec, struct gpxTrack *track) {
+	struct trackPoint *p=&track->point;
+	switch(rec[0]&REC_TYPE_MASK) {
+		case REC_KEY:
+			p->day=rec[1];
+			p->month=rec[2];
+			p->year=rec[3]+1900;
+			p->lat=getLong(&rec[4]);
+			p->lon=getLong(&rec[8]);
+			p->ms=getLong(&rec[12]);
+			track->haveKey=true;
+			break;
+		case REC_POINT:
+			if(!track->haveKey) break; //no point can be before the first key
+			p->lat+=getShort(&rec[2]);
+			p->lon+=getShort(&rec[4]);
+			p->ms+=(unsigned short)getShort(&rec[6]);
+			p->flags=rec[0]&~REC_TYPE_MASK;
+			p->alt=getLong(&rec[8]);
+			p->speed=getShort(&rec[12]);
+			p->course=getShort(&rec[14]);
+			writeGPXpoint(track->gpx,p);
+			track->points++;
+			if(p->lat/1000000.0<track->minlat) track->minlat=p->lat/1000000.0;
+			if(p->lon/1000000.0<track->minlon) track->minlon=p->lon/1000000.0;
+			if(p->lat/1000000.0>track->maxlat) track->maxlat=p->lat/1000000.0;
+			if(p->lon/1000000.0>track->maxlon) track->maxlon=p->lon/1000000.0;
+			break;
+	}
+}
+
+bool BlackBoxConvert(const char *trackPath) { //makes the GPX file from the binary track file, with the same name
+	unsigned char header[TRACK_HEADER_SIZE];
+	struct gpxTrack track;
+	FILE *trk=fopen(trackPath,"rb");
+	if(trk==NULL) {
+		printLog("BlackBox ERROR: Unable to read track file %s.\n",trackPath);
+		return false;
+	}
+	if(fread(header,TRACK_HEADER_SIZE,1,trk)!=1 || memcmp(header,TRACK_MAGIC,4)!=0 || header[4]!=TRACK_VERSION || header[5]!=TRACK_RECORD_SIZE) {
+		printLog("BlackBox ERROR: %s is not a track file.\n",trackPath);
+		fclose(trk);
+		return false;
+	}
+	header[16+TRACK_INFO_SIZE-1]=0; //strings always terminated
+	header[16+2*TRACK_INFO_SIZE-1]=0;
+	unsigned char *group=(unsigned char*)malloc(TRACK_GROUP_MAX*TRACK_RECORD_SIZE);
+	if(group==NULL) {
+		printLog("BlackBox ERROR: not enough memory to convert %s.\n",trackPath);
+		fclose(trk);
+		return false;
+	}
+	char *gpxPath=strdup(trackPath);
+	char *ext=strrchr(gpxPath,'.');
+	if(ext!=NULL && strcmp(ext,".trk")==0) strcpy(ext,".gpx");
+	else {
+		free(gpxPath);
+		asprintf(&gpxPath,"%s.gpx",trackPath);
+	}
+	track.gpx=fopen(gpxPath,"w");
+	if(track.gpx==NULL) {
+		printLog("BlackBox ERROR: Unable to write track file %s.\n",gpxPath);
+		free(gpxPath);
+		free(group);
+		fclose(trk);
+		return false;
+	}
+	writeGPXheader(track.gpx,header);
+	memset(&track.point,0,sizeof(track.point));
+	track.haveKey=false;
+	track.points=0;
+	track.minlat=90;
+	track.minlon=180;
+	track.maxlat=-90;
+	track.maxlon=-180;
+	int numRecords=0;
+	bool damaged=false;
+	while(!damaged && fread(group+numRecords*TRACK_RECORD_SIZE,TRACK_RECORD_SIZE,1,trk)==1) { //only the groups with a valid commit are converted
+		unsigned char *rec=group+numRecords*TRACK_RECORD_SIZE;
+		if((rec[0]&REC_TYPE_MASK)==REC_COMMIT) {
+			if((unsigned short)getShort(&rec[2])!=numRecords || crc32(group,numRecords*TRACK_RECORD_SIZE+8)!=(unsigned int)getLong(&rec[8])) damaged=true;
+			else {
+				for(int i=0;i<numRecords;i++) decodeRecord(group+i*TRACK_RECORD_SIZE,&track);
+				numRecords=0;
+			}
+		} else if(++numRecords==TRACK_GROUP_MAX) damaged=true; //too long to be a group
+	}
+	fclose(trk);
+	free(group);
+	if(damaged || numRecords>0) printLog("BlackBox: %s was not closed, recovered %ld track points.\n",trackPath,track.points);
+	char *name=strrchr(gpxPath,'/');
+	name=(name!=NULL)?name+1:gpxPath;
+	fprintf(track.gpx,"</trkseg>\n"
+			"<number>%ld</number>\n"
+			"</trk>\n"
+			"<metadata>\n"
+			"<name>%s</name>\n"
+			"<desc>Track file recorded by AirNavigator</desc>\n"
+			"<author>\n"
+			"<name>AirNavigator by Alus</name>\n"
+			"<email id=\"airnavigator\" domain=\"alus.it\"/>\n"
+			"</author>\n"
+			"<link href=\"http://www.alus.it/airnavigator\">\n"
+			"<text>AirNavigator website</text>\n"
+			"</link>\n"
+			"<time>%d-%02d-%02dT%02d:%02d:%02dZ</time>\n"
+			"<bounds minlat=\"%f\" minlon=\"%f\" maxlat=\"%f\" maxlon=\"%f\"/>\n"
+			"</metadata>\n"
+			"</gpx>",track.points,name,getShort(&header[6]),header[8],header[9],header[10],header[11],header[12],track.minlat,track.minlon,track.maxlat,track.maxlon);
+	bool ok=(fclose(track.gpx)==0);
+	if(!ok) printLog("BlackBox ERROR: Unable to write track file %s.\n",gpxPath);
+	free(gpxPath);
+	return ok;
+}
+
+void BlackBoxRecover(void) { //converts the track files left by a power loss, to be called before starting to record
+	struct dirent *entry;
+	char *tracksPath;
+	asprintf(&tracksPath,"%sTracks",BASE_PATH);
+	DIR *dir=opendir(tracksPath);
+	if(dir!=NULL) {
+		while((entry=readdir(dir))!=NULL) {
+			int len=strlen(entry->d_name);
+			if(len>4 && strcmp(&entry->d_name[len-4],".trk")==0) {
+				char *path;
+				asprintf(&path,"%s/%s",tracksPath,entry->d_name);
+				if(BlackBoxConvert(path)) unlink(path);
+				free(path);
+			}
+		}
+		closedir(dir);
+	}
+	free(tracksPath);
+}
+
 void BlackBoxClose(void) {
 	BlackBoxCommit();
 	BlackBox.status=BBS_NOT_SET;
-	if(BlackBox.tracklogFile!=NULL) {
-		fprintf(BlackBox.tracklogFile,"</trkseg>\n"
-				"<number>%ld</number>\n"
-				"</trk>\n"
-				"<metadata>\n"
-				"<name>%s</name>\n"
-				"<desc>Track file recorded by AirNavigator</desc>\n"
-				"<author>\n"
-				"<name>AirNavigator by Alus</name>\n"
-				"<email id=\"airnavigator\" domain=\"alus.it\"/>\n"
-				"</author>\n"
-				"<link href=\"http://www.alus.it/airnavigator\">\n"
-				"<text>AirNavigator website</text>\n"
-				"</link>\n"
-				"<time>%d-%02d-%02dT%02d:%02d:%02dZ</time>\n"
-				"<bounds minlat=\"%f\" minlon=\"%f\" maxlat=\"%f\" maxlon=\"%f\"/>\n"
-				"</metadata>\n"
-				"</gpx>",BlackBox.trackPointCounter,BlackBox.filename,BlackBox.cyear,BlackBox.cmonth,BlackBox.cday,BlackBox.chour,BlackBox.cmin,BlackBox.csec,BlackBox.minlat,BlackBox.minlon,BlackBox.maxlat,BlackBox.maxlon);
-		fclose(BlackBox.tracklogFile);
+	if(BlackBox.writerRunning) {
+		pthread_mutex_lock(&BlackBox.mutex);
+		BlackBox.writerRunning=false;
+		pthread_cond_signal(&BlackBox.signal);
+		pthread_mutex_unlock(&BlackBox.mutex);
+		pthread_join(BlackBox.writer,NULL); //it writes all the points still in the ring before ending
+		if(BlackBox.lostPoints>0) printLog("BlackBox: %lu track points lost.\n",BlackBox.lostPoints);
 	}
+	if(BlackBox.trackFile>=0) {
+		close(BlackBox.trackFile);
+		BlackBox.trackFile=-1;
+		if(BlackBoxConvert(BlackBox.trackPath)) unlink(BlackBox.trackPath); //the binary file is kept only if the GPX has not been made
+	}
+	free(BlackBox.trackPath);
+	BlackBox.trackPath=NULL;
 	free(BlackBox.filename);
 	BlackBox.filename=NULL;
 }
-
@@ -6,8 +6,8 @@
 // Copyright   : (C) 2010-2020 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 8/12/2013
-// Description : Produces tracelogFiles as XML GPX files
+// Last change : 17/10/2026
+// Description : Records the track in a binary file, converted to GPX at the end
 //============================================================================
 
 #ifndef BLACKBOX_H_
@@ -26,5 +26,7 @@ void BlackBoxPause(void);
 bool BlackBoxIsPaused(void);
 void BlackBoxResume(void);
 void BlackBoxClose(void);
+bool BlackBoxConvert(const char *trackPath);
+void BlackBoxRecover(void);
 
 #endif /* BLACKBOX_H_ */
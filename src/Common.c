@@ -6,7 +6,7 @@
 // Copyright   : (C) 2010-2020 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 23/11/2013
+// Last change : 17/10/2026
 // Description : Common functions of AirNavigator
 //============================================================================
 
@@ -61,3 +61,9 @@ float getCurrentTime(void) {
 	timeVal+=n;
 	return timeVal;
 }
+
+long long elapsedUs(const struct timeval *since) { //microseconds passed since the given time, long would overflow after 35 minutes
+	struct timeval now;
+	gettimeofday(&now,NULL);
+	return (long long)(now.tv_sec-since->tv_sec)*1000000+(now.tv_usec-since->tv_usec);
+}
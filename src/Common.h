@@ -6,19 +6,27 @@
 // Copyright   : (C) 2010-2020 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 8/12/2013
+// Last change : 17/10/2026
 // Description : Common definitions of AirNavigator
 //============================================================================
 
 #ifndef COMMON_H_
 #define COMMON_H_
 
+#include <sys/time.h>
+
 #define BASE_PATH "/mnt/sdcard/AirNavigator/"
 
 typedef char bool;
 
 enum boolean { false, true };
 
+#if defined(__GNUC__) && (__GNUC__>4 || (__GNUC__==4 && __GNUC_MINOR__>=1))
+#define MEMORY_BARRIER() __sync_synchronize()
+#else //the ARM920T is uniprocessor: it is enough to stop the compiler from reordering memory accesses
+#define MEMORY_BARRIER() __asm__ __volatile__("":::"memory")
+#endif
+
 enum mainStatus {
 	MAIN_NOT_INIT,
 	MAIN_DISPLAY_MENU,
@@ -31,6 +39,7 @@ bool openLog(void);
 int printLog(const char *texts, ...);
 void closeLog(void);
 float getCurrentTime(void);
+long long elapsedUs(const struct timeval *since);
 enum mainStatus getMainStatus(void);
 
 #endif
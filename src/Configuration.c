@@ -6,7 +6,7 @@
 // Copyright   : (C) 2010-2020 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 21/3/2016
+// Last change : 17/10/2026
 // Description : Implementation of Config with the shared config data struct
 //============================================================================
 
@@ -34,11 +34,18 @@ struct configuration config = { //Default configuration values
 	.timeZone=1, //+1 hour for most of Europe
 	.recordTimeInterval=5, //sec
 	.recordMinDist=10, //meters
+	.recordSyncInterval=10, //sec
 	.GPSdevName=NULL,
 	.GPSbaudRate=115200,
 	.GPSdataBits=8,
 	.GPSstopBits=1,
 	.GPSparity=0,
+	.GPSlowLatency=0,
+	.GPSubxRate=0,
+	.GPSstaleTimeout=3, //sec
+	.GPSreconnectTimeout=10, //sec
+	.GPSreplayFile=NULL,
+	.GPSreplaySpeed=1,
 	.tomtomModel=NULL,
 	.serialNumber=NULL,
 	.colorSchema = {       //Default colors
@@ -74,9 +81,9 @@ void loadConfig(void) { //Load configuration
 		node_t *part,*detail,*attr;
 		char* text=roxml_get_name(root,NULL,0);
 		if(strcmp(text,"AirNavigatorConfig")==0) {
-			part=roxml_get_chld(root,"aircraft",0);
+			part=roxml_get_first_chld(root,"aircraft");
 			if(part!=NULL) {
-				detail=roxml_get_chld(part,"speeds",0);
+				detail=roxml_get_first_chld(part,"speeds");
 				if(detail!=NULL) {
 					attr=roxml_get_attr(detail,"cruise",0);
 					if(attr!=NULL) {
@@ -89,7 +96,7 @@ void loadConfig(void) { //Load configuration
 						config.stallSpeed=atof(text);
 					}
 				} else printLog("WARNING: no speeds configuration found, using default values.\n");
-				detail=roxml_get_chld(part,"fuel",0);
+				detail=roxml_get_first_chld(part,"fuel");
 				if(detail!=NULL) {
 					attr=roxml_get_attr(detail,"consumption",0);
 					if(attr!=NULL) {
@@ -98,9 +105,9 @@ void loadConfig(void) { //Load configuration
 					}
 				} else printLog("WARNING: no fuel configuration found, using default values.\n");
 			} else printLog("WARNING: no aircraft configuration found, using default values.\n");
-			part=roxml_get_chld(root,"measureUnits",0);
+			part=roxml_get_first_chld(root,"measureUnits");
 			if(part!=NULL) {
-				detail=roxml_get_chld(part,"speeds",0);
+				detail=roxml_get_first_chld(part,"speeds");
 				if(detail!=NULL) {
 					attr=roxml_get_attr(detail,"horizontal",0);
 					if(attr!=NULL) {
@@ -118,7 +125,7 @@ void loadConfig(void) { //Load configuration
 							else printLog("WARNING: Vertical speed measure unit not recognized, using the default one.\n");
 					}
 				} else printLog("WARNING: no speeds measure units configuration found, using default values.\n");
-				detail=roxml_get_chld(part,"distances",0);
+				detail=roxml_get_first_chld(part,"distances");
 				if(detail!=NULL) {
 					attr=roxml_get_attr(detail,"distance",0);
 					if(attr!=NULL) {
@@ -138,9 +145,9 @@ void loadConfig(void) { //Load configuration
 					}
 				} else printLog("WARNING: no distances measure units configuration found, using default values.\n");
 			} else printLog("WARNING: no speeds and distances measure units configuration found, using default values.\n");
-			part=roxml_get_chld(root,"navigator",0);
+			part=roxml_get_first_chld(root,"navigator");
 			if(part!=NULL) {
-				detail=roxml_get_chld(part,"takeOff",0);
+				detail=roxml_get_first_chld(part,"takeOff");
 				if(detail!=NULL) {
 					attr=roxml_get_attr(detail,"diffAlt",0);
 					if(attr!=NULL) {
@@ -148,7 +155,7 @@ void loadConfig(void) { //Load configuration
 						config.takeOffdiffAlt=atof(text);
 					}
 				} else printLog("WARNING: take off configuration found, using default values.\n");
-				detail=roxml_get_chld(part,"navParameters",0);
+				detail=roxml_get_first_chld(part,"navParameters");
 				if(detail!=NULL) {
 					attr=roxml_get_attr(detail,"trackErrorTolearnce",0);
 					if(attr!=NULL) {
@@ -161,7 +168,7 @@ void loadConfig(void) { //Load configuration
 						config.deptDistTolerance=atof(text);
 					}
 				} else printLog("WARNING: no navigation parameters found, using default values.\n");
-				detail=roxml_get_chld(part,"sunZenith",0);
+				detail=roxml_get_first_chld(part,"sunZenith");
 				if(detail!=NULL) {
 					attr=roxml_get_attr(detail,"angle",0);
 					if(attr!=NULL) {
@@ -169,7 +176,7 @@ void loadConfig(void) { //Load configuration
 						config.sunZenith=Deg2Rad(atof(text)); //rad
 					}
 				} else printLog("WARNING: no sun zenith found, using default value.\n");
-				detail=roxml_get_chld(part,"timeZone",0);
+				detail=roxml_get_first_chld(part,"timeZone");
 				if(detail!=NULL) {
 					attr=roxml_get_attr(detail,"timeOffsetHours",0);
 					if(attr!=NULL) {
@@ -178,9 +185,9 @@ void loadConfig(void) { //Load configuration
 					}
 				} else printLog("WARNING: no time zone found, using default value.\n");
 			} else printLog("WARNING: no navigator configuration found, using default values.\n");
-			part=roxml_get_chld(root,"trackRecorder",0);
+			part=roxml_get_first_chld(root,"trackRecorder");
 			if(part!=NULL) {
-				detail=roxml_get_chld(part,"update",0);
+				detail=roxml_get_first_chld(part,"update");
 				if(detail!=NULL) {
 					attr=roxml_get_attr(detail,"timeInterval",0);
 					if(attr!=NULL) {
@@ -192,11 +199,16 @@ void loadConfig(void) { //Load configuration
 						text=roxml_get_content(attr,NULL,0,NULL);
 						config.recordMinDist=atof(text);
 					}
+					attr=roxml_get_attr(detail,"syncInterval",0);
+					if(attr!=NULL) {
+						text=roxml_get_content(attr,NULL,0,NULL);
+						config.recordSyncInterval=atof(text);
+					}
 				} else printLog("WARNING: recording time and distnce intervals missing, using default values.\n");
 			} else printLog("WARNING: no track recorder configuration found, using default values.\n");
-			part=roxml_get_chld(root,"colorSchema",0);
+			part=roxml_get_first_chld(root,"colorSchema");
 			if(part!=NULL) {
-				detail=roxml_get_chld(part,"colors",0);
+				detail=roxml_get_first_chld(part,"colors");
 				if(detail!=NULL) {
 					unsigned int color;
 					attr=roxml_get_attr(detail,"background",0);
@@ -321,7 +333,7 @@ void loadConfig(void) { //Load configuration
 					}
 				} else printLog("WARNING: in the color schema the colors are missing, using default colors.\n");
 			} else printLog("WARNING: no color schema found, using default colors.\n");
-			part=roxml_get_chld(root,"GPSreceiver",0);
+			part=roxml_get_first_chld(root,"GPSreceiver");
 			if(part!=NULL) {
 				attr=roxml_get_attr(part,"devName",0);
 				if(attr!=NULL) {
@@ -348,6 +360,36 @@ void loadConfig(void) { //Load configuration
 					text=roxml_get_content(attr,NULL,0,NULL);
 					config.GPSparity=atoi(text);
 				}
+				attr=roxml_get_attr(part,"lowLatency",0);
+				if(attr!=NULL) {
+					text=roxml_get_content(attr,NULL,0,NULL);
+					config.GPSlowLatency=atoi(text);
+				}
+				attr=roxml_get_attr(part,"ubxRate",0);
+				if(attr!=NULL) {
+					text=roxml_get_content(attr,NULL,0,NULL);
+					config.GPSubxRate=atoi(text);
+				}
+				attr=roxml_get_attr(part,"staleTimeout",0);
+				if(attr!=NULL) {
+					text=roxml_get_content(attr,NULL,0,NULL);
+					config.GPSstaleTimeout=atof(text);
+				}
+				attr=roxml_get_attr(part,"reconnectTimeout",0);
+				if(attr!=NULL) {
+					text=roxml_get_content(attr,NULL,0,NULL);
+					config.GPSreconnectTimeout=atof(text);
+				}
+				attr=roxml_get_attr(part,"replayFile",0);
+				if(attr!=NULL) {
+					text=roxml_get_content(attr,NULL,0,NULL);
+					config.GPSreplayFile=strdup(text);
+				}
+				attr=roxml_get_attr(part,"replaySpeed",0);
+				if(attr!=NULL) {
+					text=roxml_get_content(attr,NULL,0,NULL);
+					config.GPSreplaySpeed=atof(text);
+				}
 			} else printLog("WARNING: no GPS receiver configuration found, using default values.\n");
 		} else printLog("ERROR: configuration file config.xml with root element wrong.\n");
 		roxml_release(RELEASE_ALL);
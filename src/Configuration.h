@@ -6,7 +6,7 @@
 // Copyright   : (C) 2010-2020 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 2/8/2014
+// Last change : 17/10/2026
 // Description : Header of Config with the shared config data struct
 //============================================================================
 
@@ -65,9 +65,16 @@ struct configuration {
 	int timeZone; //local time offset from UTC time in hours
 	double recordTimeInterval; //sec
 	double recordMinDist; //meters
+	double recordSyncInterval; //sec, maximum time a recorded track point waits to be saved
 	char *GPSdevName;
 	long GPSbaudRate;
 	short GPSdataBits, GPSstopBits, GPSparity;
+	short GPSlowLatency; //1 to ask the driver of the serial port to give the received bytes without delay
+	int GPSubxRate; //Hz, navigation rate to configure on a u-blox receiver sending UBX, 0 to not configure it
+	double GPSstaleTimeout; //sec without any frame from the GPS to consider the fix lost, 0 to never
+	double GPSreconnectTimeout; //sec without any frame from the GPS to open again the device, 0 to never
+	char *GPSreplayFile; //recorded GPS data to be replayed instead of reading the device, NULL for none
+	double GPSreplaySpeed; //1 real time, N times faster, 0 as fast as possible
 	char *tomtomModel; //model of the TomtTom device
 	char *serialNumber; //TomTom device serial number ID
 	struct colorConfig colorSchema;
@@ -6,7 +6,7 @@
 // Copyright   : (C) 2010-2020 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 2/8/2013
+// Last change : 17/10/2026
 // Description : Functions to manage sunrise and sunset times
 //============================================================================
 
@@ -79,12 +79,9 @@ int calcSunriseSunsetWithInternalClockTime(double lat, double lon, double *riseT
 
 void calcFlightPlanEphemerides(double lat, double lon, bool isDeparture) {
 	double riseTime, setTime;
-	if(gps.fixMode>MODE_NO_FIX) {
-		//TODO: can we avoid to lock the mutex here?
-		pthread_mutex_lock(&gps.mutex);
-		calcSunriseSunset(lat,lon,gps.day,gps.month,gps.year,config.sunZenith,0,&riseTime,&setTime);
-		pthread_mutex_unlock(&gps.mutex);
-	}
+	struct GPSdata snapshot;
+	GPSgetSnapshot(&snapshot);
+	if(snapshot.fixMode>MODE_NO_FIX) calcSunriseSunset(lat,lon,snapshot.day,snapshot.month,snapshot.year,config.sunZenith,0,&riseTime,&setTime);
 	else calcSunriseSunsetWithInternalClockTime(lat,lon,&riseTime,&setTime);
 	if(isDeparture) {
 		//Ephemerides.departurePresent=true;
@@ -6,7 +6,7 @@
 // Copyright   : (C) 2010-2020 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 22/1/2014
+// Last change : 17/10/2026
 // Description : FrameBuffer renderer
 //============================================================================
 
@@ -19,6 +19,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <stdarg.h>
+#include <pthread.h>
 #include <sys/mman.h>
 #include <sys/ioctl.h>
 #include <linux/fb.h>
@@ -29,6 +30,13 @@
 #include "Configuration.h"
 
 #define CHAR_WIDTH    8
+#define MAX_DIRTY_RECTS 16 //max number of separated damaged regions tracked between two flushes
+#define DIRTY_MERGE_MARGIN 8 //damaged regions closer than this (in pixels) are merged together
+#define DEFAULT_REFRESH_HZ 60 //used when the refresh rate can not be calculated from the video timings
+
+struct dirtyRect {
+	int x1,y1,x2,y2; //upper left and lower right corners, both included
+};
 
 struct FBrenderStruct {
 	int fbfd;
@@ -39,10 +47,23 @@ struct FBrenderStruct {
 	char *fbbackp;
 	int iClipTop,iClipBottom,iClipMin,iClipMax;
 	short isOpen;
+	struct dirtyRect dirty[MAX_DIRTY_RECTS]; //regions of the back buffer changed since the last flush
+	int numDirty;
+	pthread_mutex_t mutex; //serializes the drawing between the main thread and the render thread
+	bool headless;         //the screen is only a surface in memory, there is no framebuffer device
+	char *dumpPrefix;      //if not NULL each flushed frame of the headless screen is saved in a PPM file
+	struct FBrenderStats stats;
 };
 
 void FBrenderScroll(int target_y, int source_y, int height);
 unsigned long FixSqrt(unsigned long x);
+void markDirty(int x1, int y1, int x2, int y2);
+void dumpFrame(void);
+void markDirtyItalic(int x, int y, int numChars);
+void putPixel(int x, int y, unsigned short color);
+void blitCharacter(int x, int y, unsigned short aColor, unsigned short aBackColor, char character);
+void blitCharacterItalic(int x, int y, unsigned short aColor, unsigned short aBackColor, char character);
+void horizontalLine(int X, int Y, int width, unsigned short color);
 
 static struct FBrenderStruct FBrender = {
 	.fbfd=-1,
@@ -53,7 +74,12 @@ static struct FBrenderStruct FBrender = {
 	.iClipBottom=272,
 	.iClipMin=0,
 	.iClipMax=480,
-	.isOpen=-1
+	.isOpen=-1,
+	.numDirty=0,
+	.mutex=PTHREAD_MUTEX_INITIALIZER,
+	.headless=false,
+	.dumpPrefix=NULL,
+	.stats={0,0}
 };
 
 unsigned short Color(int r, int g, int b) {
@@ -64,6 +90,25 @@ int FBrenderBpp(void) {
 	return FBrender.vinfo.bits_per_pixel;
 }
 
+int FBrenderRefreshRate(void) { //vertical refresh rate of the display in Hz
+	unsigned long htotal,vtotal;
+	if(FBrender.isOpen!=1 || FBrender.vinfo.pixclock==0) return DEFAULT_REFRESH_HZ;
+	htotal=FBrender.vinfo.xres+FBrender.vinfo.left_margin+FBrender.vinfo.right_margin+FBrender.vinfo.hsync_len;
+	vtotal=FBrender.vinfo.yres+FBrender.vinfo.upper_margin+FBrender.vinfo.lower_margin+FBrender.vinfo.vsync_len;
+	if(htotal==0 || vtotal==0) return DEFAULT_REFRESH_HZ;
+	int hz=(int)(1e12/((double)FBrender.vinfo.pixclock*htotal*vtotal)); //pixclock is in picoseconds
+	if(hz<1) return DEFAULT_REFRESH_HZ;
+	return hz;
+}
+
+void FBrenderLock(void) {
+	pthread_mutex_lock(&FBrender.mutex);
+}
+
+void FBrenderUnlock(void) {
+	pthread_mutex_unlock(&FBrender.mutex);
+}
+
 short FBrenderOpen(void) {
 	FBrender.fbfd=open("/dev/fb",O_RDWR);
 	if(!FBrender.fbfd) { //open the framebuffer
@@ -103,17 +148,63 @@ short FBrenderOpen(void) {
 	return 1;
 }
 
+short FBrenderOpenHeadless(int width, int height, const char *dumpPrefix) { //screen in memory only, to draw without a framebuffer device
+	memset(&FBrender.vinfo,0,sizeof(struct fb_var_screeninfo));
+	memset(&FBrender.finfo,0,sizeof(struct fb_fix_screeninfo));
+	FBrender.vinfo.xres=width;
+	FBrender.vinfo.yres=height;
+	FBrender.vinfo.bits_per_pixel=16; //RGB565 as on the device
+	FBrender.finfo.line_length=width*2;
+	screen.width=width;
+	screen.height=height;
+	FBrender.iClipTop=0;
+	FBrender.iClipBottom=screen.height;
+	FBrender.iClipMin=0;
+	FBrender.iClipMax=screen.width;
+	FBrender.screensize=width*height*2;
+	FBrender.fbfd=-1;
+	FBrender.fbp=(char*)calloc(1,FBrender.screensize); //plays the role of the framebuffer device memory
+	FBrender.fbbackp=(char*)calloc(1,FBrender.screensize);
+	if(FBrender.fbp==NULL || FBrender.fbbackp==NULL) {
+		printf("FATAL ERROR: Impossible to allocate the headless screen.\n");
+		free(FBrender.fbp);
+		free(FBrender.fbbackp);
+		FBrender.fbp=NULL;
+		FBrender.fbbackp=NULL;
+		FBrender.isOpen=-4;
+		return 0;
+	}
+	FBrender.headless=true;
+	FBrender.dumpPrefix=(dumpPrefix!=NULL)?strdup(dumpPrefix):NULL;
+	FBrender.numDirty=0;
+	FBrender.isOpen=1;
+	return 1;
+}
+
 void FBrenderClose(void) {
 	if(FBrender.isOpen!=1) return;
-	if(FBrender.fbfd>0) {
+	if(FBrender.headless) {
+		free(FBrender.fbp);
+		free(FBrender.dumpPrefix);
+		FBrender.dumpPrefix=NULL;
+		FBrender.headless=false;
+	} else if(FBrender.fbfd>0) {
 		munmap(FBrender.fbp,FBrender.screensize);
 		close(FBrender.fbfd);
 	}
 	if(FBrender.fbbackp) free(FBrender.fbbackp);
+	FBrender.fbp=NULL;
+	FBrender.fbbackp=NULL;
 	FBrender.fbfd=-1;
+	FBrender.isOpen=-1;
+}
+
+void FBrenderGetStats(struct FBrenderStats *stats) {
+	*stats=FBrender.stats;
 }
 
 void FBrenderClear(int aFromY, int aNrLines, unsigned short aColor) {
+	markDirty(0,aFromY,screen.width-1,aFromY+aNrLines-1);
 	unsigned short *ptr=(unsigned short*)(FBrender.fbbackp+aFromY*((FBrender.vinfo.xres*FBrender.vinfo.bits_per_pixel)/8));
 	unsigned short *endp=ptr+aNrLines*((FBrender.vinfo.xres*FBrender.vinfo.bits_per_pixel)/16);
 	while(ptr<endp) {
@@ -124,12 +215,61 @@ void FBrenderClear(int aFromY, int aNrLines, unsigned short aColor) {
 	}
 }
 
-inline void FBrenderPutPixel(int x, int y, unsigned short color) {
+inline void putPixel(int x, int y, unsigned short color) { //put a pixel without marking it as damaged
 	unsigned short *ptr=(unsigned short*)(FBrender.fbbackp+y*((FBrender.vinfo.xres*FBrender.vinfo.bits_per_pixel)/8));
 	ptr+=x;
 	*ptr=color;
 }
 
+void FBrenderPutPixel(int x, int y, unsigned short color) {
+	markDirty(x,y,x,y);
+	putPixel(x,y,color);
+}
+
+void markDirty(int x1, int y1, int x2, int y2) { //add a damaged region to the ones to be copied at next flush
+	if(x1<0) x1=0;
+	if(y1<0) y1=0;
+	if(x2>=screen.width) x2=screen.width-1;
+	if(y2>=screen.height) y2=screen.height-1;
+	if(x1>x2 || y1>y2) return; //nothing visible has been touched
+	int i=0;
+	while(i<FBrender.numDirty) { //merge with the regions that are overlapping or near enough
+		struct dirtyRect *r=&FBrender.dirty[i];
+		if(x1<=r->x2+DIRTY_MERGE_MARGIN && x2>=r->x1-DIRTY_MERGE_MARGIN && y1<=r->y2+DIRTY_MERGE_MARGIN && y2>=r->y1-DIRTY_MERGE_MARGIN) {
+			if(r->x1<x1) x1=r->x1;
+			if(r->y1<y1) y1=r->y1;
+			if(r->x2>x2) x2=r->x2;
+			if(r->y2>y2) y2=r->y2;
+			FBrender.dirty[i]=FBrender.dirty[--FBrender.numDirty]; //remove it and check again the others with the grown region
+			i=0;
+		} else i++;
+	}
+	if(FBrender.numDirty==MAX_DIRTY_RECTS) { //no more space: merge with the region that grows the least
+		int best=0;
+		long bestGrowth=-1;
+		for(i=0;i<FBrender.numDirty;i++) {
+			struct dirtyRect *r=&FBrender.dirty[i];
+			int ux1=r->x1<x1?r->x1:x1, uy1=r->y1<y1?r->y1:y1, ux2=r->x2>x2?r->x2:x2, uy2=r->y2>y2?r->y2:y2;
+			long growth=(long)(ux2-ux1+1)*(uy2-uy1+1)-(long)(r->x2-r->x1+1)*(r->y2-r->y1+1);
+			if(bestGrowth<0 || growth<bestGrowth) {
+				bestGrowth=growth;
+				best=i;
+			}
+		}
+		struct dirtyRect *r=&FBrender.dirty[best];
+		if(r->x1<x1) x1=r->x1;
+		if(r->y1<y1) y1=r->y1;
+		if(r->x2>x2) x2=r->x2;
+		if(r->y2>y2) y2=r->y2;
+		FBrender.dirty[best]=FBrender.dirty[--FBrender.numDirty];
+	}
+	FBrender.dirty[FBrender.numDirty].x1=x1;
+	FBrender.dirty[FBrender.numDirty].y1=y1;
+	FBrender.dirty[FBrender.numDirty].x2=x2;
+	FBrender.dirty[FBrender.numDirty].y2=y2;
+	FBrender.numDirty++;
+}
+
 // Character set
 static const unsigned char asciiTable[]={0x00,0x00,0x00,0x00,0x00,//0x00,
 		0x00,0x00,0x5F,0x00,0x00,//0x00,
@@ -230,6 +370,21 @@ static const unsigned char asciiTable[]={0x00,0x00,0x00,0x00,0x00,//0x00,
 		};
 
 void FBrenderBlitCharacter(int x, int y, unsigned short aColor, unsigned short aBackColor, char character) {
+	markDirty(x,y,x+CHAR_WIDTH-4,y+CHAR_WIDTH-1);
+	blitCharacter(x,y,aColor,aBackColor,character);
+}
+
+void FBrenderBlitCharacterItalic(int x, int y, unsigned short aColor, unsigned short aBackColor, char character) {
+	markDirtyItalic(x,y,1);
+	blitCharacterItalic(x,y,aColor,aBackColor,character);
+}
+
+void markDirtyItalic(int x, int y, int numChars) { //each row of an italic character is shifted by one pixel to the left
+	if(x<CHAR_WIDTH) markDirty(0,y-1,screen.width-1,y+CHAR_WIDTH); //near the left border the rows wrap on the end of the previous line
+	else markDirty(x-CHAR_WIDTH,y,x+numChars*CHAR_WIDTH-4,y+CHAR_WIDTH);
+}
+
+void blitCharacter(int x, int y, unsigned short aColor, unsigned short aBackColor, char character) {
 	unsigned char data0,data1,data2,data3,data4;
 	if(x<0||y<0) return;
 	if(x>screen.width-CHAR_WIDTH-1||y>screen.height-7) return;
@@ -263,7 +418,7 @@ void FBrenderBlitCharacter(int x, int y, unsigned short aColor, unsigned short a
 	}
 }
 
-void FBrenderBlitCharacterItalic(int x, int y, unsigned short aColor, unsigned short aBackColor, char character) {
+void blitCharacterItalic(int x, int y, unsigned short aColor, unsigned short aBackColor, char character) {
 	unsigned char data0,data1,data2,data3,data4;
 	if(x<0||y<0) return;
 	if(x>screen.width-CHAR_WIDTH-1||y>screen.height-7) return;
@@ -304,11 +459,13 @@ int FBrenderBlitText(int x, int y, unsigned short aColor, unsigned short aBackCo
 		va_start(arg,args);
 		char *str;
 		done=vasprintf(&str,args,arg);
-		if(done) {
+		if(done>0) {
+			if(italic) markDirtyItalic(x,y,done); //the whole string at once
+			else markDirty(x,y,x+done*CHAR_WIDTH-4,y+CHAR_WIDTH-1);
 			int i=0;
 			while(str[i]) {
-				if(italic) FBrenderBlitCharacterItalic(x,y,aColor,aBackColor,str[i]);
-				else FBrenderBlitCharacter(x,y,aColor,aBackColor,str[i]);
+				if(italic) blitCharacterItalic(x,y,aColor,aBackColor,str[i]);
+				else blitCharacter(x,y,aColor,aBackColor,str[i]);
 				x+=CHAR_WIDTH;
 				i++;
 			}
@@ -318,11 +475,50 @@ int FBrenderBlitText(int x, int y, unsigned short aColor, unsigned short aBackCo
 	return done;
 }
 
-void FBrenderFlush(void) {
-	memcpy(FBrender.fbp,FBrender.fbbackp,FBrender.screensize);
+void FBrenderFlush(void) { //copy on the screen only the damaged regions of the back buffer
+	int lineLength=(FBrender.vinfo.xres*FBrender.vinfo.bits_per_pixel)/8;
+	int bytesPerPixel=FBrender.vinfo.bits_per_pixel/8;
+	for(int i=0;i<FBrender.numDirty;i++) {
+		struct dirtyRect *r=&FBrender.dirty[i];
+		long offset=r->y1*lineLength+r->x1*bytesPerPixel;
+		FBrender.stats.pixelsFlushed+=(unsigned long)(r->x2-r->x1+1)*(r->y2-r->y1+1);
+		if(r->x1==0 && r->x2==screen.width-1) memcpy(FBrender.fbp+offset,FBrender.fbbackp+offset,(r->y2-r->y1+1)*lineLength); //full lines: one single copy
+		else {
+			int rowLength=(r->x2-r->x1+1)*bytesPerPixel;
+			for(int y=r->y1;y<=r->y2;y++,offset+=lineLength) memcpy(FBrender.fbp+offset,FBrender.fbbackp+offset,rowLength);
+		}
+	}
+	FBrender.numDirty=0;
+	FBrender.stats.flushes++;
+	if(FBrender.dumpPrefix!=NULL) dumpFrame();
+}
+
+void dumpFrame(void) { //save the headless screen in a binary PPM file, converting RGB565 to RGB888
+	char *fileName;
+	if(asprintf(&fileName,"%s%05lu.ppm",FBrender.dumpPrefix,FBrender.stats.flushes)<0) return;
+	FILE *ppm=fopen(fileName,"wb");
+	free(fileName);
+	if(ppm==NULL) return;
+	unsigned char *row=(unsigned char*)malloc(screen.width*3);
+	if(row!=NULL) {
+		fprintf(ppm,"P6\n%d %d\n255\n",screen.width,screen.height);
+		const unsigned short *pixel=(const unsigned short*)FBrender.fbp;
+		for(int y=0;y<screen.height;y++) {
+			unsigned char *rgb=row;
+			for(int x=0;x<screen.width;x++,pixel++) {
+				*rgb++=(*pixel>>8)&0xF8;
+				*rgb++=(*pixel>>3)&0xFC;
+				*rgb++=(*pixel<<3)&0xF8;
+			}
+			fwrite(row,1,screen.width*3,ppm);
+		}
+		free(row);
+	}
+	fclose(ppm);
 }
 
 void FBrenderScroll(int target_y, int source_y, int height) {
+	markDirty(0,target_y,screen.width-1,target_y+height-1);
 	memmove(FBrender.fbbackp+target_y*screen.height*2,FBrender.fbbackp+source_y*screen.height*2,height*screen.height*2);
 }
 
@@ -344,6 +540,11 @@ unsigned long FixSqrt(unsigned long x) {
 }
 
 void DrawHorizontalLine(int X, int Y, int width, unsigned short color) {
+	markDirty(X,Y,X+width-1,Y);
+	horizontalLine(X,Y,width,color);
+}
+
+void horizontalLine(int X, int Y, int width, unsigned short color) { //draw horizontal line without marking it as damaged
 	register int w=width; // in pixels
 	if(Y<FBrender.iClipTop) return;
 	if(Y>=FBrender.iClipBottom) return;
@@ -352,16 +553,17 @@ void DrawHorizontalLine(int X, int Y, int width, unsigned short color) {
 		X=FBrender.iClipMin;
 	}
 	if(w>FBrender.iClipMax-X) w=FBrender.iClipMax-X; // clip right margin
-	while(w-->0) FBrenderPutPixel(X++,Y,color); // put the pixels...
+	while(w-->0) putPixel(X++,Y,color); // put the pixels...
 }
 
 void FillCircle(int cx, int cy, int aRad, unsigned short color) {
 	int y;
+	markDirty(cx-aRad,cy-aRad,cx+aRad,cy+aRad);
 	for(y=cy-aRad;y<=cy+aRad;++y) {
 		register unsigned long tmp;
 		tmp=aRad*aRad-(y-cy)*(y-cy);
 		tmp=FixSqrt(tmp);
-		DrawHorizontalLine(cx-tmp,y,tmp<<1,color);
+		horizontalLine(cx-tmp,y,tmp<<1,color);
 	}
 }
 
@@ -371,28 +573,30 @@ void PutLinePoint(int x, int y, unsigned short color, int width) {
 }
 
 void DrawTwoPointsLine(int ax, int ay, int bx, int by, unsigned short color) {
+	markDirty(ax<bx?ax:bx,ay<by?ay:by,ax>bx?ax:bx,ay>by?ay:by);
 	if(ax!=bx) { //non vertical line
 		double m=(double)(by-ay)/(double)(bx-ax);
 		double q=ay-m*ax;
 		if(m<-1 || m>1) {
 			int y;
-			if(by>ay) for(y=ay;y<by;y++) FBrenderPutPixel(((int)round((y-q)/m)),y,color);
-			else for(y=by;y<ay;y++) FBrenderPutPixel(((int)round((y-q)/m)),y,color);
+			if(by>ay) for(y=ay;y<by;y++) putPixel(((int)round((y-q)/m)),y,color);
+			else for(y=by;y<ay;y++) putPixel(((int)round((y-q)/m)),y,color);
 		} else {
 			int x;
-			if(bx>ax) for(x=ax;x<bx;x++) FBrenderPutPixel(x,((int)round(m*x+q)),color);
-			else for(x=bx;x<ax;x++) FBrenderPutPixel(x,((int)round(m*x+q)),color);
+			if(bx>ax) for(x=ax;x<bx;x++) putPixel(x,((int)round(m*x+q)),color);
+			else for(x=bx;x<ax;x++) putPixel(x,((int)round(m*x+q)),color);
 		}
 	} else { //vertical line
 		int y;
-		if(by>ay) for(y=ay;y<by;y++) FBrenderPutPixel(ax,y,color);
-		else for(y=by;y<ay;y++) FBrenderPutPixel(bx,y,color);
+		if(by>ay) for(y=ay;y<by;y++) putPixel(ax,y,color);
+		else for(y=by;y<ay;y++) putPixel(bx,y,color);
 	}
 }
 
 void FillRect(int ulx, int uly, int drx, int dry, unsigned short color) {
 	int y,lenght=drx-ulx;
-	for(y=uly;y<=dry;y++) DrawHorizontalLine(ulx,y,lenght,color);
+	markDirty(ulx,uly,drx-1,dry);
+	for(y=uly;y<=dry;y++) horizontalLine(ulx,y,lenght,color);
 }
 
 void DrawButton(int x, int y, bool active, const char *label, ...) {
@@ -540,7 +744,7 @@ void PrintSpeed(double speedKmh, double speedKnots) {
 	}
 }
 
-void PrintNavStatus(int navStatus, char *WPname) {
+void PrintNavStatus(int navStatus, const char *WPname) {
 	char *statusName;
 	switch((enum navigatorStatus)navStatus) {
 			case NAV_STATUS_NOT_INIT:         statusName=strdup("Nav not set   "); break;
@@ -6,7 +6,7 @@
 // Copyright   : (C) 2010-2020 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 22/1/2014
+// Last change : 17/10/2026
 // Description : Header of FBrender.c the FrameBuffer renderer
 //============================================================================
 
@@ -19,10 +19,20 @@ struct screenConfig {
 	int height,width; //size of screen in pixel
 } screen;
 
+struct FBrenderStats {
+	unsigned long flushes;       //frames copied to the screen
+	unsigned long pixelsFlushed; //pixels copied from the back buffer to the screen
+};
+
 inline unsigned short Color(int r, int g, int b);
 int FBrenderBpp(void);
+int FBrenderRefreshRate(void);
+void FBrenderLock(void);
+void FBrenderUnlock(void);
 void FBrenderFlush(void);
 short FBrenderOpen(void);
+short FBrenderOpenHeadless(int width, int height, const char *dumpPrefix);
+void FBrenderGetStats(struct FBrenderStats *stats);
 void FBrenderClose(void);
 void FBrenderClear(int aFromY, int aNrLines, unsigned short aColor);
 void FBrenderBlitCharacter(int x, int y, unsigned short aColor, unsigned short aBackColor, char character);
@@ -47,7 +57,7 @@ void PrintTime(int hour, int minute, float second, short waring);
 void PrintFixMode(int fixMode);
 void PrintNumOfSats(int activeSats, int satsInView);
 //void PrintDiluitions(float pDiluition, float hDiluition, float vDiluition);
-void PrintNavStatus(int navStatus, char *WPname);
+void PrintNavStatus(int navStatus, const char *WPname);
 void PrintNavTrackATD(double atdRad);
 void PrintNavRemainingDistWP(double dist, double averageSpeed, double hours);
 void PrintNavRemainingDistDST(double dist, double averageSpeed, double hours);
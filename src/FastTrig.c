@@ -0,0 +1,198 @@
+//============================================================================
+// Name        : FastTrig.c
+// Since       : 17/10/2026
+// Author      : Alberto Realis-Luc <alberto.realisluc@gmail.com>
+// Web         : https://www.alus.it/airnavigator/
+// Copyright   : (C) 2010-2026 Alberto Realis-Luc
+// License     : GNU GPL v2
+// Repository  : https://github.com/alus-it/AirNavigator.git
+// Last change : 17/10/2026
+// Description : Float trigonometry based on tables and the great circle
+//               calculations of AirCalc done with it
+//============================================================================
+
+
+#include <math.h>
+#include "FastTrig.h"
+#include "AirCalc.h"
+
+#define TRIG_STEPS      256                   //entries of the sine table on the whole circle (power of 2)
+#define TRIG_QUARTER    (TRIG_STEPS/4)        //offset of the cosine in the sine table
+#define STEPS_PER_RAD   40.7436654f           //TRIG_STEPS/(2*PI)
+#define STEP_HI         0.02454376220703125f  //2*PI/TRIG_STEPS split in two parts: this one with only 12 significant bits
+#define STEP_LO         -6.96008584e-08f      //...and the rest, to reduce the angle without losing precision
+#define ATAN_STEPS      64                    //entries of the arctangent table between 0 and 1
+#define F_PI            3.14159265f
+#define F_PI_2          1.57079633f
+
+static const float sinTable[TRIG_STEPS+TRIG_QUARTER]={ //sin(2*PI*i/TRIG_STEPS)
+	0.0f,0.0245412285f,0.0490676743f,0.0735645636f,0.0980171403f,0.122410675f,0.146730474f,0.170961889f,
+	0.195090322f,0.21910124f,0.24298018f,0.266712757f,0.290284677f,0.31368174f,0.336889853f,0.359895037f,
+	0.382683432f,0.405241314f,0.427555093f,0.44961133f,0.471396737f,0.492898192f,0.514102744f,0.53499762f,
+	0.555570233f,0.575808191f,0.595699304f,0.615231591f,0.634393284f,0.653172843f,0.671558955f,0.689540545f,
+	0.707106781f,0.724247083f,0.740951125f,0.757208847f,0.773010453f,0.788346428f,0.803207531f,0.817584813f,
+	0.831469612f,0.844853565f,0.85772861f,0.870086991f,0.881921264f,0.893224301f,0.903989293f,0.914209756f,
+	0.923879533f,0.932992799f,0.941544065f,0.949528181f,0.956940336f,0.963776066f,0.970031253f,0.97570213f,
+	0.98078528f,0.985277642f,0.98917651f,0.992479535f,0.995184727f,0.997290457f,0.998795456f,0.999698819f,
+	1.0f,0.999698819f,0.998795456f,0.997290457f,0.995184727f,0.992479535f,0.98917651f,0.985277642f,
+	0.98078528f,0.97570213f,0.970031253f,0.963776066f,0.956940336f,0.949528181f,0.941544065f,0.932992799f,
+	0.923879533f,0.914209756f,0.903989293f,0.893224301f,0.881921264f,0.870086991f,0.85772861f,0.844853565f,
+	0.831469612f,0.817584813f,0.803207531f,0.788346428f,0.773010453f,0.757208847f,0.740951125f,0.724247083f,
+	0.707106781f,0.689540545f,0.671558955f,0.653172843f,0.634393284f,0.615231591f,0.595699304f,0.575808191f,
+	0.555570233f,0.53499762f,0.514102744f,0.492898192f,0.471396737f,0.44961133f,0.427555093f,0.405241314f,
+	0.382683432f,0.359895037f,0.336889853f,0.31368174f,0.290284677f,0.266712757f,0.24298018f,0.21910124f,
+	0.195090322f,0.170961889f,0.146730474f,0.122410675f,0.0980171403f,0.0735645636f,0.0490676743f,0.0245412285f,
+	1.2246468e-16f,-0.0245412285f,-0.0490676743f,-0.0735645636f,-0.0980171403f,-0.122410675f,-0.146730474f,-0.170961889f,
+	-0.195090322f,-0.21910124f,-0.24298018f,-0.266712757f,-0.290284677f,-0.31368174f,-0.336889853f,-0.359895037f,
+	-0.382683432f,-0.405241314f,-0.427555093f,-0.44961133f,-0.471396737f,-0.492898192f,-0.514102744f,-0.53499762f,
+	-0.555570233f,-0.575808191f,-0.595699304f,-0.615231591f,-0.634393284f,-0.653172843f,-0.671558955f,-0.689540545f,
+	-0.707106781f,-0.724247083f,-0.740951125f,-0.757208847f,-0.773010453f,-0.788346428f,-0.803207531f,-0.817584813f,
+	-0.831469612f,-0.844853565f,-0.85772861f,-0.870086991f,-0.881921264f,-0.893224301f,-0.903989293f,-0.914209756f,
+	-0.923879533f,-0.932992799f,-0.941544065f,-0.949528181f,-0.956940336f,-0.963776066f,-0.970031253f,-0.97570213f,
+	-0.98078528f,-0.985277642f,-0.98917651f,-0.992479535f,-0.995184727f,-0.997290457f,-0.998795456f,-0.999698819f,
+	-1.0f,-0.999698819f,-0.998795456f,-0.997290457f,-0.995184727f,-0.992479535f,-0.98917651f,-0.985277642f,
+	-0.98078528f,-0.97570213f,-0.970031253f,-0.963776066f,-0.956940336f,-0.949528181f,-0.941544065f,-0.932992799f,
+	-0.923879533f,-0.914209756f,-0.903989293f,-0.893224301f,-0.881921264f,-0.870086991f,-0.85772861f,-0.844853565f,
+	-0.831469612f,-0.817584813f,-0.803207531f,-0.788346428f,-0.773010453f,-0.757208847f,-0.740951125f,-0.724247083f,
+	-0.707106781f,-0.689540545f,-0.671558955f,-0.653172843f,-0.634393284f,-0.615231591f,-0.595699304f,-0.575808191f,
+	-0.555570233f,-0.53499762f,-0.514102744f,-0.492898192f,-0.471396737f,-0.44961133f,-0.427555093f,-0.405241314f,
+	-0.382683432f,-0.359895037f,-0.336889853f,-0.31368174f,-0.290284677f,-0.266712757f,-0.24298018f,-0.21910124f,
+	-0.195090322f,-0.170961889f,-0.146730474f,-0.122410675f,-0.0980171403f,-0.0735645636f,-0.0490676743f,-0.0245412285f,
+	-2.4492936e-16f,0.0245412285f,0.0490676743f,0.0735645636f,0.0980171403f,0.122410675f,0.146730474f,0.170961889f,
+	0.195090322f,0.21910124f,0.24298018f,0.266712757f,0.290284677f,0.31368174f,0.336889853f,0.359895037f,
+	0.382683432f,0.405241314f,0.427555093f,0.44961133f,0.471396737f,0.492898192f,0.514102744f,0.53499762f,
+	0.555570233f,0.575808191f,0.595699304f,0.615231591f,0.634393284f,0.653172843f,0.671558955f,0.689540545f,
+	0.707106781f,0.724247083f,0.740951125f,0.757208847f,0.773010453f,0.788346428f,0.803207531f,0.817584813f,
+	0.831469612f,0.844853565f,0.85772861f,0.870086991f,0.881921264f,0.893224301f,0.903989293f,0.914209756f,
+	0.923879533f,0.932992799f,0.941544065f,0.949528181f,0.956940336f,0.963776066f,0.970031253f,0.97570213f,
+	0.98078528f,0.985277642f,0.98917651f,0.992479535f,0.995184727f,0.997290457f,0.998795456f,0.999698819f
+};
+
+static const float atanTable[ATAN_STEPS+1]={ //atan(i/ATAN_STEPS)
+	0.0f,0.0156237286f,0.0312398334f,0.0468407129f,0.06241881f,0.0779666338f,0.0934767812f,0.108941957f,
+	0.124354995f,0.139708874f,0.154996742f,0.170211925f,0.18534795f,0.200398554f,0.2153577f,0.230219587f,
+	0.244978663f,0.259629629f,0.274167451f,0.288587362f,0.302884868f,0.317055753f,0.331096077f,0.345002177f,
+	0.35877067f,0.372398447f,0.385882669f,0.39922077f,0.412410442f,0.425449637f,0.43833656f,0.451069656f,
+	0.463647609f,0.47606933f,0.488333951f,0.500440813f,0.51238946f,0.524179629f,0.535811238f,0.547284381f,
+	0.558599315f,0.569756453f,0.580756354f,0.59159971f,0.602287346f,0.612820202f,0.62319933f,0.633425883f,
+	0.643501109f,0.653426341f,0.663202993f,0.672832548f,0.682316555f,0.691656622f,0.700854408f,0.709911618f,
+	0.71883f,0.727611333f,0.736257429f,0.744770126f,0.753151281f,0.76140277f,0.76952648f,0.77752431f,
+	0.785398163f
+};
+
+float fastAtan(float t);
+float nearAngle(double angle);
+float rightAngleSide(float hypotenuse, float side);
+
+void FastTrigSinCos(float angle, float *sine, float *cosine) {
+	float steps=angle*STEPS_PER_RAD;
+	int n=(int)(steps<0?steps-0.5f:steps+0.5f); //nearest entry of the table
+	float d=(angle-n*STEP_HI)-n*STEP_LO; //remaining angle: at most half step (0.0123 rad)
+	float d2=d*d;
+	float sinD=d*(1-d2*(1/6.0f)); //Taylor series: the next terms are below 3e-12
+	float cosD=1-d2*0.5f*(1-d2*(1/12.0f));
+	int i=n&(TRIG_STEPS-1);
+	float s=sinTable[i], c=sinTable[i+TRIG_QUARTER];
+	*sine=s*cosD+c*sinD; //sin(a+d) and cos(a+d)
+	*cosine=c*cosD-s*sinD;
+}
+
+float nearAngle(double angle) { //between -PI and PI, reduced in double: near PI a float is precise only to 1.2e-7 rad
+	while(angle>M_PI) angle-=TWO_PI;
+	while(angle<-M_PI) angle+=TWO_PI;
+	return (float)angle;
+}
+
+float FastTrigSin(float angle) {
+	float s,c;
+	FastTrigSinCos(angle,&s,&c);
+	return s;
+}
+
+float FastTrigCos(float angle) {
+	float s,c;
+	FastTrigSinCos(angle,&s,&c);
+	return c;
+}
+
+float fastAtan(float t) { //only for t between 0 and 1
+	int i=(int)(t*ATAN_STEPS+0.5f);
+	float c=(float)i/ATAN_STEPS;
+	float u=(t-c)/(1+t*c); //atan(t)=atan(c)+atan(u) where u is at most 1/128
+	float u2=u*u;
+	return atanTable[i]+u*(1-u2*(1/3.0f-u2*(1/5.0f)));
+}
+
+float FastTrigAtan2(float y, float x) {
+	float ax=fabsf(x), ay=fabsf(y), a;
+	if(ax==0 && ay==0) return 0;
+	if(ay<=ax) a=fastAtan(ay/ax);
+	else a=F_PI_2-fastAtan(ax/ay);
+	if(x<0) a=F_PI-a;
+	return (y<0)?-a:a;
+}
+
+float rightAngleSide(float hypotenuse, float side) { //the other side of a right triangle, without cancellation
+	float p=(hypotenuse-side)*(hypotenuse+side);
+	return (p>0)?sqrtf(p):0;
+}
+
+float FastTrigAsin(float x) {
+	if(x>1) x=1;
+	else if(x<-1) x=-1;
+	return FastTrigAtan2(x,rightAngleSide(1,x));
+}
+
+float FastTrigAcos(float x) {
+	if(x>1) x=1;
+	else if(x<-1) x=-1;
+	return FastTrigAtan2(rightAngleSide(1,x),x);
+}
+
+double FastTrigAngularDist(const double lat1, const double lon1, const double lat2, const double lon2) { //haversine formula: good also for short distances
+	float sinHalfDlat=FastTrigSin((float)(lat1-lat2)*0.5f); //differences done in double: the float of each coordinate is precise only to about 1 m
+	float sinHalfDlon=FastTrigSin(nearAngle(lon1-lon2)*0.5f);
+	float h=sinHalfDlat*sinHalfDlat+FastTrigCos(lat1)*FastTrigCos(lat2)*sinHalfDlon*sinHalfDlon;
+	return 2*FastTrigAsin(sqrtf(h));
+}
+
+double FastTrigGreatCircleCourse(const double lat1, const double lon1, const double lat2, const double lon2) {
+	if(lat2==M_PI_2) return TWO_PI; //we are going to N pole
+	if(lat2==-M_PI_2) return M_PI; //we are going to S pole
+	if(lon1==lon2) {
+		if(lat1>lat2) return M_PI;
+		else return TWO_PI;
+	}
+	float sinLat1,cosLat1,sinLat2,cosLat2;
+	float dlon=nearAngle(lon1-lon2);
+	float sinHalfDlon=FastTrigSin(dlon*0.5f);
+	FastTrigSinCos(lat1,&sinLat1,&cosLat1);
+	FastTrigSinCos(lat2,&sinLat2,&cosLat2);
+	//cos(lat1)*sin(lat2)-sin(lat1)*cos(lat2)*cos(dlon) written to not subtract two almost equal numbers on short legs
+	float x=FastTrigSin((float)(lat2-lat1))+2*sinLat1*cosLat2*sinHalfDlon*sinHalfDlon;
+	return absAngle(FastTrigAtan2(FastTrigSin(dlon)*cosLat2,x));
+}
+
+double FastTrigGreatCircleRoute(const double lat1, const double lon1, const double lat2, const double lon2, double *d) { //same special cases of calcGreatCircleRoute
+	*d=FastTrigAngularDist(lat1,lon1,lat2,lon2);
+	if(lat1+lat2==0 && fabs(lon1-lon2)==M_PI && fabs(lat1)!=M_PI_2) return 0; //Course between antipodal points is undefined!
+	if(*d==0 || lat1==-M_PI_2) return TWO_PI; // distance null or starting from S pole
+	if(lat1==M_PI_2) return M_PI; //starting from N pole
+	return FastTrigGreatCircleCourse(lat1,lon1,lat2,lon2);
+}
+
+double FastTrigGCCrossTrackError(const double lat1, const double lon1, const double lon2, const double latX, const double lonX, const double course12, double *atd) {
+	double dist1X,diff;
+	double course1X=FastTrigGreatCircleRoute(lat1,lon1,latX,lonX,&dist1X);
+	if(lat1==M_PI_2) diff=lonX-lon2; //If the point 1 is the N or S Pole replace crs_1X-crs_12 with lonX-lon2 or lon2-lonX, respectively
+	else if(lat1==-M_PI_2) diff=lon2-lonX;
+	else diff=course1X-course12;
+	float sinDist,cosDist,sinDiff,cosDiff;
+	FastTrigSinCos(dist1X,&sinDist,&cosDist);
+	FastTrigSinCos(nearAngle(diff),&sinDiff,&cosDiff);
+	float xtd=FastTrigAsin(sinDist*sinDiff);
+	float along=fabsf(FastTrigAtan2(sinDist*cosDiff,cosDist)); //tan(atd)=tan(dist1X)*cos(diff): instead of acos(cos(dist1X)/cos(xtd)) that is useless in float
+	if(isAngleBetween(course12+M_PI_4,course1X,course12+M_PI)) *atd=-along;
+	else *atd=along;
+	return xtd;
+}
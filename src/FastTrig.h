@@ -0,0 +1,45 @@
+//============================================================================
+// Name        : FastTrig.h
+// Since       : 17/10/2026
+// Author      : Alberto Realis-Luc <alberto.realisluc@gmail.com>
+// Web         : https://www.alus.it/airnavigator/
+// Copyright   : (C) 2010-2026 Alberto Realis-Luc
+// License     : GNU GPL v2
+// Repository  : https://github.com/alus-it/AirNavigator.git
+// Last change : 17/10/2026
+// Description : Header of the float table based trigonometry: FastTrig.c
+//============================================================================
+
+#ifndef FASTTRIG_H_
+#define FASTTRIG_H_
+
+// Single precision trigonometry based on tables, for the devices without FPU
+// where each double operation and each call to the libm is emulated.
+// When AirNavigator is built with AIRCALC_FAST_TRIG defined the great circle
+// distance, course and cross track error of AirCalc and the rotations of the HSI
+// are calculated with these functions instead of the double ones of the libm.
+//
+// Maximum errors against long double measured by bin/AirCalcBench on 200000
+// legs from 100 m to 1000 km between latitudes -70 and +70 degrees:
+//   FastTrigSin, FastTrigCos:     1.2e-7 (angles between -4PI and 4PI)
+//   FastTrigAtan2:                2.8e-7 rad
+//   distance:                     0.3 m
+//   course:                       0.00002 deg, for legs longer than 1 km
+//   cross track error:            0.25 m
+//   along track distance:         0.35 m
+// These errors come from the single precision of the results: the formulas used
+// here are the ones well conditioned also for short distances, where the acos
+// of the double functions of AirCalc gives errors up to 0.1 m or even NaN.
+
+void FastTrigSinCos(float angle, float *sine, float *cosine);
+float FastTrigSin(float angle);
+float FastTrigCos(float angle);
+float FastTrigAtan2(float y, float x);
+float FastTrigAsin(float x);
+float FastTrigAcos(float x);
+double FastTrigAngularDist(const double lat1, const double lon1, const double lat2, const double lon2);
+double FastTrigGreatCircleCourse(const double lat1, const double lon1, const double lat2, const double lon2);
+double FastTrigGreatCircleRoute(const double lat1, const double lon1, const double lat2, const double lon2, double *d);
+double FastTrigGCCrossTrackError(const double lat1, const double lon1, const double lon2, const double latX, const double lonX, const double course12, double *atd);
+
+#endif /* FASTTRIG_H_ */
@@ -0,0 +1,179 @@
+//============================================================================
+// Name        : GPSdemux.c
+// Since       : 17/10/2026
+// Author      : Alberto Realis-Luc <alberto.realisluc@gmail.com>
+// Web         : https://www.alus.it/airnavigator/
+// Copyright   : (C) 2010-2026 Alberto Realis-Luc
+// License     : GNU GPL v2
+// Repository  : https://github.com/alus-it/AirNavigator.git
+// Last change : 17/10/2026
+// Description : Recognizes the frames of the GPS protocols and gives them to their decoders
+//============================================================================
+
+#include <string.h>
+#include "GPSdemux.h"
+#include "GPSreceiver.h"
+#include "NMEAparser.h"
+#include "SiRFparser.h"
+#include "UBXparser.h"
+#include "Renderer.h"
+
+#define NMEA_START   '$'
+#define SIRF_START_1 0xA0
+#define SIRF_START_2 0xA2
+#define UBX_START_1  0xB5
+#define UBX_START_2  0x62
+
+#define MAX_FRAME_LENGTH (UBX_MAX_PAYLOAD+8) //the longest frame
+
+
+struct GPSdemuxStruct {
+	unsigned char frame[MAX_FRAME_LENGTH]; //only for a frame split between two reads
+	int carriedBytes;                      //bytes of the split frame
+	bool parsed, NMEAparsed;               //frames accepted in the current read
+	struct GPSdemuxStats stats;
+};
+
+enum GPSprotocol protocolOf(unsigned char first);
+void scanFrames(const unsigned char *p, const unsigned char *end);
+int takeFrame(const unsigned char *start, int available);
+int measureFrame(const unsigned char *start, int available);
+void countBroken(enum GPSprotocol protocol, const unsigned char *start, int len);
+
+static struct GPSdemuxStruct GPSdemux = {
+	.carriedBytes=0,
+	.stats={
+		.noiseBytes=0,
+		.lastProtocol=GPS_PROTOCOL_NONE
+	}
+};
+
+bool GPSdemuxProcessBuffer(const unsigned char *buf, int redBytes) { //a single pass on the read buffer, true if any frame was accepted
+	const unsigned char *p=buf, *end=buf+redBytes;
+	GPSdemux.parsed=false;
+	GPSdemux.NMEAparsed=false;
+	while(GPSdemux.carriedBytes>0 && p<end) { //complete the frame split by the previous read
+		int carried=GPSdemux.carriedBytes, toCopy=MAX_FRAME_LENGTH-carried;
+		if(toCopy>end-p) toCopy=end-p;
+		memcpy(GPSdemux.frame+carried,p,toCopy);
+		int available=carried+toCopy, len=takeFrame(GPSdemux.frame,available);
+		GPSdemux.carriedBytes=0;
+		if(len>0) { //now it is complete
+			p+=len-carried;
+			continue;
+		}
+		if(len==0) {
+			if(available<MAX_FRAME_LENGTH) { //still not complete
+				GPSdemux.carriedBytes=available;
+				p=end;
+				continue;
+			}
+			countBroken(protocolOf(GPSdemux.frame[0]),GPSdemux.frame,len); //longer than any frame
+		}
+		scanFrames(GPSdemux.frame+1,GPSdemux.frame+carried); //it was not a frame: look for another one in the carried bytes, before those of this buffer
+	}
+	if(p<end) scanFrames(p,end);
+	if(GPSdemux.NMEAparsed) NMEAparserCommit(); //NMEA data is spread in many sentences of the same epoch
+	if(GPSdemux.parsed) {
+		GPSreceiverPublish(); //make the new data visible to the other threads
+		RendererPush(); //and give it to the render thread
+	}
+	return GPSdemux.parsed;
+}
+
+void GPSdemuxGetStats(struct GPSdemuxStats *stats) { //to be called by the GPS thread
+	*stats=GPSdemux.stats;
+}
+
+const char* GPSdemuxProtocolName(enum GPSprotocol protocol) {
+	switch(protocol) {
+		case GPS_PROTOCOL_NMEA:
+			return "NMEA";
+		case GPS_PROTOCOL_SIRF:
+			return "SiRF";
+		case GPS_PROTOCOL_UBX:
+			return "UBX";
+		default:
+			return "none";
+	}
+}
+
+enum GPSprotocol protocolOf(unsigned char first) {
+	if(first==SIRF_START_1) return GPS_PROTOCOL_SIRF;
+	if(first==UBX_START_1) return GPS_PROTOCOL_UBX;
+	return GPS_PROTOCOL_NMEA;
+}
+
+int takeFrame(const unsigned char *start, int available) { //give the frame to its decoder: its length, 0 if more bytes are needed, -(bytes to skip) if not valid
+	enum GPSprotocol protocol=protocolOf(start[0]);
+	bool accepted=false;
+	int len;
+	if(protocol==GPS_PROTOCOL_NMEA) len=NMEAparserProcessSentence((const char*)start,available,&accepted); //measured in the same pass that splits it
+	else {
+		len=measureFrame(start,available);
+		if(len>available) return 0; //the frame continues in the next read
+		if(len>0) accepted=(protocol==GPS_PROTOCOL_SIRF)?SiRFparserProcessFrame(start,len):UBXparserProcessFrame(start,len);
+	}
+	if(len<0) { //not a frame or broken
+		countBroken(protocol,start,len);
+		return len;
+	}
+	if(len==0) return 0;
+	if(!accepted) { //discarded by the decoder: look for a frame inside it
+		GPSdemux.stats.protocol[protocol].errors++;
+		return -1;
+	}
+	GPSdemux.stats.protocol[protocol].frames++;
+	GPSdemux.stats.lastProtocol=protocol;
+	GPSdemux.parsed=true;
+	if(protocol==GPS_PROTOCOL_NMEA) GPSdemux.NMEAparsed=true;
+	return len;
+}
+
+int measureFrame(const unsigned char *start, int available) { //length of a binary frame, 0 if more bytes are needed, -(bytes to skip) if not valid
+	int len;
+	switch(start[0]) {
+		case SIRF_START_1: //A0 A2, length on 15 bits big endian, payload, checksum, B0 B3
+			if(available<2) return 0;
+			if(start[1]!=SIRF_START_2) return -1;
+			if(available<4) return 0;
+			len=(start[2]<<8)|start[3];
+			if(len==0 || len>SIRF_MAX_PAYLOAD) return -1;
+			return len+8;
+		case UBX_START_1: //B5 62, class, ID, length on 16 bits little endian, payload, checksum
+			if(available<2) return 0;
+			if(start[1]!=UBX_START_2) return -1;
+			if(available<6) return 0;
+			len=start[4]|(start[5]<<8);
+			if(len>UBX_MAX_PAYLOAD) return -1;
+			return len+8;
+		default:
+			return -1;
+	}
+}
+
+void scanFrames(const unsigned char *p, const unsigned char *end) { //find the frames and give them to their decoders
+	while(p<end) {
+		const unsigned char *start=p;
+		while(start<end && *start!=NMEA_START && *start!=SIRF_START_1 && *start!=UBX_START_1) start++; //only the line ends between NMEA sentences
+		GPSdemux.stats.noiseBytes+=start-p;
+		if(start==end) break; //nothing else
+		int available=end-start;
+		int len=takeFrame(start,available);
+		if(len>0) p=start+len; //complete frame
+		else if(len<0) p=start-len; //not a frame, broken or discarded: go on from where it ends
+		else { //the frame continues in the next read: keep its beginning
+			memmove(GPSdemux.frame,start,available); //it can be already in the carried bytes
+			GPSdemux.carriedBytes=available;
+			break;
+		}
+	}
+}
+
+void countBroken(enum GPSprotocol protocol, const unsigned char *start, int len) { //a broken frame or just a byte looking like a start?
+	bool synced;
+	if(protocol==GPS_PROTOCOL_NMEA) synced=(len<-1);
+	else synced=(start[1]==(protocol==GPS_PROTOCOL_SIRF?SIRF_START_2:UBX_START_2));
+	if(synced) GPSdemux.stats.protocol[protocol].errors++;
+	else GPSdemux.stats.noiseBytes++;
+}
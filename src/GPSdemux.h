@@ -0,0 +1,41 @@
+//============================================================================
+// Name        : GPSdemux.h
+// Since       : 17/10/2026
+// Author      : Alberto Realis-Luc <alberto.realisluc@gmail.com>
+// Web         : https://www.alus.it/airnavigator/
+// Copyright   : (C) 2010-2026 Alberto Realis-Luc
+// License     : GNU GPL v2
+// Repository  : https://github.com/alus-it/AirNavigator.git
+// Last change : 17/10/2026
+// Description : Header of the demultiplexer of the GPS protocols: GPSdemux.c
+//============================================================================
+
+#ifndef GPSDEMUX_H_
+#define GPSDEMUX_H_
+
+#include "Common.h"
+
+enum GPSprotocol {
+	GPS_PROTOCOL_NMEA, //$...*hh
+	GPS_PROTOCOL_SIRF, //A0 A2 ... B0 B3
+	GPS_PROTOCOL_UBX,  //B5 62 ...
+	GPS_PROTOCOLS,     //number of protocols
+	GPS_PROTOCOL_NONE  //still nothing received
+};
+
+struct GPSdemuxCounters {
+	unsigned long frames; //frames given to the decoder and accepted
+	unsigned long errors; //truncated, too long or with wrong checksum
+};
+
+struct GPSdemuxStats {
+	struct GPSdemuxCounters protocol[GPS_PROTOCOLS]; //indexed by enum GPSprotocol
+	unsigned long noiseBytes;                         //bytes out of any frame, like the line ends of NMEA
+	enum GPSprotocol lastProtocol;                    //of the last frame accepted
+};
+
+bool GPSdemuxProcessBuffer(const unsigned char *buf, int redBytes);
+void GPSdemuxGetStats(struct GPSdemuxStats *stats);
+const char* GPSdemuxProtocolName(enum GPSprotocol protocol);
+
+#endif /* GPSDEMUX_H_ */
@@ -6,47 +6,112 @@
 // Copyright   : (C) 2010-2020 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 21/03/2016
+// Last change : 17/10/2026
 // Description : Reads from a NMEA serial device NMEA sentences and parse them
 //============================================================================
 
 
-//#define SERIAL_DEVICE //to be enabled if reading from a real serial device
 //#define PRINT_RECEIVED_DATA
 
 #include <stdio.h>////
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <fcntl.h>
-#ifdef SERIAL_DEVICE
+#include <errno.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
 #include <termios.h>
-#endif
+#include <linux/serial.h>
 #include "GPSreceiver.h"
 #include "Configuration.h"
 #include "AirCalc.h"
 #include "Geoidal.h"
 #include "NMEAparser.h"
-#include "FBrender.h"
-#include "HSI.h"
+#include "SiRFparser.h"
+#include "GPSdemux.h"
+#include "UBXparser.h"
+#include "Renderer.h"
+#include "Navigator.h"
 #include "BlackBox.h"
+#include "Replay.h"
+
+// The GPS thread sleeps in epoll_wait on the device, on a wakeup descriptor written
+// to stop it at once and on a periodic timer checking how old the last frame is.
+// When no frame arrives for too long the fix is declared lost and then the device
+// is opened again; when it can't be opened it is tried again later, waiting each
+// time twice as long as the previous one.
+
+#if defined(__NR_eventfd)
+#define GPS_EVENTFD //glibc 2.3 has no wrappers for eventfd and timerfd: their system calls are used directly
+#endif
+#if defined(__NR_timerfd_create) && defined(__NR_timerfd_settime)
+#define GPS_TIMERFD
+#endif
+
+#if defined(TIOCGSERIAL) && defined(TIOCSSERIAL) && defined(ASYNC_LOW_LATENCY)
+#define GPS_LOW_LATENCY //the driver gives the received bytes at once instead of deferring them
+#endif
 
+#define GPS_TICK_MS      500   //period of the check of the input
+#define GPS_RETRY_MIN_MS 500   //first wait before opening again the device
+#define GPS_RETRY_MAX_MS 16000 //longest wait before opening again the device
+#define GPS_MAX_EVENTS   3     //device, wakeup and timer
 
 struct GPSreceiverStruct {
 	pthread_t thread;
-	volatile short reading; //-1 means still not initialized
-#ifdef SERIAL_DEVICE
-	long BAUD;
-	int DATABITS,STOPBITS,PARITYON,PARITY;
+	volatile short reading;         //-1 means still not initialized
+	volatile unsigned int sequence; //incremented before and after each publication: odd while writing
+	struct GPSdata published[2];    //the last two published copies of gps, readers take the newest complete one
+	int fd;                         //of the GPS device, -1 while closed
+	int epollFd;
+	int wakeFd[2];                  //the same eventfd twice or the read and write ends of a pipe
+	int timerFd;                    //-1 without timerfd: epoll_wait times out instead
+	struct timeval lastFrame;       //when the last frame was accepted or the device opened
+	struct timeval retryTime;       //when to open again the device
+	long retryDelayMs;              //next wait before opening again the device, 0 after a frame
+	bool stale;                     //no frame received within the stale timeout
+	bool timingEnabled;             //measure the time spent to navigate and to publish
+	struct GPSreceiverTiming timing;
+	speed_t baud;                   //of the serial port
+	tcflag_t dataBits,stopBits,parity;
+	bool isSerial;                  //the device is a serial port and not a pipe
+	struct termios oldtio;          //settings of the serial port to restore when closing it
+#ifdef GPS_LOW_LATENCY
+	int oldSerialFlags;             //-1 if the low latency mode was not set
 #endif
 };
 
 void configureGPSreceiver(void);
+bool openEvents(void);
+void closeEvents(void);
+bool openDevice(unsigned char *buf);
+void closeDevice(void);
+bool setupSerial(int fd);
+void restoreSerial(int fd);
+void scheduleReopen(void);
+void readDevice(unsigned char *buf);
+void checkInput(unsigned char *buf);
+void drainEvents(int fd);
 void* run(void *ptr);
+void printProtocolStats(void);
 
 static struct GPSreceiverStruct GPSreceiver = {
 	.reading=-1, //-1 means still not initialized
+	.sequence=0,
+	.fd=-1,
+	.epollFd=-1,
+	.wakeFd={-1,-1},
+	.timerFd=-1,
+	.retryDelayMs=0,
+	.stale=false,
+	.isSerial=false,
+	.timingEnabled=false
 };
 
 struct GPSdata gps = {
@@ -66,177 +131,389 @@ struct GPSdata gps = {
 	.pdop=50,
 	.hdop=50,
 	.vdop=50,
+	.latErrMt=-1,
+	.lonErrMt=-1,
+	.altErrMt=-1,
+	.suspectSat=-1,
 	.fixMode=MODE_UNKNOWN
 };
 
 void configureGPSreceiver(void) {
 	if(config.GPSdevName==NULL) config.GPSdevName=strdup("/var/run/gpsfeed"); //Default value
-#ifdef SERIAL_DEVICE
 	switch(config.GPSbaudRate) { //configuration of the serial port
+#ifdef B921600
+		case 921600:
+			GPSreceiver.baud=B921600;
+			break;
+#endif
+#ifdef B460800
+		case 460800:
+			GPSreceiver.baud=B460800;
+			break;
+#endif
 		case 230400:
-			BAUD=B230400;
+			GPSreceiver.baud=B230400;
 			break;
 		case 115200:
 		default:
-			BAUD=B115200;
+			GPSreceiver.baud=B115200;
 			break;
 		case 57600:
-			BAUD=B57600;
+			GPSreceiver.baud=B57600;
 			break;
 		case 38400:
-			BAUD=B38400;
+			GPSreceiver.baud=B38400;
 			break;
 		case 19200:
-			BAUD=B19200;
+			GPSreceiver.baud=B19200;
 			break;
 		case 9600:
-			BAUD=B9600;
+			GPSreceiver.baud=B9600;
 			break;
 		case 4800:
-			BAUD=B4800;
+			GPSreceiver.baud=B4800;
 			break;
 		case 2400:
-			BAUD=B2400;
+			GPSreceiver.baud=B2400;
 			break;
 		case 1800:
-			BAUD=B1800;
+			GPSreceiver.baud=B1800;
 			break;
 		case 1200:
-			BAUD=B1200;
+			GPSreceiver.baud=B1200;
 			break;
 		case 600:
-			BAUD=B600;
+			GPSreceiver.baud=B600;
 			break;
 		case 300:
-			BAUD=B300;
+			GPSreceiver.baud=B300;
 			break;
 		case 200:
-			BAUD=B200;
+			GPSreceiver.baud=B200;
 			break;
 		case 150:
-			BAUD=B150;
+			GPSreceiver.baud=B150;
 			break;
 		case 134:
-			BAUD=B134;
+			GPSreceiver.baud=B134;
 			break;
 		case 110:
-			BAUD=B110;
+			GPSreceiver.baud=B110;
 			break;
 		case 75:
-			BAUD=B75;
+			GPSreceiver.baud=B75;
 			break;
 		case 50:
-			BAUD=B50;
+			GPSreceiver.baud=B50;
 			break;
 	} //end of switch baud_rate
 	switch(config.GPSdataBits){
 		case 8:
 		default:
-			DATABITS=CS8;
+			GPSreceiver.dataBits=CS8;
 			break;
 		case 7:
-			DATABITS=CS7;
+			GPSreceiver.dataBits=CS7;
 			break;
 		case 6:
-			DATABITS=CS6;
+			GPSreceiver.dataBits=CS6;
 			break;
 		case 5:
-			DATABITS=CS5;
+			GPSreceiver.dataBits=CS5;
 			break;
 	} //end of switch data_bits
 	switch(config.GPSstopBits){
 		case 1:
 		default:
-			STOPBITS=0;
+			GPSreceiver.stopBits=0;
 			break;
 		case 2:
-			STOPBITS=CSTOPB;
+			GPSreceiver.stopBits=CSTOPB;
 			break;
 	} //end of switch stop bits
 	switch(config.GPSparity){
 		case 0:
 		default: //none
-			PARITYON=0;
-			PARITY=0;
+			GPSreceiver.parity=0;
 			break;
 		case 1: //odd
-			PARITYON=PARENB;
-			PARITY=PARODD;
+			GPSreceiver.parity=PARENB|PARODD;
 			break;
 		case 2: //even
-			PARITYON=PARENB;
-			PARITY=0;
+			GPSreceiver.parity=PARENB;
 			break;
 	} //end of switch parity
-#endif
 	GeoidalOpen();
-	pthread_mutex_init(&gps.mutex, NULL);
 	GPSreceiver.reading=0;
-	updateNumOfTotalSatsInView(0); //Display: at the moment we have no info from GPS
+	updateNumOfTotalSatsInView(0); //at the moment we have no info from GPS
 	updateNumOfActiveSats(0);
-	FBrenderFlush();
+	GPSreceiver.published[0]=gps;
+	GPSreceiver.published[1]=gps;
 }
 
-void* run(void *ptr) { //listening function, it will be ran in a separate thread
-	static int fd=-1;
-	fd=open(config.GPSdevName,O_RDONLY|O_NOCTTY|O_NONBLOCK); //read only, non blocking
-	if(fd>=0) {
-		#ifdef SERIAL_DEVICE
-		struct termios oldtio,newtio; //place for old and new port settings for serial port
-		tcgetattr(fd,&oldtio); // save current port settings
-		newtio.c_cflag=BAUD|CRTSCTS|DATABITS|STOPBITS|PARITYON|PARITY|CLOCAL|CREAD; // set new port settings for canonical input processing
-		newtio.c_iflag=IGNPAR;
-		newtio.c_oflag=0;
-		newtio.c_lflag=0; //ICANON;
-		newtio.c_cc[VMIN]=1;
-		newtio.c_cc[VTIME]=0;
-		tcsetattr(fd,TCSANOW,&newtio); // Set the new options for the port...
-		tcflush(fd,TCIFLUSH);
-		#endif
-		static unsigned char *buf=NULL; //read buffer
-		buf=(unsigned char *) malloc(NMEA_BUFFER_SIZE*sizeof(unsigned char));
-		if (buf!=NULL) {
-			int maxfd=fd+1;
-			fd_set readfs;
-			FD_SET(fd,&readfs);
-			int toRead_redBytes=0; // return flag of select() or number of bytes red
-			struct timeval timeout;
-			timeout.tv_sec = 5;
-			timeout.tv_usec = 0;
-			while(read(fd,buf,NMEA_BUFFER_SIZE)>0); // flush the stream
-			while(GPSreceiver.reading) { // loop while waiting for input
-				toRead_redBytes=select(maxfd,&readfs,NULL,NULL,&timeout); //wait to read because the read is now non-blocking
-				if(GPSreceiver.reading) { // further check if we want still to read after waiting
-					if(toRead_redBytes==1) {
-						toRead_redBytes=read(fd,buf,NMEA_BUFFER_SIZE);
-						NMEAparserProcessBuffer(buf,toRead_redBytes);
-						timeout.tv_sec = 5; // reset the timeout
-					} else {
-						GPSreceiver.reading=0;
-						if(toRead_redBytes==0) printLog("GPSreceiver: WARNING Nothing received on GPS serial port or pipe within 5 seconds, closing device.\n");
-						else printLog("GPSreceiver: ERROR Unable to wait for input on GPS serial port or pipe on the chosen device.\n");
-					}
-				}
+bool openEvents(void) { //the descriptors the GPS thread waits on
+	struct epoll_event ev;
+	GPSreceiver.epollFd=epoll_create(GPS_MAX_EVENTS);
+	if(GPSreceiver.epollFd<0) {
+		printLog("GPSreceiver: ERROR unable to create the epoll instance.\n");
+		return false;
+	}
+#ifdef GPS_EVENTFD
+	GPSreceiver.wakeFd[0]=syscall(__NR_eventfd,0);
+	if(GPSreceiver.wakeFd[0]>=0) GPSreceiver.wakeFd[1]=GPSreceiver.wakeFd[0];
+	else
+#endif
+	if(pipe(GPSreceiver.wakeFd)!=0) { //kernel without eventfd
+		GPSreceiver.wakeFd[0]=GPSreceiver.wakeFd[1]=-1;
+		printLog("GPSreceiver: ERROR unable to create the wakeup descriptor.\n");
+		closeEvents();
+		return false;
+	}
+	fcntl(GPSreceiver.wakeFd[0],F_SETFL,O_NONBLOCK);
+	fcntl(GPSreceiver.wakeFd[1],F_SETFL,O_NONBLOCK);
+	memset(&ev,0,sizeof(ev));
+	ev.events=EPOLLIN;
+	ev.data.fd=GPSreceiver.wakeFd[0];
+	epoll_ctl(GPSreceiver.epollFd,EPOLL_CTL_ADD,GPSreceiver.wakeFd[0],&ev);
+#ifdef GPS_TIMERFD
+	GPSreceiver.timerFd=syscall(__NR_timerfd_create,CLOCK_MONOTONIC,0);
+	if(GPSreceiver.timerFd>=0) {
+		struct itimerspec tick;
+		tick.it_interval.tv_sec=GPS_TICK_MS/1000;
+		tick.it_interval.tv_nsec=(GPS_TICK_MS%1000)*1000000;
+		tick.it_value=tick.it_interval;
+		ev.data.fd=GPSreceiver.timerFd;
+		if(fcntl(GPSreceiver.timerFd,F_SETFL,O_NONBLOCK)!=0 || syscall(__NR_timerfd_settime,GPSreceiver.timerFd,0,&tick,NULL)!=0 || epoll_ctl(GPSreceiver.epollFd,EPOLL_CTL_ADD,GPSreceiver.timerFd,&ev)!=0) {
+			close(GPSreceiver.timerFd);
+			GPSreceiver.timerFd=-1;
+		}
+	}
+#endif
+	return true;
+}
+
+void closeEvents(void) {
+	if(GPSreceiver.timerFd>=0) close(GPSreceiver.timerFd);
+	if(GPSreceiver.wakeFd[1]>=0 && GPSreceiver.wakeFd[1]!=GPSreceiver.wakeFd[0]) close(GPSreceiver.wakeFd[1]);
+	if(GPSreceiver.wakeFd[0]>=0) close(GPSreceiver.wakeFd[0]);
+	if(GPSreceiver.epollFd>=0) close(GPSreceiver.epollFd);
+	GPSreceiver.timerFd=GPSreceiver.wakeFd[0]=GPSreceiver.wakeFd[1]=GPSreceiver.epollFd=-1;
+}
+
+bool openDevice(unsigned char *buf) { //open the device and add it to the descriptors to wait on
+	struct epoll_event ev;
+	int fd;
+	if(config.GPSubxRate>0) fd=open(config.GPSdevName,O_RDWR|O_NOCTTY|O_NONBLOCK); //the receiver has to be configured
+	else fd=open(config.GPSdevName,O_RDONLY|O_NOCTTY|O_NONBLOCK); //read only, non blocking
+	if(fd<0) {
+		if(GPSreceiver.retryDelayMs==0) printLog("GPSreceiver: ERROR Can't open the GPS serial port or pipe on the chosen device, trying again.\n");
+		scheduleReopen();
+		return false;
+	}
+	if(!setupSerial(fd)) {
+		close(fd);
+		scheduleReopen();
+		return false;
+	}
+	while(read(fd,buf,NMEA_BUFFER_SIZE)>0); // flush the stream
+	if(config.GPSubxRate>0) UBXparserConfigure(fd,config.GPSubxRate); //ask for the UBX navigation messages
+	memset(&ev,0,sizeof(ev));
+	ev.events=EPOLLIN;
+	ev.data.fd=fd;
+	if(epoll_ctl(GPSreceiver.epollFd,EPOLL_CTL_ADD,fd,&ev)!=0) {
+		printLog("GPSreceiver: ERROR unable to wait for input on GPS serial port or pipe.\n");
+		restoreSerial(fd);
+		close(fd);
+		scheduleReopen();
+		return false;
+	}
+	GPSreceiver.fd=fd;
+	gettimeofday(&GPSreceiver.lastFrame,NULL); //the timeouts start now
+	return true;
+}
+
+void closeDevice(void) {
+	if(GPSreceiver.fd<0) return;
+	epoll_ctl(GPSreceiver.epollFd,EPOLL_CTL_DEL,GPSreceiver.fd,NULL);
+	restoreSerial(GPSreceiver.fd);
+	close(GPSreceiver.fd); //close the serial port
+	GPSreceiver.fd=-1;
+}
+
+bool setupSerial(int fd) { //raw mode with the settings of config.xml, nothing to do for a pipe like /var/run/gpsfeed
+	struct termios newtio; //place for new port settings for serial port
+	GPSreceiver.isSerial=isatty(fd);
+	if(!GPSreceiver.isSerial) return true;
+	if(tcgetattr(fd,&GPSreceiver.oldtio)!=0) { // save current port settings
+		printLog("GPSreceiver: ERROR unable to read the settings of the serial port.\n");
+		GPSreceiver.isSerial=false;
+		return false;
+	}
+	memset(&newtio,0,sizeof(newtio));
+	newtio.c_cflag=GPSreceiver.dataBits|GPSreceiver.stopBits|GPSreceiver.parity|CLOCAL|CREAD; //no modem lines and no flow control: a GPS has none
+	newtio.c_iflag=IGNPAR|IGNBRK; //no translation of CR and NL and no XON/XOFF: binary protocols pass untouched
+	newtio.c_oflag=0; //UBX configuration messages are sent as they are
+	newtio.c_lflag=0; //not canonical, no echo and no signals
+	newtio.c_cc[VMIN]=1; //epoll wakes up at the first byte and one read takes all the burst received so far
+	newtio.c_cc[VTIME]=0; //no timer between bytes delaying the wakeup
+	cfsetispeed(&newtio,GPSreceiver.baud);
+	cfsetospeed(&newtio,GPSreceiver.baud);
+	if(tcsetattr(fd,TCSANOW,&newtio)!=0) { // Set the new options for the port...
+		printLog("GPSreceiver: ERROR unable to configure the serial port.\n");
+		GPSreceiver.isSerial=false;
+		return false;
+	}
+	tcflush(fd,TCIOFLUSH);
+#ifdef GPS_LOW_LATENCY
+	GPSreceiver.oldSerialFlags=-1;
+	if(config.GPSlowLatency) {
+		struct serial_struct serial;
+		if(ioctl(fd,TIOCGSERIAL,&serial)==0) {
+			int oldFlags=serial.flags;
+			serial.flags|=ASYNC_LOW_LATENCY;
+			if(ioctl(fd,TIOCSSERIAL,&serial)==0) GPSreceiver.oldSerialFlags=oldFlags;
+		}
+		if(GPSreceiver.oldSerialFlags<0) printLog("GPSreceiver: WARNING unable to set the low latency mode of the serial port.\n");
+	}
+#else
+	if(config.GPSlowLatency) printLog("GPSreceiver: WARNING low latency mode of the serial port not supported.\n");
+#endif
+	return true;
+}
+
+void restoreSerial(int fd) {
+	if(!GPSreceiver.isSerial) return;
+#ifdef GPS_LOW_LATENCY
+	if(GPSreceiver.oldSerialFlags>=0) {
+		struct serial_struct serial;
+		if(ioctl(fd,TIOCGSERIAL,&serial)==0) {
+			serial.flags=GPSreceiver.oldSerialFlags;
+			ioctl(fd,TIOCSSERIAL,&serial);
+		}
+		GPSreceiver.oldSerialFlags=-1;
+	}
+#endif
+	tcsetattr(fd,TCSANOW,&GPSreceiver.oldtio); //restore old port settings
+	GPSreceiver.isSerial=false;
+}
+
+void scheduleReopen(void) { //exponential backoff, reset by the first frame received
+	long delay;
+	if(GPSreceiver.retryDelayMs<GPS_RETRY_MIN_MS) GPSreceiver.retryDelayMs=GPS_RETRY_MIN_MS;
+	delay=GPSreceiver.retryDelayMs;
+	gettimeofday(&GPSreceiver.retryTime,NULL);
+	GPSreceiver.retryTime.tv_usec+=(delay%1000)*1000;
+	GPSreceiver.retryTime.tv_sec+=delay/1000+GPSreceiver.retryTime.tv_usec/1000000;
+	GPSreceiver.retryTime.tv_usec%=1000000;
+	if(GPSreceiver.retryDelayMs<GPS_RETRY_MAX_MS) GPSreceiver.retryDelayMs*=2;
+}
+
+void readDevice(unsigned char *buf) {
+	int redBytes=read(GPSreceiver.fd,buf,NMEA_BUFFER_SIZE);
+	if(redBytes>0) {
+		if(GPSdemuxProcessBuffer(buf,redBytes)) { //NMEA, SiRF or UBX, even mixed
+			gettimeofday(&GPSreceiver.lastFrame,NULL);
+			GPSreceiver.retryDelayMs=0;
+			if(GPSreceiver.stale) {
+				GPSreceiver.stale=false;
+				printLog("GPSreceiver: receiving again from the GPS.\n");
 			}
-			#ifdef SERIAL_DEVICE
-			tcsetattr(fd,TCSANOW,&oldtio); //restore old port settings
-			#endif
-			free(buf);
-			buf=NULL;
-		} else printLog("GPSreceiver: ERROR unable to allocate read buffer.\n");
-		close(fd); //close the serial port
-	} else {
-		fd=-1;
-		printLog("ERROR: Can't open the GPS serial port or pipe on the chosen device.\n");
+		}
+	} else if(redBytes==0 || (errno!=EAGAIN && errno!=EINTR)) { //writer of the pipe gone or device removed
+		printLog("GPSreceiver: WARNING GPS serial port or pipe closed, opening it again.\n");
+		closeDevice();
+		scheduleReopen();
 	}
+}
+
+void checkInput(unsigned char *buf) { //timeouts of the input and reopening of the device
+	if(GPSreceiver.fd<0) {
+		if(elapsedUs(&GPSreceiver.retryTime)>=0) openDevice(buf);
+		return;
+	}
+	long quietMs=elapsedUs(&GPSreceiver.lastFrame)/1000;
+	if(!GPSreceiver.stale && config.GPSstaleTimeout>0 && quietMs>=config.GPSstaleTimeout*1000) {
+		GPSreceiver.stale=true;
+		printLog("GPSreceiver: WARNING nothing received from the GPS within %.1f seconds, fix lost.\n",config.GPSstaleTimeout);
+		updateFixMode(MODE_NO_FIX);
+		GPSreceiverPublish();
+		RendererPush();
+	}
+	if(config.GPSreconnectTimeout>0 && quietMs>=config.GPSreconnectTimeout*1000) {
+		printLog("GPSreceiver: WARNING nothing received from the GPS within %.1f seconds, opening the device again.\n",config.GPSreconnectTimeout);
+		closeDevice();
+		scheduleReopen();
+	}
+}
+
+void drainEvents(int fd) { //eventfd and timerfd give their 8 bytes counter, the pipe what was written
+	unsigned long long counter;
+	while(read(fd,&counter,sizeof(counter))>0);
+}
+
+void* run(void *ptr) { //listening function, it will be ran in a separate thread
+	struct epoll_event events[GPS_MAX_EVENTS];
+	if(config.GPSreplayFile!=NULL) { //replay recorded data instead of reading the device
+		ReplayRun(config.GPSreplayFile,config.GPSreplaySpeed,&GPSreceiver.reading);
+		GPSreceiver.reading=0;
+		pthread_exit(NULL);
+		return NULL;
+	}
+	static unsigned char *buf=NULL; //read buffer
+	buf=(unsigned char *) malloc(NMEA_BUFFER_SIZE*sizeof(unsigned char));
+	if(buf!=NULL) {
+		GPSreceiver.retryDelayMs=0;
+		openDevice(buf);
+		while(GPSreceiver.reading) { // loop while waiting for input
+			int i, num=epoll_wait(GPSreceiver.epollFd,events,GPS_MAX_EVENTS,GPSreceiver.timerFd>=0?-1:GPS_TICK_MS);
+			bool tick=(GPSreceiver.timerFd<0); //without timerfd the input is checked at each wakeup
+			if(num<0 && errno!=EINTR) {
+				printLog("GPSreceiver: ERROR Unable to wait for input on GPS serial port or pipe on the chosen device.\n");
+				break;
+			}
+			for(i=0;i<num && GPSreceiver.reading;i++) {
+				if(events[i].data.fd==GPSreceiver.fd) readDevice(buf);
+				else if(events[i].data.fd==GPSreceiver.timerFd) {
+					drainEvents(GPSreceiver.timerFd);
+					tick=true;
+				} else if(events[i].data.fd==GPSreceiver.wakeFd[0]) drainEvents(GPSreceiver.wakeFd[0]); //GPSreceiverClose() cleared reading
+			}
+			if(tick && GPSreceiver.reading) checkInput(buf);
+		}
+		closeDevice();
+		free(buf);
+		buf=NULL;
+		printProtocolStats();
+	} else printLog("GPSreceiver: ERROR unable to allocate read buffer.\n");
 	GPSreceiver.reading=0;
 	pthread_exit(NULL);
 	return NULL;
 }
 
+void printProtocolStats(void) { //frames received of each protocol and what the decoders did with them
+	struct GPSdemuxStats stats;
+	GPSdemuxGetStats(&stats);
+	for(int i=0;i<GPS_PROTOCOLS;i++) if(stats.protocol[i].frames>0 || stats.protocol[i].errors>0)
+		printLog("GPSreceiver: %s frames: %lu, wrong: %lu\n",GPSdemuxProtocolName(i),stats.protocol[i].frames,stats.protocol[i].errors);
+	printLog("GPSreceiver: bytes out of frames: %lu, last protocol: %s\n",stats.noiseBytes,GPSdemuxProtocolName(stats.lastProtocol));
+	struct NMEAparserStats nmea;
+	NMEAparserGetStats(&nmea);
+	if(nmea.sentences>0 || nmea.wrongSentences>0)
+		printLog("GPSreceiver: NMEA sentences: %lu, wrong: %lu, fixes: %lu\n",nmea.sentences,nmea.wrongSentences,nmea.fixes);
+	struct SiRFparserStats sirf;
+	SiRFparserGetStats(&sirf);
+	if(sirf.frames>0 || sirf.wrongFrames>0)
+		printLog("GPSreceiver: SiRF messages: %lu, wrong: %lu, ignored: %lu, fixes: %lu\n",sirf.frames,sirf.wrongFrames,sirf.ignoredFrames,sirf.fixes);
+	struct UBXparserStats ubx;
+	UBXparserGetStats(&ubx);
+	if(ubx.frames>0 || ubx.wrongFrames>0 || ubx.rejectedCfg>0)
+		printLog("GPSreceiver: UBX messages: %lu, wrong: %lu, ignored: %lu, fixes: %lu, rejected CFG: %lu\n",ubx.frames,ubx.wrongFrames,ubx.ignoredFrames,ubx.fixes,ubx.rejectedCfg);
+}
+
 char GPSreceiverStart(void) { //function to start the listening thread
 	if(GPSreceiver.reading==-1) configureGPSreceiver();
 	if(!GPSreceiver.reading) {
+		if(GPSreceiver.epollFd<0 && !openEvents()) return GPSreceiver.reading;
 		GPSreceiver.reading=1;
 		if(pthread_create(&GPSreceiver.thread,NULL,run,(void*)NULL)) {
 			GPSreceiver.reading=0;
@@ -247,10 +524,54 @@ char GPSreceiverStart(void) { //function to start the listening thread
 }
 
 void GPSreceiverClose(void) {
+	unsigned long long wake=1; //added to the eventfd counter
 	GPSreceiver.reading=0;
-	pthread_mutex_destroy(&gps.mutex);
+	if(GPSreceiver.wakeFd[1]>=0 && write(GPSreceiver.wakeFd[1],&wake,sizeof(wake))<0) printLog("GPSreceiver: WARNING unable to wake up the reading thread.\n");
+	pthread_join(GPSreceiver.thread,NULL); //wait for thread death, it does not wait for any timeout
+	closeEvents();
 	GeoidalClose();
-	pthread_join(GPSreceiver.thread,NULL); //wait for thread death
+}
+
+void GPSreceiverPublish(void) { //make the current gps data visible to the other threads, only the GPS thread can call it
+	struct timeval stageStart;
+	unsigned int seq=GPSreceiver.sequence;
+	struct GPSdata *slot=&GPSreceiver.published[((seq>>1)+1)&1]; //the older copy: readers are not using it
+	if(GPSreceiver.timingEnabled) gettimeofday(&stageStart,NULL);
+	GPSreceiver.sequence=seq+1;
+	MEMORY_BARRIER();
+	*slot=gps;
+	MEMORY_BARRIER();
+	GPSreceiver.sequence=seq+2;
+	GPSreceiver.timing.publications++;
+	if(GPSreceiver.timingEnabled) GPSreceiver.timing.publishUs+=elapsedUs(&stageStart);
+}
+
+void GPSreceiverNavigate(void) { //give the new position to the navigator, called by the decoders in the GPS thread
+	struct timeval stageStart;
+	GPSreceiver.timing.fixes++;
+	if(GPSreceiver.timingEnabled) gettimeofday(&stageStart,NULL);
+	NavUpdatePosition(gps.lat,gps.lon,gps.realAltMt,gps.speedKmh,gps.timestamp);
+	if(GPSreceiver.timingEnabled) GPSreceiver.timing.navUs+=elapsedUs(&stageStart);
+}
+
+void GPSreceiverEnableTiming(bool enable) {
+	GPSreceiver.timingEnabled=enable;
+}
+
+void GPSreceiverGetTiming(struct GPSreceiverTiming *timing) { //to be called by the GPS thread
+	*timing=GPSreceiver.timing;
+}
+
+unsigned int GPSgetSnapshot(struct GPSdata *snapshot) { //copy the last published gps data without blocking the GPS thread
+	unsigned int begin,end;
+	do {
+		begin=GPSreceiver.sequence;
+		MEMORY_BARRIER();
+		*snapshot=GPSreceiver.published[(begin>>1)&1]; //the newest complete copy
+		MEMORY_BARRIER();
+		end=GPSreceiver.sequence;
+	} while(end-(begin&~1u)>=3); //the writer started to overwrite the copy we were reading: retry
+	return begin>>1; //version of the data: number of publications
 }
 
 /*void updateHdiluition(float hDiluition) {
@@ -275,52 +596,59 @@ char updateDate(int newDay, int newMonth, int newYear) {
 		gps.month=newMonth;
 		gps.year=newYear;
 		if(gps.year<2000) gps.year+=2000;
-		//if(getMainStatus()==MAIN_DISPLAY_HSI) PrintDate(gps.day,gps.month,gps.year);
-		if(getMainStatus()==MAIN_DISPLAY_SUNRISE_SUNSET) {
-			//TODO: ....
-		}
 		return 1;
 	}
 	return 0;
 }
 
-void updateTime(float timestamp, int newHour, int newMin, float newSec, bool timeWithNoFix) {
+void updateTime(float timestamp, int newHour, int newMin, float newSec) {
 	if(gps.timestamp!=timestamp) {
 		gps.timestamp=timestamp;
 		gps.hour=newHour;
 		gps.minute=newMin;
 		gps.second=newSec;
-		if(getMainStatus()==MAIN_DISPLAY_HSI) {
-			PrintTime(gps.hour,gps.minute,gps.second,timeWithNoFix);
-			if(timeWithNoFix) FBrenderFlush();
-		} else if(getMainStatus()==MAIN_DISPLAY_SUNRISE_SUNSET) {
-			//TODO: ....
-
-			// Arrival location
-			// Remaining time to sunset or to sunrise
-			// Sunrise time, sunset time
-
-			// Current location
-			// Remaining time to sunset or to sunrise
-			// Sunrise time, sunset time
-
-			// Departure location
-			// Remaining time to sunset or to sunrise
-			// Sunrise time, sunset time
-		}
 	}
 }
 
+bool updatePosition(int newlatDeg, float newlatMin, bool newisLatN, int newlonDeg, float newlonMin, bool newisLonE, bool dateChaged) {
+	if(gps.latMinDecimal!=newlatMin||gps.lonMinDecimal!=newlonMin) {
+		gps.latDeg=newlatDeg;
+		gps.lonDeg=newlonDeg;
+		gps.latMinDecimal=newlatMin;
+		gps.lonMinDecimal=newlonMin;
+		gps.isLatN=newisLatN;
+		gps.isLonE=newisLonE;
+		gps.lat=latDegMin2rad(gps.latDeg,gps.latMinDecimal,gps.isLatN);
+		gps.lon=lonDegMin2rad(gps.lonDeg,gps.lonMinDecimal,gps.isLonE);
+		BlackBoxRecordPos(gps.lat,gps.lon,gps.timestamp,gps.hour,gps.minute,gps.second,gps.day,gps.month,gps.year,dateChaged);
+		return true;
+	}
+	return false;
+}
+
+bool updateLatLon(double latDeg, double lonDeg, bool dateChanged) { //from decimal degrees, North and East positive
+	int latD, lonD;
+	double latMin, lonMin;
+	convertDecimal2DegMin(fabs(latDeg),&latD,&latMin);
+	convertDecimal2DegMin(fabs(lonDeg),&lonD,&lonMin);
+	return updatePosition(latD,latMin,latDeg>=0,lonD,lonMin,lonDeg>=0,dateChanged);
+}
+
+void updateTrack(double speedMs, double trueTrack) {
+	double speedKmh=ms2Kmh(speedMs), magneticTrack;
+	if(gps.isMagVarToEast) magneticTrack=trueTrack-gps.magneticVariation; //with the last magnetic variation known
+	else magneticTrack=trueTrack+gps.magneticVariation;
+	updateGroundSpeedAndDirection(speedKmh,Km2Nm(speedKmh),trueTrack,magneticTrack);
+}
+
 void updateGroundSpeedAndDirection(float newSpeedKmh, float newSpeedKnots, float newTrueTrack, float newMagneticTrack) {
 	if(newSpeedKnots!=gps.speedKnots) {
 		gps.speedKnots=newSpeedKnots;
 		gps.speedKmh=newSpeedKmh;
-		if(getMainStatus()==MAIN_DISPLAY_HSI) PrintSpeed(newSpeedKmh,newSpeedKnots);
 	}
 	if(newSpeedKmh>2) if(newTrueTrack!=gps.trueTrack) {
 		gps.trueTrack=newTrueTrack;
 		gps.magneticTrack=newMagneticTrack;
-		if(getMainStatus()==MAIN_DISPLAY_HSI) HSIupdateDir(newTrueTrack);
 	}
 	BlackBoxRecordSpeed(Kmh2ms(newSpeedKmh));
 	if(gps.speedKmh>4) BlackBoxRecordCourse(newTrueTrack);
@@ -330,32 +658,43 @@ void updateSpeed(float newSpeedKnots) {
 	if(newSpeedKnots!=gps.speedKnots) {
 		gps.speedKnots=newSpeedKnots;
 		gps.speedKmh=Nm2Km(newSpeedKnots);
-		if(getMainStatus()==MAIN_DISPLAY_HSI) PrintSpeed(gps.speedKmh,gps.speedKnots);
 	}
 	BlackBoxRecordSpeed(Kmh2ms(gps.speedKmh));
 }
 
 void updateNumOfTotalSatsInView(int totalSats) {
-	if(gps.satsInView!=totalSats) {
-		gps.satsInView=totalSats;
-		if(getMainStatus()==MAIN_DISPLAY_HSI) PrintNumOfSats(gps.activeSats,gps.satsInView);
-	}
+	gps.satsInView=totalSats;
 }
 
 void updateNumOfActiveSats(int workingSats) {
-	if(gps.activeSats!=workingSats) {
-		gps.activeSats=workingSats;
-		if(getMainStatus()==MAIN_DISPLAY_HSI) PrintNumOfSats(gps.activeSats,gps.satsInView);
-	}
+	gps.activeSats=workingSats;
 }
 
 void updateFixMode(int fixMode) {
 	if(gps.fixMode!=fixMode) {
 		if(fixMode==MODE_GPS_FIX && (gps.fixMode==MODE_2D_FIX || gps.fixMode==MODE_3D_FIX)) return;
 		gps.fixMode=fixMode;
-		if(getMainStatus()==MAIN_DISPLAY_HSI) {
-			PrintFixMode(fixMode);
-			if(fixMode==MODE_NO_FIX) FBrenderFlush(); //because we want to show it immediately
-		}
 	}
 }
+
+void updatePositionErrors(float latErr, float lonErr, float altErr) {
+	gps.latErrMt=latErr;
+	gps.lonErrMt=lonErr;
+	gps.altErrMt=altErr;
+}
+
+void updateSuspectSat(int satId) {
+	gps.suspectSat=satId;
+}
+
+bool updateAltitudes(double newAltMt, double newRealAltMt) { //for receivers that give both the altitude on the ellipsoid and the one on m.s.l.
+	bool updateAlt=(newAltMt!=gps.altMt);
+	if(updateAlt) {
+		gps.altMt=newAltMt;
+		gps.altFt=m2Ft(newAltMt);
+		gps.realAltMt=newRealAltMt;
+		gps.realAltFt=m2Ft(newRealAltMt);
+	}
+	BlackBoxRecordAlt(gps.realAltMt);
+	return updateAlt;
+}
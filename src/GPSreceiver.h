@@ -6,7 +6,7 @@
 // Copyright   : (C) 2010-2020 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 12/12/2013
+// Last change : 17/10/2026
 // Description : Reads from a NMEA serial device NMEA sentences and parse them
 //============================================================================
 
@@ -71,27 +71,45 @@ struct GPSdata {
 	bool isLatN,isLonE;                            //true if latitude is to North, true if longitude is to East
 	double lat,lon;                                //latitude and longitude expressed in rad
 	float pdop,hdop,vdop;                          //P,H,V dilutions in m
+	float latErrMt,lonErrMt,altErrMt;              //expected errors of latitude, longitude and altitude in m, -1 if unknown
+	int suspectSat;                                //ID of the satellite most likely failed according to the GPS (RAIM), -1 if none
 	char activeSats,satsInView;                    //used and visible sats
 	enum GPSmode fixMode;                          //type of fix
 	int signalStrength,SNR,beaconDataRate,channel; //data about GPS signal (not used)
 	int beaconFrequency;                           //beacon frequency of GPS signal (not used)
 	int satellites[MAX_NUM_SAT][3];                //matrix of detected satellites
-	pthread_mutex_t mutex;                         //mutex for reading and writing GPS data in this struct
 };
 
-struct GPSdata gps;
+struct GPSreceiverTiming {
+	unsigned long fixes;            //positions given to the navigator
+	unsigned long publications;     //times the new data has been published to the other threads
+	long long navUs, publishUs;     //total time spent to update the navigation and to publish the data, only with timing enabled
+};
+
+struct GPSdata gps; //working copy, to be used only by the GPS thread: the others use GPSgetSnapshot
 
 char GPSreceiverStart(void);
 void GPSreceiverStop(void);
 void GPSreceiverClose(void);
+void GPSreceiverPublish(void);
+void GPSreceiverNavigate(void);
+void GPSreceiverEnableTiming(bool enable);
+void GPSreceiverGetTiming(struct GPSreceiverTiming *timing);
+unsigned int GPSgetSnapshot(struct GPSdata *snapshot);
 
 char updateDate(int newDay, int newMonth, int newYear);
-void updateTime(float timestamp, int newHour, int newMin, float newSec, bool timeWithNoFix);
+void updateTime(float timestamp, int newHour, int newMin, float newSec);
+bool updatePosition(int newlatDeg, float newlatMin, bool newisLatN, int newlonDeg, float newlonMin, bool newisLonE, bool dateChaged);
+bool updateAltitudes(double newAltMt, double newRealAltMt);
+bool updateLatLon(double latDeg, double lonDeg, bool dateChanged);
+void updateTrack(double speedMs, double trueTrack);
 void updateGroundSpeedAndDirection(float newSpeedKmh, float newSpeedKnots, float newTrueTrack, float newMagneticTrack);
 void updateSpeed(float newSpeedKnots);
 void updateNumOfTotalSatsInView(int totalSats);
 void updateNumOfActiveSats(int workingSats);
 void updateFixMode(int fixMode);
+void updatePositionErrors(float latErr, float lonErr, float altErr);
+void updateSuspectSat(int satId);
 //void updateHdiluition(float hDiluition);
 //void updateDiluition(float pDiluition, float hDiluition, float vDiluition);
 
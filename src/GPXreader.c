@@ -0,0 +1,448 @@
+//============================================================================
+// Name        : GPXreader.c
+// Since       : 17/10/2026
+// Author      : Alberto Realis-Luc <alberto.realisluc@gmail.com>
+// Web         : https://www.alus.it/airnavigator/
+// Copyright   : (C) 2010-2026 Alberto Realis-Luc
+// License     : GNU GPL v2
+// Repository  : https://github.com/alus-it/AirNavigator.git
+// Last change : 17/10/2026
+// Description : Streaming reader of the waypoints, routes and tracks of GPX files
+//============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "GPXreader.h"
+
+// The file is read in blocks and parsed one character at the time by a state machine,
+// without building the tree of the document: the memory used does not depend on the
+// size of the file. Only the elements of the points, the <name> and <ele> inside them
+// and the elements counting the routes, the tracks and the segments are looked at,
+// everything else is skipped. Namespace prefixes are ignored.
+
+#define GPX_BUFFER_SIZE 4096
+#define GPX_MAX_TAG     32 //longer names of elements and attributes are truncated
+#define GPX_MAX_VALUE   64 //longer values of attributes are truncated
+#define GPX_MAX_ENTITY  10
+
+enum parserState {
+	ST_TEXT,       //content of an element
+	ST_ENTITY,     //after '&' in the content
+	ST_TAG,        //after '<'
+	ST_START_NAME, //name of a start tag
+	ST_ATTRS,      //between the attributes of a start tag
+	ST_ATTR_NAME,
+	ST_ATTR_EQUAL, //after the name of an attribute, waiting for '='
+	ST_ATTR_QUOTE, //after '=', waiting for the quote
+	ST_ATTR_VALUE,
+	ST_SELF_CLOSE, //after '/' in a start tag
+	ST_END_NAME,   //name of an end tag
+	ST_PI,         //processing instruction or XML declaration
+	ST_BANG,       //after "<!"
+	ST_COMMENT,
+	ST_CDATA,
+	ST_DECL        //DOCTYPE or other declaration
+};
+
+enum captureType { CAPTURE_NONE, CAPTURE_ELE, CAPTURE_NAME };
+
+struct GPXparser {
+	enum parserState state;
+	GPXpointCallback callback;
+	void *data;
+	int percent;                    //of the file read so far
+	int depth;                      //number of elements open
+	int pointDepth;                 //depth of the point element open, 0 when none
+	enum captureType capture;       //child of the point whose content is being kept
+	int captureDepth;
+	bool hasLat, hasLon;
+	int routes, tracks, segments;   //seen so far, segments in the current track
+	int waypoints, routePoints, trackPoints; //in the file, in the current route and in the current segment
+	int emitted;                    //number of points given to the callback
+	bool stop;                      //the callback asked to stop
+	struct GPXpoint point;
+	char tag[GPX_MAX_TAG];
+	int tagLen;
+	char attr[GPX_MAX_TAG];
+	int attrLen;
+	char value[GPX_MAX_VALUE];
+	int valueLen;
+	char text[GPX_MAX_NAME_LENGTH]; //content of the <name> or <ele> of the point
+	int textLen;
+	char entity[GPX_MAX_ENTITY];
+	int entityLen;
+	char bang[8];
+	int bangLen;
+	char quote;
+	int marks;                      //consecutive '-', ']' or '?' before the end of comments, CDATA and PIs
+	int declDepth;                  //nesting of '[' in declarations
+};
+
+bool isBlank(const char c);
+const char* localName(const char *name);
+bool parseNumber(const char *s, double *value);
+void appendName(char *buf, int *len, const char c);
+void appendText(struct GPXparser *p, const char c);
+void decodeEntity(struct GPXparser *p);
+char* trimText(char *text);
+void beginPoint(struct GPXparser *p, const enum GPXpointType type);
+void openElement(struct GPXparser *p);
+void setAttribute(struct GPXparser *p);
+void finishCapture(struct GPXparser *p);
+void closeElement(struct GPXparser *p);
+bool isBangPrefix(const struct GPXparser *p);
+void parseChar(struct GPXparser *p, const char c);
+
+bool isBlank(const char c) {
+	return c==' ' || c=='\t' || c=='\n' || c=='\r';
+}
+
+const char* localName(const char *name) { //skip the namespace prefix
+	const char *colon=strchr(name,':');
+	return colon!=NULL?colon+1:name;
+}
+
+bool parseNumber(const char *s, double *value) { //decimal number without going through strtod and the locale
+	static const double powers[]={1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+	long long mantissa=0;
+	int digits=0, scale=0, exponent=0;
+	bool negative=false, any=false;
+	while(isBlank(*s)) s++;
+	if(*s=='-' || *s=='+') negative=(*s++=='-');
+	for(;*s>='0' && *s<='9';s++) {
+		any=true;
+		if(digits<18) {
+			mantissa=mantissa*10+(*s-'0');
+			if(mantissa>0) digits++;
+		} else scale++; //digits beyond the precision of the mantissa
+	}
+	if(*s=='.') for(s++;*s>='0' && *s<='9';s++) {
+		any=true;
+		if(digits<18) {
+			mantissa=mantissa*10+(*s-'0');
+			if(mantissa>0) digits++;
+			scale--;
+		}
+	}
+	if(!any) return false;
+	if(*s=='e' || *s=='E') {
+		bool negExp=false;
+		s++;
+		if(*s=='-' || *s=='+') negExp=(*s++=='-');
+		for(;*s>='0' && *s<='9';s++) if(exponent<1000) exponent=exponent*10+(*s-'0');
+		if(negExp) exponent=-exponent;
+	}
+	while(isBlank(*s)) s++;
+	if(*s!='\0') return false;
+	scale+=exponent;
+	*value=(double)mantissa;
+	if(scale>0) *value*=scale<=22?powers[scale]:pow(10,scale);
+	else if(scale<0) *value/=scale>=-22?powers[-scale]:pow(10,-scale);
+	if(negative) *value=-*value;
+	return true;
+}
+
+void appendName(char *buf, int *len, const char c) {
+	if(*len<GPX_MAX_TAG-1) buf[(*len)++]=c;
+}
+
+void appendText(struct GPXparser *p, const char c) {
+	if(p->textLen<GPX_MAX_NAME_LENGTH-1) p->text[p->textLen++]=c;
+}
+
+void decodeEntity(struct GPXparser *p) {
+	unsigned long code=0;
+	p->entity[p->entityLen]='\0';
+	if(p->entity[0]=='#') {
+		if(p->entity[1]=='x' || p->entity[1]=='X') code=strtoul(p->entity+2,NULL,16);
+		else code=strtoul(p->entity+1,NULL,10);
+		if(code==0 || code>0x10FFFF) return;
+	} else if(strcmp(p->entity,"amp")==0) code='&';
+	else if(strcmp(p->entity,"lt")==0) code='<';
+	else if(strcmp(p->entity,"gt")==0) code='>';
+	else if(strcmp(p->entity,"quot")==0) code='"';
+	else if(strcmp(p->entity,"apos")==0) code='\'';
+	else return; //unknown entity: dropped
+	if(code<0x80) appendText(p,(char)code);
+	else if(code<0x800) { //encoded in UTF-8 as the rest of the file
+		appendText(p,(char)(0xC0|(code>>6)));
+		appendText(p,(char)(0x80|(code&0x3F)));
+	} else if(code<0x10000) {
+		appendText(p,(char)(0xE0|(code>>12)));
+		appendText(p,(char)(0x80|((code>>6)&0x3F)));
+		appendText(p,(char)(0x80|(code&0x3F)));
+	} else {
+		appendText(p,(char)(0xF0|(code>>18)));
+		appendText(p,(char)(0x80|((code>>12)&0x3F)));
+		appendText(p,(char)(0x80|((code>>6)&0x3F)));
+		appendText(p,(char)(0x80|(code&0x3F)));
+	}
+}
+
+char* trimText(char *text) {
+	int len;
+	while(isBlank(*text)) text++;
+	len=strlen(text);
+	while(len>0 && isBlank(text[len-1])) text[--len]='\0';
+	return text;
+}
+
+void beginPoint(struct GPXparser *p, const enum GPXpointType type) {
+	memset(&p->point,0,sizeof(struct GPXpoint));
+	p->point.type=type;
+	switch(type) {
+		case GPX_WAYPOINT:
+			p->point.seqNo=p->waypoints++;
+			break;
+		case GPX_ROUTE_POINT:
+			p->point.list=p->routes>0?p->routes-1:0;
+			p->point.seqNo=p->routePoints++;
+			break;
+		case GPX_TRACK_POINT:
+			p->point.list=p->tracks>0?p->tracks-1:0;
+			p->point.segment=p->segments>0?p->segments-1:0;
+			p->point.seqNo=p->trackPoints++;
+			break;
+	}
+	p->hasLat=false;
+	p->hasLon=false;
+	p->pointDepth=p->depth+1;
+}
+
+void openElement(struct GPXparser *p) { //the name is in tag, depth is still the one of the parent
+	const char *name=localName(p->tag);
+	if(p->pointDepth>0) { //inside a point only its name and elevation are kept
+		if(p->depth==p->pointDepth && p->capture==CAPTURE_NONE) {
+			if(strcmp(name,"ele")==0) p->capture=CAPTURE_ELE;
+			else if(strcmp(name,"name")==0) p->capture=CAPTURE_NAME;
+			if(p->capture!=CAPTURE_NONE) {
+				p->captureDepth=p->depth+1;
+				p->textLen=0;
+			}
+		}
+		return;
+	}
+	if(strcmp(name,"wpt")==0) beginPoint(p,GPX_WAYPOINT);
+	else if(strcmp(name,"rtept")==0) beginPoint(p,GPX_ROUTE_POINT);
+	else if(strcmp(name,"trkpt")==0) beginPoint(p,GPX_TRACK_POINT);
+	else if(strcmp(name,"rte")==0) {
+		p->routes++;
+		p->routePoints=0;
+	} else if(strcmp(name,"trk")==0) {
+		p->tracks++;
+		p->segments=0;
+	} else if(strcmp(name,"trkseg")==0) {
+		p->segments++;
+		p->trackPoints=0;
+	}
+}
+
+void setAttribute(struct GPXparser *p) {
+	const char *name;
+	if(p->pointDepth!=p->depth+1) return; //only the attributes of the point element are needed
+	name=localName(p->attr);
+	if(strcmp(name,"lat")==0) p->hasLat=parseNumber(p->value,&p->point.lat);
+	else if(strcmp(name,"lon")==0) p->hasLon=parseNumber(p->value,&p->point.lon);
+}
+
+void finishCapture(struct GPXparser *p) {
+	char *text;
+	p->text[p->textLen]='\0';
+	text=trimText(p->text);
+	if(p->capture==CAPTURE_ELE) p->point.hasEle=parseNumber(text,&p->point.ele);
+	else strcpy(p->point.name,text);
+	if(!p->point.hasEle) p->point.ele=0;
+	p->capture=CAPTURE_NONE;
+}
+
+void closeElement(struct GPXparser *p) { //depth is the one of the element closed
+	if(p->capture!=CAPTURE_NONE && p->depth==p->captureDepth) finishCapture(p);
+	if(p->pointDepth>0 && p->depth==p->pointDepth) {
+		p->pointDepth=0;
+		if(p->hasLat && p->hasLon) {
+			p->emitted++;
+			if(!p->callback(&p->point,p->percent,p->data)) p->stop=true;
+		} else printLog("GPXreader: WARNING point without coordinates skipped\n");
+	}
+	if(p->depth>0) p->depth--;
+}
+
+bool isBangPrefix(const struct GPXparser *p) { //what follows "<!" can still be a comment or a CDATA
+	return (p->bangLen<=2 && strncmp(p->bang,"--",p->bangLen)==0) || (p->bangLen<=7 && strncmp(p->bang,"[CDATA[",p->bangLen)==0);
+}
+
+void parseChar(struct GPXparser *p, const char c) {
+	switch(p->state) {
+		case ST_TEXT:
+			if(c=='<') p->state=ST_TAG;
+			else if(p->capture!=CAPTURE_NONE) {
+				if(c=='&') {
+					p->entityLen=0;
+					p->state=ST_ENTITY;
+				} else appendText(p,c);
+			}
+			break;
+		case ST_ENTITY:
+			if(c==';') {
+				decodeEntity(p);
+				p->state=ST_TEXT;
+			} else if(c=='<') p->state=ST_TAG; //not an entity: dropped
+			else if(p->entityLen<GPX_MAX_ENTITY-1) p->entity[p->entityLen++]=c;
+			else p->state=ST_TEXT;
+			break;
+		case ST_TAG:
+			p->tagLen=0;
+			if(c=='/') p->state=ST_END_NAME;
+			else if(c=='?') {
+				p->marks=0;
+				p->state=ST_PI;
+			} else if(c=='!') {
+				p->bangLen=0;
+				p->state=ST_BANG;
+			} else {
+				appendName(p->tag,&p->tagLen,c);
+				p->state=ST_START_NAME;
+			}
+			break;
+		case ST_START_NAME:
+			if(isBlank(c) || c=='/' || c=='>') {
+				p->tag[p->tagLen]='\0';
+				openElement(p);
+				if(c=='/') p->state=ST_SELF_CLOSE;
+				else if(c=='>') {
+					p->depth++;
+					p->state=ST_TEXT;
+				} else p->state=ST_ATTRS;
+			} else appendName(p->tag,&p->tagLen,c);
+			break;
+		case ST_ATTRS:
+			if(c=='/') p->state=ST_SELF_CLOSE;
+			else if(c=='>') {
+				p->depth++;
+				p->state=ST_TEXT;
+			} else if(!isBlank(c)) {
+				p->attrLen=0;
+				appendName(p->attr,&p->attrLen,c);
+				p->state=ST_ATTR_NAME;
+			}
+			break;
+		case ST_ATTR_NAME:
+			if(c=='=') p->state=ST_ATTR_QUOTE;
+			else if(isBlank(c)) p->state=ST_ATTR_EQUAL;
+			else appendName(p->attr,&p->attrLen,c);
+			break;
+		case ST_ATTR_EQUAL:
+			if(c=='=') p->state=ST_ATTR_QUOTE;
+			break;
+		case ST_ATTR_QUOTE:
+			if(c=='"' || c=='\'') {
+				p->quote=c;
+				p->valueLen=0;
+				p->state=ST_ATTR_VALUE;
+			}
+			break;
+		case ST_ATTR_VALUE:
+			if(c==p->quote) {
+				p->attr[p->attrLen]='\0';
+				p->value[p->valueLen]='\0';
+				setAttribute(p);
+				p->state=ST_ATTRS;
+			} else if(p->valueLen<GPX_MAX_VALUE-1) p->value[p->valueLen++]=c;
+			break;
+		case ST_SELF_CLOSE:
+			if(c=='>') {
+				p->depth++;
+				closeElement(p);
+				p->state=ST_TEXT;
+			}
+			break;
+		case ST_END_NAME:
+			if(c=='>') {
+				p->tag[p->tagLen]='\0';
+				closeElement(p);
+				p->state=ST_TEXT;
+			} else if(!isBlank(c)) appendName(p->tag,&p->tagLen,c);
+			break;
+		case ST_PI:
+			if(c=='>' && p->marks>0) p->state=ST_TEXT;
+			p->marks=(c=='?');
+			break;
+		case ST_BANG:
+			p->bang[p->bangLen++]=c;
+			if(p->bangLen==2 && p->bang[0]=='-' && p->bang[1]=='-') {
+				p->marks=0;
+				p->state=ST_COMMENT;
+			} else if(p->bangLen==7 && strncmp(p->bang,"[CDATA[",7)==0) {
+				p->marks=0;
+				p->state=ST_CDATA;
+			} else if(!isBangPrefix(p)) {
+				p->declDepth=0;
+				p->state=ST_DECL;
+				if(c=='>') p->state=ST_TEXT;
+			}
+			break;
+		case ST_COMMENT:
+			if(c=='>' && p->marks>=2) p->state=ST_TEXT;
+			p->marks=(c=='-')?p->marks+1:0;
+			break;
+		case ST_CDATA:
+			if(c==']') p->marks++;
+			else if(c=='>' && p->marks>=2) {
+				if(p->capture!=CAPTURE_NONE) for(;p->marks>2;p->marks--) appendText(p,']');
+				p->state=ST_TEXT;
+			} else {
+				if(p->capture!=CAPTURE_NONE) {
+					for(;p->marks>0;p->marks--) appendText(p,']');
+					appendText(p,c);
+				}
+				p->marks=0;
+			}
+			break;
+		case ST_DECL:
+			if(c=='[') p->declDepth++;
+			else if(c==']') p->declDepth--;
+			else if(c=='>' && p->declDepth<=0) p->state=ST_TEXT;
+			break;
+	}
+}
+
+int GPXreaderParse(const char *fileName, GPXpointCallback callback, void *data) {
+	struct GPXparser parser;
+	struct stat st;
+	char buffer[GPX_BUFFER_SIZE];
+	long long size=0, done=0;
+	int i, len=0, fd;
+	if(fileName==NULL || callback==NULL) return -1;
+	fd=open(fileName,O_RDONLY);
+	if(fd<0) {
+		printLog("GPXreader: ERROR unable to open: %s\n",fileName);
+		return -1;
+	}
+	if(fstat(fd,&st)==0) size=st.st_size;
+	memset(&parser,0,sizeof(struct GPXparser));
+	parser.state=ST_TEXT;
+	parser.capture=CAPTURE_NONE;
+	parser.callback=callback;
+	parser.data=data;
+	while(!parser.stop && (len=read(fd,buffer,GPX_BUFFER_SIZE))>0) {
+		done+=len;
+		if(size>0) parser.percent=done<size?(int)(done*100/size):100;
+		for(i=0;i<len && !parser.stop;i++) parseChar(&parser,buffer[i]);
+	}
+	close(fd);
+	if(parser.stop) return parser.emitted;
+	if(len<0) {
+		printLog("GPXreader: ERROR while reading: %s\n",fileName);
+		return -2;
+	}
+	if(parser.depth>0 || parser.state!=ST_TEXT) {
+		printLog("GPXreader: ERROR %s ends inside an element\n",fileName);
+		return -2;
+	}
+	return parser.emitted;
+}
@@ -0,0 +1,43 @@
+//============================================================================
+// Name        : GPXreader.h
+// Since       : 17/10/2026
+// Author      : Alberto Realis-Luc <alberto.realisluc@gmail.com>
+// Web         : https://www.alus.it/airnavigator/
+// Copyright   : (C) 2010-2026 Alberto Realis-Luc
+// License     : GNU GPL v2
+// Repository  : https://github.com/alus-it/AirNavigator.git
+// Last change : 17/10/2026
+// Description : Header of the streaming GPX reader: GPXreader.c
+//============================================================================
+
+#ifndef GPXREADER_H_
+#define GPXREADER_H_
+
+#include "Common.h"
+
+#define GPX_MAX_NAME_LENGTH 64 //longer names are truncated
+
+enum GPXpointType {
+	GPX_WAYPOINT,    //<wpt>
+	GPX_ROUTE_POINT, //<rtept> of a <rte>
+	GPX_TRACK_POINT  //<trkpt> of a <trkseg> of a <trk>
+};
+
+struct GPXpoint {
+	enum GPXpointType type;
+	int list;                        //number of the route or of the track in the file from 0, always 0 for waypoints
+	int segment;                     //number of the segment in the track from 0, always 0 for the others
+	int seqNo;                       //number of the point in its route, track segment or among the waypoints
+	double lat, lon;                 //degrees, North and East positive as in the GPX
+	double ele;                      //meters, 0 when missing
+	bool hasEle;
+	char name[GPX_MAX_NAME_LENGTH];  //empty when missing
+};
+
+// Called for each point as soon as its element is closed, with the percent of the file read.
+// Returning false stops the reading.
+typedef bool (*GPXpointCallback)(const struct GPXpoint *point, int percent, void *data);
+
+int GPXreaderParse(const char *fileName, GPXpointCallback callback, void *data);
+
+#endif /* GPXREADER_H_ */
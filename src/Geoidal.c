@@ -6,7 +6,7 @@
 // Copyright   : (C) 2010-2020 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 10/2/2013
+// Last change : 17/10/2026
 // Description : Estimates geoidal separation from WGS86 to main sea level
 //============================================================================
 
@@ -14,7 +14,12 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "Geoidal.h"
 
 #define GEOID_H 19
@@ -24,9 +29,41 @@
 #define EGM96_W 180
 #define EGM96SIZE EGM96_W * EGM96_H //16200
 
+#define GEOID_GRID_FILE   "geoid.dat"  //finer grid, preferred to the EGM96 file when present
+#define GEOID_GRID_MAGIC  "GEOD"
+#define GEOID_HEADER_SIZE 8            //magic, width and height as little endian 16 bit integers
+#define GEOID_MAX_SIZE    10800        //samples in a row or rows: up to 2 minutes of degree
+
+
+enum geoidFormat {
+	GEOID_EGM96,   //egm96s.dem: 90 rows from 90N to 88S of 180 bytes from 0E each 2 degrees, meters+127
+	GEOID_GRID     //geoid.dat: header, then rows from 90N to 90S of 16 bit little endian samples in cm from 0E eastward
+};
+
+struct GeoidalStruct {
+	unsigned char *map;            //the whole geoid file mapped read-only, NULL when not open
+	size_t mapSize;
+	const unsigned char *data;     //first sample of the grid in the file
+	enum geoidFormat format;
+	int width, height;             //samples in each row and rows
+	double cellsPerDegLat, cellsPerDegLon;
+	int cacheLat, cacheLon;        //cell of the cached coefficients, -1 if none
+	double c0, cx, cy, cxy;        //bilinear interpolation in the cached cell: c0+cx*x+cy*y+cxy*x*y
+};
 
 double interpolation2d(double x, double y, double z11, double z12, double z21, double z22);
-double getEGM96data(int x, int y);
+bool mapGeoidFile(const char *fileName);
+bool setGeoidFormat(void);
+double getGridData(int x, int y);
+void cacheCell(int ilon, int ilat);
+
+static struct GeoidalStruct Geoidal = {
+	.map=NULL,
+	.mapSize=0,
+	.data=NULL,
+	.cacheLat=-1,
+	.cacheLon=-1
+};
 
 const short geoid_data[GEOID_H][GEOID_W]={ //From: www.gliding.ch/manuels/flarm_obstacle_v3.00_en.pdf Source: US NIMA Technical Report ref: DMA TR 8350.2 Table 6.1
 /*       -180,-170,...                                                            ,0,                                 ...,180   */
@@ -50,8 +87,6 @@ const short geoid_data[GEOID_H][GEOID_W]={ //From: www.gliding.ch/manuels/flarm_
 /* 80 */{   3,  1, -2, -3, -3, -3, -1,  3,  1,  5,  9, 11, 19, 27, 31, 34, 33, 34, 33, 34, 28, 23, 17, 13,  9,  4,   4,  1, -2, -2,  0,  2,  3,  2,  1,  1,  3}, //17
 /* 90 */{  13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,  13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13}};//18
 
-unsigned char* egm96data=NULL;
-
 double interpolation2d(double x, double y, double z11, double z12, double z21, double z22) {
 	return (z22*y*x+z12*(1-y)*x+z21*y*(1-x)+z11*(1-y)*(1-x)); //x and y must be between 0 and 1
 }
@@ -71,66 +106,105 @@ double wgs84_to_msl_delta(double lat, double lon) { //It uses the data hard-code
 			(double)geoid_data[lati+1][loni+1]));
 }
 
-bool GeoidalOpen() {
-	if(egm96data!=NULL) return true; //The data seems already loaded do nothing
-	FILE *egm96dataFile=NULL;
-	char *egmPath;
-	asprintf(&egmPath,"%segm96s.dem",BASE_PATH);
-	egm96dataFile=fopen(egmPath,"rb");
-	free(egmPath);
-	if(egm96dataFile==NULL) {
-		printLog("ERROR: Unable to open the egm96 geoidal separation data file.\n");
+bool mapGeoidFile(const char *fileName) { //The file is mapped read-only: no copy in memory and no time spent to read it at startup
+	char *path;
+	struct stat st;
+	asprintf(&path,"%s%s",BASE_PATH,fileName);
+	int fd=open(path,O_RDONLY);
+	free(path);
+	if(fd<0) return false;
+	if(fstat(fd,&st)<0 || st.st_size<GEOID_HEADER_SIZE) {
+		close(fd);
 		return false;
 	}
-	int len=0;
-	fseek(egm96dataFile,0,SEEK_END);
-	len=ftell(egm96dataFile);
-	fseek(egm96dataFile,0,SEEK_SET);
-	if(len==EGM96SIZE) {
-		egm96data=(unsigned char*)malloc(len+1);
-		if(egm96data==NULL) {
-			fclose(egm96dataFile);
-			printLog("ERROR: Unable to load in memory the egm96 data.\n");
-			return true;
-		}
-		fread(egm96data,len,1,egm96dataFile);
-	} else {
-		fclose(egm96dataFile);
-		printLog("ERROR: The egm96 geoidal separation data file has not the expected size.\n");
+	void *map=mmap(NULL,st.st_size,PROT_READ,MAP_SHARED,fd,0);
+	close(fd); //the mapping remains valid
+	if(map==MAP_FAILED) {
+		printLog("ERROR: Unable to map in memory the geoidal separation data file %s.\n",fileName);
 		return false;
 	}
-	fclose(egm96dataFile);
+	Geoidal.map=(unsigned char*)map;
+	Geoidal.mapSize=st.st_size;
+	if(setGeoidFormat()) return true;
+	printLog("ERROR: The geoidal separation data file %s has not the expected size.\n",fileName);
+	GeoidalClose();
+	return false;
+}
+
+bool setGeoidFormat(void) {
+	if(Geoidal.mapSize==EGM96SIZE) {
+		Geoidal.format=GEOID_EGM96;
+		Geoidal.data=Geoidal.map;
+		Geoidal.width=EGM96_W;
+		Geoidal.height=EGM96_H;
+		Geoidal.cellsPerDegLat=EGM96_H/180.0;
+		Geoidal.cellsPerDegLon=EGM96_W/360.0;
+	} else if(memcmp(Geoidal.map,GEOID_GRID_MAGIC,4)==0) {
+		Geoidal.format=GEOID_GRID;
+		Geoidal.data=Geoidal.map+GEOID_HEADER_SIZE;
+		Geoidal.width=Geoidal.map[4]|(Geoidal.map[5]<<8);
+		Geoidal.height=Geoidal.map[6]|(Geoidal.map[7]<<8);
+		if(Geoidal.width<2 || Geoidal.height<2 || Geoidal.width>GEOID_MAX_SIZE || Geoidal.height>GEOID_MAX_SIZE+1) return false;
+		if(Geoidal.mapSize!=GEOID_HEADER_SIZE+2*(size_t)Geoidal.width*Geoidal.height) return false;
+		Geoidal.cellsPerDegLat=(Geoidal.height-1)/180.0; //the last row is the S pole
+		Geoidal.cellsPerDegLon=Geoidal.width/360.0;
+	} else return false;
+	Geoidal.cacheLat=-1;
+	Geoidal.cacheLon=-1;
 	return true;
 }
 
+bool GeoidalOpen() {
+	if(Geoidal.map!=NULL) return true; //The data seems already loaded do nothing
+	if(mapGeoidFile(GEOID_GRID_FILE)) return true;
+	if(mapGeoidFile("egm96s.dem")) return true;
+	printLog("ERROR: Unable to open the egm96 geoidal separation data file.\n");
+	return false;
+}
+
 bool GeoidalIsOpen() {
-	return(egm96data!=NULL);
+	return(Geoidal.map!=NULL);
 }
 
 void GeoidalClose() {
-	if(egm96data!=NULL) {
-			free(egm96data);
-			egm96data=NULL;
+	if(Geoidal.map!=NULL) {
+			munmap(Geoidal.map,Geoidal.mapSize);
+			Geoidal.map=NULL;
+			Geoidal.data=NULL;
 	}
 }
 
-double getEGM96data(int x, int y) {
-	return (double)(egm96data[x+y*EGM96_W])-127;
+double getGridData(int x, int y) {
+	if(Geoidal.format==GEOID_EGM96) return (double)(Geoidal.data[x+y*Geoidal.width])-127;
+	const unsigned char *sample=Geoidal.data+2*(x+y*Geoidal.width);
+	return (short)(sample[0]|(sample[1]<<8))/100.0;
+}
+
+void cacheCell(int ilon, int ilat) { //coefficients of the bilinear interpolation in the cell, for the next fixes in the same cell
+	int ilonp1;
+	if(ilon!=Geoidal.width-1) ilonp1=ilon+1;
+	else ilonp1=0; //in this case interpolate through the Greenwich meridian
+	double z11=getGridData(ilon,ilat), z12=getGridData(ilonp1,ilat), z21=getGridData(ilon,ilat+1), z22=getGridData(ilonp1,ilat+1);
+	Geoidal.c0=z11;
+	Geoidal.cx=z12-z11;
+	Geoidal.cy=z21-z11;
+	Geoidal.cxy=z22-z21-z12+z11;
+	Geoidal.cacheLat=ilat;
+	Geoidal.cacheLon=ilon;
 }
 
-double GeoidalGetSeparation(double lat, double lon) { //It uses the data from the EGM96 file
-	if(egm96data==NULL) return wgs84_to_msl_delta(lat,lon); //If EGM96 data not available use the hard-coded data
-	double y=(90.0-lat)/2.0;
+double GeoidalGetSeparation(double lat, double lon) { //It uses the data from the geoid file
+	if(Geoidal.map==NULL) return wgs84_to_msl_delta(lat,lon); //If the geoid data is not available use the hard-coded data
+	double y=(90.0-lat)*Geoidal.cellsPerDegLat;
 	int ilat=(int)y;
 	if(lon<0) lon+=360.0;
-	double x=lon/2.0;
+	double x=lon*Geoidal.cellsPerDegLon;
 	int ilon=(int)x;
-	if(ilat>EGM96_H || ilon>EGM96_W || ilat<0 || ilon<0) return 0.0;
-	if(ilat==EGM96_H || ilat==EGM96_H-1) return getEGM96data(ilon,EGM96_H-1); //to prevent to go over -90
-	int ilonp1;
-	if(ilon!=EGM96_W-1) ilonp1=ilon+1;
-	else ilonp1=0; //in this case interpolate through the Greenwich meridian
+	if(ilat>Geoidal.height || ilon>Geoidal.width || ilat<0 || ilon<0) return 0.0;
+	if(ilon==Geoidal.width) ilon=0; //exactly on 360E
+	if(ilat>=Geoidal.height-1) return getGridData(ilon,Geoidal.height-1); //to prevent to go over -90
+	if(ilat!=Geoidal.cacheLat || ilon!=Geoidal.cacheLon) cacheCell(ilon,ilat);
 	x-=(double)ilon;
 	y-=(double)ilat;
-	return interpolation2d(x,y,getEGM96data(ilon,ilat),getEGM96data(ilonp1,ilat),getEGM96data(ilon,ilat+1),getEGM96data(ilonp1,ilat+1));
+	return Geoidal.c0+Geoidal.cx*x+(Geoidal.cy+Geoidal.cxy*x)*y;
 }
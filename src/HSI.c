@@ -6,7 +6,7 @@
 // Copyright   : (C) 2010-2020 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 20/1/2014
+// Last change : 17/10/2026
 // Description : Draws and updates the Horizontal Situation Indicator
 //============================================================================
 
@@ -19,8 +19,22 @@
 #include "FBrender.h"
 #include "AirCalc.h"
 #include "Configuration.h"
+#ifdef AIRCALC_FAST_TRIG
+#include "FastTrig.h"
+#endif
 
 
+struct roseMark {
+	short outerX,outerY; //where all the marks start on the external border
+	short minorX,minorY; //end of the minor mark
+	short majorX,majorY; //end of the major mark
+	short labelX,labelY; //center of the label
+};
+
+struct rotation { //sine and cosine of an angle computed only once for all the points to rotate
+	double sinA,cosA;
+};
+
 struct HSIstruct {
 	const char *label[12];
 	const int labelHalfWidth[12];
@@ -67,14 +81,20 @@ struct HSIstruct {
 	int symTailU;
 	int symTailC;
 	int symTailD;
+	struct roseMark rose[360]; //end points of the compass rose marks and labels already rotated for each integer angle
 };
 
 void HSIinitialize(void);
 int HSIround(double d);
 void rotatePoint(int mx, int my, int *px, int *py, double angle);
+void setRotation(struct rotation *rot, double angle);
+void rotatePointBy(int mx, int my, int *px, int *py, const struct rotation *rot);
+void buildRose(void);
+int roseIndex(int angle);
 void HSIdraw(double directionDeg, double courseDeg, double courseDeviationMt, bool force, bool onlyDirection, bool validCrossTrackError, double bearing);
 void drawCompass(int dir, bool drawPlaneSymbol);
 void drawLabels(int dir);
+void drawLabel(short i, int angle);
 void drawCDI(double direction, double course, double cdi, double bearing);
 void drawAirplaneSymbol(void);
 void displayTRKvalue(double track);
@@ -137,6 +157,7 @@ void HSIinitialize() { //TODO: depending on the screen size calculate all dimens
 	HSI.symTailD=HSI.cy+12;
 	if(screen.height==240) HSI.HalfAltScale=438;
 	HSI.PxAltScale=screen.height-12;
+	buildRose();
 }
 
 void HSIfirstTimeDraw(double direction, double course, double cdiMt, bool onlyDirection, bool validXTD, double bearing) {
@@ -154,59 +175,84 @@ int HSIround(double d) {
 }
 
 void rotatePoint(int mx, int my, int *px, int *py, double angle) {
-	double cos_theta = cos(angle); //convert the angle to a useful form
-	double sin_theta = sin(angle);
-	int x2 = round((*px-mx)*(cos_theta)-(*py-my)*(sin_theta)); // calc the transformation
-	int y2 = round((*px-mx)*(sin_theta)+(*py-my)*(cos_theta));
+	struct rotation rot;
+	setRotation(&rot,angle);
+	rotatePointBy(mx,my,px,py,&rot);
+}
+
+void setRotation(struct rotation *rot, double angle) { //convert the angle to a useful form
+#ifdef AIRCALC_FAST_TRIG
+	float sinA,cosA;
+	FastTrigSinCos(angle,&sinA,&cosA);
+	rot->sinA=sinA;
+	rot->cosA=cosA;
+#else
+	rot->cosA=cos(angle);
+	rot->sinA=sin(angle);
+#endif
+}
+
+void rotatePointBy(int mx, int my, int *px, int *py, const struct rotation *rot) {
+	int x2 = round((*px-mx)*(rot->cosA)-(*py-my)*(rot->sinA)); // calc the transformation
+	int y2 = round((*px-mx)*(rot->sinA)+(*py-my)*(rot->cosA));
 	*px=x2+mx;
 	*py=y2+my;
 }
 
+void buildRose(void) { //rotate once for all the marks of the compass rose, then drawing it needs no trigonometry
+	struct rotation rot;
+	int x,y;
+	for(int angle=0;angle<360;angle++) {
+		struct roseMark *mark=&HSI.rose[angle];
+		setRotation(&rot,Deg2Rad(angle));
+		x=HSI.cx; y=HSI.mark_start;
+		rotatePointBy(HSI.cx,HSI.cy,&x,&y,&rot);
+		mark->outerX=x; mark->outerY=y;
+		x=HSI.cx; y=HSI.minor_mark;
+		rotatePointBy(HSI.cx,HSI.cy,&x,&y,&rot);
+		mark->minorX=x; mark->minorY=y;
+		x=HSI.cx; y=HSI.major_mark;
+		rotatePointBy(HSI.cx,HSI.cy,&x,&y,&rot);
+		mark->majorX=x; mark->majorY=y;
+		x=HSI.cx; y=HSI.label_pos;
+		rotatePointBy(HSI.cx,HSI.cy,&x,&y,&rot);
+		mark->labelX=x; mark->labelY=y;
+	}
+}
+
+int roseIndex(int angle) { //index of the cached marks for any integer angle, also negative
+	angle%=360;
+	return (angle<0)?angle+360:angle;
+}
+
 void drawCompass(int dir, bool drawPlaneSymbol) { //works with direction as integer
 	HSI.previousDir=dir;
 	FillCircle(HSI.cx,HSI.cy,HSI.re,config.colorSchema.background); //clear all the compass
-	int pex,pey,pix,piy,indexCompass;
+	const struct roseMark *mark;
+	int indexCompass;
 	short i;
 	for(i=0,indexCompass=dir;i<12;indexCompass+=30,i++) {
-		if(indexCompass>359) indexCompass-=360;
-		double angle=Deg2Rad(indexCompass);
-		pex=HSI.cx;
-		pey=HSI.mark_start;
-		pix=HSI.cx;
-		piy=HSI.major_mark;
-		rotatePoint(HSI.cx,HSI.cy,&pex,&pey,angle);
-		rotatePoint(HSI.cx,HSI.cy,&pix,&piy,angle);
-		DrawTwoPointsLine(pex,pey,pix,piy,config.colorSchema.compassRose);
-		pix=HSI.cx; //Here we locate the label
-		piy=HSI.label_pos;
-		rotatePoint(HSI.cx,HSI.cy,&pix,&piy,angle);
-		FBrenderBlitText(pix-HSI.labelHalfWidth[i],piy-HSI.labelHalfHeight,config.colorSchema.compassRose,config.colorSchema.background,false,HSI.label[i]);
+		mark=&HSI.rose[roseIndex(indexCompass)];
+		DrawTwoPointsLine(mark->outerX,mark->outerY,mark->majorX,mark->majorY,config.colorSchema.compassRose);
+		drawLabel(i,indexCompass);
 		int index2=indexCompass+5;
 		short minor=1,j;
 		for(j=0;j<5;index2+=5,j++,minor=!minor) {
-			angle=Deg2Rad(index2);
-			pex=HSI.cx;
-			pey=HSI.mark_start;
-			pix=HSI.cx;
-			if(minor) piy=HSI.minor_mark;
-			else piy=HSI.major_mark;
-			rotatePoint(HSI.cx,HSI.cy,&pex,&pey,angle);
-			rotatePoint(HSI.cx,HSI.cy,&pix,&piy,angle);
-			DrawTwoPointsLine(pex,pey,pix,piy,config.colorSchema.compassRose);
+			mark=&HSI.rose[roseIndex(index2)];
+			if(minor) DrawTwoPointsLine(mark->outerX,mark->outerY,mark->minorX,mark->minorY,config.colorSchema.compassRose);
+			else DrawTwoPointsLine(mark->outerX,mark->outerY,mark->majorX,mark->majorY,config.colorSchema.compassRose);
 		}
 	}
 	if(drawPlaneSymbol) drawAirplaneSymbol();
 }
 
 void drawLabels(int dir) { //also here direction as integer
-	for(int i=0,indexLabel=dir;i<12;indexLabel+=30,i++) {
-		if(indexLabel>359) indexLabel-=360;
-		double angle=Deg2Rad(indexLabel);
-		int pix=HSI.cx; //locate the label
-		int piy=HSI.label_pos;
-		rotatePoint(HSI.cx,HSI.cy,&pix,&piy,angle);
-		FBrenderBlitText(pix-HSI.labelHalfWidth[i],piy-HSI.labelHalfHeight,config.colorSchema.compassRose,config.colorSchema.background,false,HSI.label[i]);
-	}
+	for(int i=0,indexLabel=dir;i<12;indexLabel+=30,i++) drawLabel(i,indexLabel);
+}
+
+void drawLabel(short i, int angle) { //the label already located in the cache
+	const struct roseMark *mark=&HSI.rose[roseIndex(angle)];
+	FBrenderBlitText(mark->labelX-HSI.labelHalfWidth[i],mark->labelY-HSI.labelHalfHeight,config.colorSchema.compassRose,config.colorSchema.background,false,HSI.label[i]);
 }
 
 void drawCDI(double direction, double course, double cdi, double bearing) {
@@ -215,26 +261,29 @@ void drawCDI(double direction, double course, double cdi, double bearing) {
 	double angle=course-direction;
 	if(angle<0) angle+=360;
 	angle=Deg2Rad(angle);
+	struct rotation rot,opposite,bea; //sine and cosine computed only once for each direction
+	setRotation(&rot,angle);
+	setRotation(&opposite,angle+M_PI);
 	int pex=HSI.cx-1; //course indicator left
 	int pey=HSI.major_mark+2;
 	int pix=HSI.cx-1;
 	int piy=HSI.cdi_border+1;
-	rotatePoint(HSI.cx,HSI.cy,&pex,&pey,angle);
-	rotatePoint(HSI.cx,HSI.cy,&pix,&piy,angle);
+	rotatePointBy(HSI.cx,HSI.cy,&pex,&pey,&rot);
+	rotatePointBy(HSI.cx,HSI.cy,&pix,&piy,&rot);
 	DrawTwoPointsLine(pex,pey,pix,piy,config.colorSchema.routeIndicator);
 	pex=HSI.cx; //course indicator central
 	pey=HSI.major_mark;
 	pix=HSI.cx;
 	piy=HSI.cdi_border;
-	rotatePoint(HSI.cx,HSI.cy,&pex,&pey,angle);
-	rotatePoint(HSI.cx,HSI.cy,&pix,&piy,angle);
+	rotatePointBy(HSI.cx,HSI.cy,&pex,&pey,&rot);
+	rotatePointBy(HSI.cx,HSI.cy,&pix,&piy,&rot);
 	DrawTwoPointsLine(pex,pey,pix,piy,config.colorSchema.routeIndicator);
 	pex=HSI.cx+1; //course indicator right
 	pey=HSI.major_mark+2;
 	pix=HSI.cx+1;
 	piy=HSI.cdi_border+1;
-	rotatePoint(HSI.cx,HSI.cy,&pex,&pey,angle);
-	rotatePoint(HSI.cx,HSI.cy,&pix,&piy,angle);
+	rotatePointBy(HSI.cx,HSI.cy,&pex,&pey,&rot);
+	rotatePointBy(HSI.cx,HSI.cy,&pix,&piy,&rot);
 	DrawTwoPointsLine(pex,pey,pix,piy,config.colorSchema.routeIndicator);
 
 	//TODO: Draw better the arrow using the new FillTriangle() function
@@ -254,51 +303,51 @@ void drawCDI(double direction, double course, double cdi, double bearing) {
 	pey=HSI.major_mark;
 	pix=HSI.cx-HSI.arrow_side;
 	piy=HSI.arrow_end;
-	rotatePoint(HSI.cx,HSI.cy,&pex,&pey,angle);
-	rotatePoint(HSI.cx,HSI.cy,&pix,&piy,angle);
+	rotatePointBy(HSI.cx,HSI.cy,&pex,&pey,&rot);
+	rotatePointBy(HSI.cx,HSI.cy,&pix,&piy,&rot);
 	DrawTwoPointsLine(pex,pey,pix,piy,config.colorSchema.routeIndicator);
 	pex=HSI.cx-1; //first side of the right left
 	pey=HSI.major_mark+2;
 	pix=HSI.cx-HSI.arrow_side-1;
 	piy=HSI.arrow_end;
-	rotatePoint(HSI.cx,HSI.cy,&pex,&pey,angle);
-	rotatePoint(HSI.cx,HSI.cy,&pix,&piy,angle);
+	rotatePointBy(HSI.cx,HSI.cy,&pex,&pey,&rot);
+	rotatePointBy(HSI.cx,HSI.cy,&pix,&piy,&rot);
 	DrawTwoPointsLine(pex,pey,pix,piy,config.colorSchema.routeIndicator);
 	pex=HSI.cx+1; //other side of the arrow right
 	pey=HSI.major_mark+2;
 	pix=HSI.cx+HSI.arrow_side+1;
 	piy=HSI.arrow_end;
-	rotatePoint(HSI.cx,HSI.cy,&pex,&pey,angle);
-	rotatePoint(HSI.cx,HSI.cy,&pix,&piy,angle);
+	rotatePointBy(HSI.cx,HSI.cy,&pex,&pey,&rot);
+	rotatePointBy(HSI.cx,HSI.cy,&pix,&piy,&rot);
 	DrawTwoPointsLine(pex,pey,pix,piy,config.colorSchema.routeIndicator);
 	pex=HSI.cx; //other side of the arrow central
 	pey=HSI.major_mark;
 	pix=HSI.cx+HSI.arrow_side;
 	piy=HSI.arrow_end;
-	rotatePoint(HSI.cx,HSI.cy,&pex,&pey,angle);
-	rotatePoint(HSI.cx,HSI.cy,&pix,&piy,angle);
+	rotatePointBy(HSI.cx,HSI.cy,&pex,&pey,&rot);
+	rotatePointBy(HSI.cx,HSI.cy,&pix,&piy,&rot);
 	DrawTwoPointsLine(pex,pey,pix,piy,config.colorSchema.routeIndicator);
 
 	pex=HSI.cx-1; //other side of the course indicator left
 	pey=HSI.major_mark;
 	pix=HSI.cx-1;
 	piy=HSI.cdi_border;
-	rotatePoint(HSI.cx,HSI.cy,&pex,&pey,angle+M_PI);
-	rotatePoint(HSI.cx,HSI.cy,&pix,&piy,angle+M_PI);
+	rotatePointBy(HSI.cx,HSI.cy,&pex,&pey,&opposite);
+	rotatePointBy(HSI.cx,HSI.cy,&pix,&piy,&opposite);
 	DrawTwoPointsLine(pex,pey,pix,piy,config.colorSchema.routeIndicator);
 	pex=HSI.cx; //other side of the course central
 	pey=HSI.major_mark;
 	pix=HSI.cx;
 	piy=HSI.cdi_border-1;
-	rotatePoint(HSI.cx,HSI.cy,&pex,&pey,angle+M_PI);
-	rotatePoint(HSI.cx,HSI.cy,&pix,&piy,angle+M_PI);
+	rotatePointBy(HSI.cx,HSI.cy,&pex,&pey,&opposite);
+	rotatePointBy(HSI.cx,HSI.cy,&pix,&piy,&opposite);
 	DrawTwoPointsLine(pex,pey,pix,piy,config.colorSchema.routeIndicator);
 	pex=HSI.cx+1; //other side of the course indicator right
 	pey=HSI.major_mark;
 	pix=HSI.cx+1;
 	piy=HSI.cdi_border;
-	rotatePoint(HSI.cx,HSI.cy,&pex,&pey,angle+M_PI);
-	rotatePoint(HSI.cx,HSI.cy,&pix,&piy,angle+M_PI);
+	rotatePointBy(HSI.cx,HSI.cy,&pex,&pey,&opposite);
+	rotatePointBy(HSI.cx,HSI.cy,&pix,&piy,&opposite);
 	DrawTwoPointsLine(pex,pey,pix,piy,config.colorSchema.routeIndicator);
 	int dev=0; //deviation in pixel
 	unsigned short cdiColor=config.colorSchema.routeIndicator; //same color of course direction arrow in case we don have to draw the CDI
@@ -311,8 +360,8 @@ void drawCDI(double direction, double course, double cdi, double bearing) {
 				pex=pix=HSI.cx+i*HSI.cdi_pixel_smallScale_tick;
 				pey=HSI.cy-HSI.cdi_scale_mark;
 				piy=HSI.cy+HSI.cdi_scale_mark;
-				rotatePoint(HSI.cx,HSI.cy,&pex,&pey,angle);
-				rotatePoint(HSI.cx,HSI.cy,&pix,&piy,angle);
+				rotatePointBy(HSI.cx,HSI.cy,&pex,&pey,&rot);
+				rotatePointBy(HSI.cx,HSI.cy,&pix,&piy,&rot);
 				DrawTwoPointsLine(pex,pey,pix,piy,config.colorSchema.cdiScale);
 			}
 			dev=-(int)(round((HSI.cdi_pixel_scale*cdi)/HSI.smallCDIscale));
@@ -321,8 +370,8 @@ void drawCDI(double direction, double course, double cdi, double bearing) {
 				pex=pix=HSI.cx+i*HSI.cdi_pixel_bigScale_tick;
 				pey=HSI.cy-HSI.cdi_scale_mark;
 				piy=HSI.cy+HSI.cdi_scale_mark;
-				rotatePoint(HSI.cx,HSI.cy,&pex,&pey,angle);
-				rotatePoint(HSI.cx,HSI.cy,&pix,&piy,angle);
+				rotatePointBy(HSI.cx,HSI.cy,&pex,&pey,&rot);
+				rotatePointBy(HSI.cx,HSI.cy,&pix,&piy,&rot);
 				DrawTwoPointsLine(pex,pey,pix,piy,config.colorSchema.cdiScale);
 			}
 			if(cdi>HSI.bigCDIscale) {
@@ -336,41 +385,42 @@ void drawCDI(double direction, double course, double cdi, double bearing) {
 		double alpha=bearing-direction; //calculate angle for bearing indicator
 		if(alpha<0) alpha+=360;
 		alpha=Deg2Rad(alpha);
+		setRotation(&bea,alpha);
 		pex=HSI.cx; //first side of the arrow (bearing indicator)
 		pey=HSI.bea_arrow_top;
 		pix=HSI.cx-HSI.bea_arrow_side;
 		piy=HSI.bea_arrow_end;
-		rotatePoint(HSI.cx,HSI.cy,&pex,&pey,alpha);
-		rotatePoint(HSI.cx,HSI.cy,&pix,&piy,alpha);
+		rotatePointBy(HSI.cx,HSI.cy,&pex,&pey,&bea);
+		rotatePointBy(HSI.cx,HSI.cy,&pix,&piy,&bea);
 		DrawTwoPointsLine(pex,pey,pix,piy,config.colorSchema.bearing);
 		pex=HSI.cx; //other side of the arrow central
 		pey=HSI.bea_arrow_top;
 		pix=HSI.cx+HSI.bea_arrow_side;
 		piy=HSI.bea_arrow_end;
-		rotatePoint(HSI.cx,HSI.cy,&pex,&pey,alpha);
-		rotatePoint(HSI.cx,HSI.cy,&pix,&piy,alpha);
+		rotatePointBy(HSI.cx,HSI.cy,&pex,&pey,&bea);
+		rotatePointBy(HSI.cx,HSI.cy,&pix,&piy,&bea);
 		DrawTwoPointsLine(pex,pey,pix,piy,config.colorSchema.bearing);
 	}
 	pex=HSI.cx+dev-1; //CDI left
 	pey=HSI.cdi_border+2;
 	pix=HSI.cx+dev-1;
 	piy=HSI.cdi_end-1;
-	rotatePoint(HSI.cx,HSI.cy,&pex,&pey,angle);
-	rotatePoint(HSI.cx,HSI.cy,&pix,&piy,angle);
+	rotatePointBy(HSI.cx,HSI.cy,&pex,&pey,&rot);
+	rotatePointBy(HSI.cx,HSI.cy,&pix,&piy,&rot);
 	DrawTwoPointsLine(pex,pey,pix,piy,cdiColor);
 	pex=HSI.cx+dev; //CDI center
 	pey=HSI.cdi_border+1;
 	pix=HSI.cx+dev;
 	piy=HSI.cdi_end;
-	rotatePoint(HSI.cx,HSI.cy,&pex,&pey,angle);
-	rotatePoint(HSI.cx,HSI.cy,&pix,&piy,angle);
+	rotatePointBy(HSI.cx,HSI.cy,&pex,&pey,&rot);
+	rotatePointBy(HSI.cx,HSI.cy,&pix,&piy,&rot);
 	DrawTwoPointsLine(pex,pey,pix,piy,cdiColor);
 	pex=HSI.cx+dev+1; //CDI right
 	pey=HSI.cdi_border+2;
 	pix=HSI.cx+dev+1;
 	piy=HSI.cdi_end-1;
-	rotatePoint(HSI.cx,HSI.cy,&pex,&pey,angle);
-	rotatePoint(HSI.cx,HSI.cy,&pix,&piy,angle);
+	rotatePointBy(HSI.cx,HSI.cy,&pex,&pey,&rot);
+	rotatePointBy(HSI.cx,HSI.cy,&pix,&piy,&rot);
 	DrawTwoPointsLine(pex,pey,pix,piy,cdiColor);
 	drawAirplaneSymbol();
 }
@@ -438,7 +488,6 @@ void HSIdraw(double direction, double course, double cdiMt, bool force, bool onl
 		diplayCDIvalue(cdiMt);
 	} else drawCompass(dir,true); //just draw the compass without CDI but with the airplane symbol
 	displayTRKvalue(direction);
-	FBrenderFlush();
 }
 
 void HSIupdateDir(double direction) {
@@ -0,0 +1,80 @@
+//============================================================================
+// Name        : HSIbench.c
+// Since       : 17/10/2026
+// Author      : Alberto Realis-Luc <alberto.realisluc@gmail.com>
+// Web         : https://www.alus.it/airnavigator/
+// Copyright   : (C) 2010-2026 Alberto Realis-Luc
+// License     : GNU GPL v2
+// Repository  : https://github.com/alus-it/AirNavigator.git
+// Last change : 17/10/2026
+// Description : Micro-benchmark of the HSI drawing on a headless screen, to
+//               be built and run on any Linux host with: make bench
+//============================================================================
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "Common.h"
+#include "Configuration.h"
+#include "FBrender.h"
+#include "HSI.h"
+
+#define BENCH_WIDTH  480 //same screen of the TomTom devices
+#define BENCH_HEIGHT 272
+#define BENCH_FRAMES 1000
+
+enum benchCase {
+	BENCH_FULL_DRAW,   //the whole HSI drawn again as when entering the HSI screen
+	BENCH_DIRECTION,   //the compass rose rotated at each frame
+	BENCH_CDI          //only the course deviation indicator moved
+};
+
+void drawBenchFrame(enum benchCase benchCase, int frame);
+void runBench(enum benchCase benchCase, const char *name, int frames);
+
+void drawBenchFrame(enum benchCase benchCase, int frame) {
+	double direction=(frame*7)%360; //direction changing at each frame
+	switch(benchCase) {
+		case BENCH_FULL_DRAW:
+			HSIfirstTimeDraw(direction,90,frame%500,false,true,45);
+			break;
+		case BENCH_DIRECTION:
+			HSIupdateDir(direction);
+			break;
+		case BENCH_CDI:
+			HSIupdateCDI(90,(frame%200)-100,true,45);
+			break;
+	}
+}
+
+void runBench(enum benchCase benchCase, const char *name, int frames) {
+	struct FBrenderStats before, after;
+	struct timeval start;
+	FBrenderClear(0,screen.height,config.colorSchema.background);
+	HSIfirstTimeDraw(0,90,0,false,true,45); //start always from the same complete HSI
+	FBrenderFlush();
+	FBrenderGetStats(&before);
+	gettimeofday(&start,NULL);
+	for(int i=1;i<=frames;i++) {
+		drawBenchFrame(benchCase,i);
+		FBrenderFlush();
+	}
+	long long us=elapsedUs(&start);
+	FBrenderGetStats(&after);
+	double secs=(us>0)?us/1000000.0:0.000001;
+	printf("%-10s %6d frames in %8.3f s: %9.1f frames/s, %8.1f us per frame, %7lu pixels written per frame\n",name,frames,secs,
+			frames/secs,us/(double)frames,(after.pixelsFlushed-before.pixelsFlushed)/frames);
+}
+
+int main(int argc, char** argv) { //arguments: [number of frames] [prefix of the PPM files to save each frame]
+	int frames=(argc>1)?atoi(argv[1]):BENCH_FRAMES;
+	const char *dumpPrefix=(argc>2)?argv[2]:NULL;
+	if(frames<1) frames=BENCH_FRAMES;
+	if(!FBrenderOpenHeadless(BENCH_WIDTH,BENCH_HEIGHT,dumpPrefix)) return EXIT_FAILURE;
+	runBench(BENCH_FULL_DRAW,"full draw",frames);
+	runBench(BENCH_DIRECTION,"direction",frames);
+	runBench(BENCH_CDI,"CDI",frames);
+	FBrenderClose();
+	return EXIT_SUCCESS;
+}
@@ -6,7 +6,7 @@
 // Copyright   : (C) 2010-2020 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 21/3/2016
+// Last change : 17/10/2026
 // Description : Parses NMEA sentences from a GPS device
 //============================================================================
 
@@ -18,50 +18,74 @@
 #include "NMEAparser.h"
 #include "Common.h"
 #include "GPSreceiver.h"
-#include "Navigator.h"
 #include "AirCalc.h"
 #include "BlackBox.h"
-#include "FBrender.h"
-#include "HSI.h"
 #include "Geoidal.h"
 
 
 #define MAX_FIELDS 30
-#define MAX_FIELD_LENGTH 25
+#define KEY_CHAR_BITS 6 //each char of the address is packed in 6 bits: 5 chars in 30 bits
+#define KEY_TALKER_MASK (((1u<<(2*KEY_CHAR_BITS))-1)<<(3*KEY_CHAR_BITS))
 
 
+struct handlerEntry {
+	unsigned int key;    //packed talker and sentence ID, talker is 0 for any talker
+	NMEAhandler handler;
+};
+
 struct NMEAparserStruct {
 	float altTimestamp, dirTimestamp, newerTimestamp, rcvdTimestamp;
-	bool GGAfound, RMCfound, GSAfound;
+	bool GGAfound, RMCfound, GSAfound, VTGfound, GLLfound, ZDAfound; //GGAfound is set also by GNS
 	int numOfGSVmsg, GSVmsgSeqNo, GSVtotalSatInView;
-	int rcvdBytesOfSentence, rcvdBytesOfField, rcvdBytesOfCheksum;
-	char sentence[MAX_SENTENCE_LENGTH];
-	char fields[MAX_FIELDS][MAX_FIELD_LENGTH];
+	const char *currSentence;           //sentence being parsed and its length
+	int currSentenceLen;
+	struct NMEAfield fields[MAX_FIELDS];
 	int fieldId;
 	float alt, latMin, lonMin, timeSec, groundSpeedKnots, trueTrack, magneticVariation, pdop, hdop, vdop;
 	char altUnit;
 	int latGra, lonGra, timeHour, timeMin, SatsInView, SatsInUse, timeDay, timeMonth, timeYear;
 	bool latNorth, lonEast, magneticVariationToEast;
+	struct handlerEntry handlers[NMEA_MAX_HANDLERS]; //sorted by key to be found with a binary search
+	int numOfHandlers;
+	bool defaultHandlersRegistered;
+	struct NMEAparserStats stats;
 };
 
+int frameSentence(const char *start, int available, unsigned char *checksum);
 int parseNMEAsentence(void);
-int parseGGA(void);
-int parseRMC(void);
-int parseGSA(void);
-int parseGSV(void);
+void registerDefaultHandlers(void);
+bool addHandler(const char *talker, const char *sentence, NMEAhandler handler);
+unsigned int packChar(char c);
+unsigned int packKey(const char *talker, const char *sentence);
+int findHandler(unsigned int key);
+void startNewEpoch(float timestamp);
+int storeFix(const struct NMEAfield *f, bool hasFix, char altUnit);
+int parseGGA(const struct NMEAfield *f, int lastField);
+int parseRMC(const struct NMEAfield *f, int lastField);
+int parseGSA(const struct NMEAfield *f, int lastField);
+int parseGSV(const struct NMEAfield *f, int lastField);
+int parseVTG(const struct NMEAfield *f, int lastField);
+int parseGLL(const struct NMEAfield *f, int lastField);
+int parseGNS(const struct NMEAfield *f, int lastField);
+int parseZDA(const struct NMEAfield *f, int lastField);
+int parseGST(const struct NMEAfield *f, int lastField);
+int parseGBS(const struct NMEAfield *f, int lastField);
+int ignoreSentence(const struct NMEAfield *f, int lastField);
 
-unsigned int getCRCintValue(void);
 bool updateAltitude(float newAltitude, char altUnit, float timestamp);
 void updateDirection(float newTrueTrack, float magneticVar, bool isVarToEast, float timestamp);
-bool updatePosition(int newlatDeg, float newlatMin, bool newisLatN, int newlonDeg, float newlonMin, bool newisLonE, bool dateChaged);
-bool parseTime(char* field, int* timeHour, int* timeMin, float* timeSec);
-bool parseDate(char* field, int* dd, int* mm, int* yy);
-bool parseLatitude(char* firstField, char* secondField, int* latDeg, float* latMin, bool* latNorth);
-bool parseLongitude(char* firstField, char* secondField, int* lonDeg, float* lonMin, bool* lonEast);
-bool parseValid(char* field, bool* isValid);
-bool parseEastWest(char* field, bool* isEast);
-bool parseInteger(char* field, int* value);
-bool parseFloat(char* field, float* value);
+int hexValue(char c);
+char firstChar(const struct NMEAfield *f);
+bool parseDigits(const char *str, int numDigits, int *value);
+bool parseDecimal(const char *str, int len, float *value);
+bool parseTime(const struct NMEAfield *f, int* timeHour, int* timeMin, float* timeSec);
+bool parseDate(const struct NMEAfield *f, int* dd, int* mm, int* yy);
+bool parseLatitude(const struct NMEAfield *firstField, const struct NMEAfield *secondField, int* latDeg, float* latMin, bool* latNorth);
+bool parseLongitude(const struct NMEAfield *firstField, const struct NMEAfield *secondField, int* lonDeg, float* lonMin, bool* lonEast);
+bool parseValid(const struct NMEAfield *f, bool* isValid);
+bool parseEastWest(const struct NMEAfield *f, bool* isEast);
+bool parseInteger(const struct NMEAfield *f, int* value);
+bool parseFloat(const struct NMEAfield *f, float* value);
 
 static struct NMEAparserStruct NMEAparser = {
 	.altTimestamp=0,
@@ -71,79 +95,46 @@ static struct NMEAparserStruct NMEAparser = {
 	.GGAfound=false,
 	.RMCfound=false,
 	.GSAfound=false,
+	.VTGfound=false,
+	.GLLfound=false,
+	.ZDAfound=false,
 	.numOfGSVmsg=0,
 	.GSVmsgSeqNo=0,
 	.GSVtotalSatInView=0,
-	.rcvdBytesOfSentence=0,
-	.rcvdBytesOfCheksum=-1,
-	.fieldId=0
+	.fieldId=0,
+	.numOfHandlers=0,
+	.defaultHandlersRegistered=false,
+	.stats={0,0,0}
 };
 
-void NMEAparserProcessBuffer(unsigned char *buf, int redBytes) {
-	for(int i=0;i<redBytes;i++) switch(buf[i]) {
-		case '$':
-			NMEAparser.rcvdBytesOfSentence=1;
-			NMEAparser.rcvdBytesOfField=0;
-			NMEAparser.rcvdBytesOfCheksum=-1;
-			NMEAparser.fieldId=0;
-			NMEAparser.sentence[0]='$';
-			break;
-		case ',':
-			NMEAparser.fields[NMEAparser.fieldId][NMEAparser.rcvdBytesOfField]='\0';
-			if(NMEAparser.rcvdBytesOfSentence > 5) {
-				if(NMEAparser.fieldId<MAX_FIELDS) {
-					if(NMEAparser.rcvdBytesOfSentence<MAX_SENTENCE_LENGTH) {
-						NMEAparser.fieldId++;
-						NMEAparser.rcvdBytesOfField=0;
-						NMEAparser.sentence[NMEAparser.rcvdBytesOfSentence++]=',';
-					}
-				}
-			}
-			break;
-		case '*':
-			NMEAparser.fields[NMEAparser.fieldId][NMEAparser.rcvdBytesOfField]='\0';
-			NMEAparser.rcvdBytesOfCheksum=0;
-			if(NMEAparser.rcvdBytesOfSentence<MAX_SENTENCE_LENGTH) {
-				NMEAparser.sentence[NMEAparser.rcvdBytesOfSentence++]='*';
-			}
-			break;
-		case '\r':
-		case '\n':
-			break;
-		default:
-			if(NMEAparser.rcvdBytesOfSentence>0) {
-				if(NMEAparser.rcvdBytesOfSentence<MAX_SENTENCE_LENGTH) {
-					NMEAparser.sentence[NMEAparser.rcvdBytesOfSentence++]=buf[i]; //add chars to the sentence
-					if(NMEAparser.rcvdBytesOfCheksum!=-1) { // checksum
-						NMEAparser.rcvdBytesOfCheksum++;
-						if(NMEAparser.rcvdBytesOfCheksum==2) { // do checksum check
-							unsigned int checksum=0;
-							for(int j=1;j<NMEAparser.rcvdBytesOfSentence-3;j++) checksum^=NMEAparser.sentence[j];
-							if(getCRCintValue()==checksum) { //right CRC
-								NMEAparser.sentence[NMEAparser.rcvdBytesOfSentence]='\0';
-								#ifdef PRINT_SENTENCES //Print all the sentences received, if required
-								printLog("%s\n",NMEAparser.sentence);
-								#endif
-								NMEAparser.rcvdTimestamp=getCurrentTime();
-								parseNMEAsentence();
-								NMEAparser.rcvdBytesOfSentence=0;
-							}
-						}
-					} else { // not checksum
-						NMEAparser.fields[NMEAparser.fieldId][NMEAparser.rcvdBytesOfField++]=buf[i];
-					}
-				} else { // overflow
-					NMEAparser.rcvdBytesOfSentence=0; //to avoid buffer overflow
-				}
-			}
-			break;
-	} //end of switch(each byte) of just received sequence
+int NMEAparserProcessSentence(const char *start, int available, bool *accepted) { //from the '$': length of the sentence, 0 if more bytes are needed, -(bytes to skip) if truncated or too long
+	unsigned char checksum;
+	int star=frameSentence(start,available,&checksum);
+	*accepted=false;
+	if(star<=0) return star;
+	int high=hexValue(start[star+1]), low=hexValue(start[star+2]);
+	if(NMEAparser.fieldId==MAX_FIELDS || high<0 || low<0 || ((high<<4)|low)!=checksum) { //too many fields or wrong CRC
+		NMEAparser.stats.wrongSentences++;
+		return star+3;
+	}
+	NMEAparser.stats.sentences++;
+	NMEAparser.currSentence=start;
+	NMEAparser.currSentenceLen=star+3;
+	#ifdef PRINT_SENTENCES //Print all the sentences received, if required
+	printLog("%.*s\n",star+3,start);
+	#endif
+	NMEAparser.rcvdTimestamp=getCurrentTime();
+	parseNMEAsentence();
+	*accepted=true;
+	return star+3;
+}
+
+void NMEAparserCommit(void) { //give to the GPS data what has been received for the current epoch
 	bool dateChanged=false, posChanged=false, altChanged=false;
-	if(NMEAparser.GGAfound  || NMEAparser.RMCfound || NMEAparser.GSAfound) {
-		pthread_mutex_lock(&gps.mutex);
-		if(NMEAparser.RMCfound) dateChanged=updateDate(NMEAparser.timeDay,NMEAparser.timeMonth,NMEAparser.timeYear); //pre-check if date is changed
+	if(NMEAparser.GGAfound || NMEAparser.RMCfound || NMEAparser.GSAfound || NMEAparser.VTGfound || NMEAparser.GLLfound || NMEAparser.ZDAfound) {
+		if(NMEAparser.RMCfound || NMEAparser.ZDAfound) dateChanged=updateDate(NMEAparser.timeDay,NMEAparser.timeMonth,NMEAparser.timeYear); //pre-check if date is changed
 		if(NMEAparser.GGAfound) {
-			updateTime(NMEAparser.newerTimestamp,NMEAparser.timeHour,NMEAparser.timeMin,NMEAparser.timeSec,false); //updateTime must be done always before of updatePosition
+			updateTime(NMEAparser.newerTimestamp,NMEAparser.timeHour,NMEAparser.timeMin,NMEAparser.timeSec); //updateTime must be done always before of updatePosition
 			posChanged=updatePosition(NMEAparser.latGra,NMEAparser.latMin,NMEAparser.latNorth,NMEAparser.lonGra,NMEAparser.lonMin,NMEAparser.lonEast,dateChanged);
 			altChanged=updateAltitude(NMEAparser.alt,NMEAparser.altUnit,NMEAparser.newerTimestamp);
 			updateNumOfTotalSatsInView(NMEAparser.SatsInView);
@@ -151,79 +142,166 @@ void NMEAparserProcessBuffer(unsigned char *buf, int redBytes) {
 				updateNumOfActiveSats(NMEAparser.SatsInUse);
 				//updateDiluition(NMEAparser.pdop,NMEAparser.hdop,NMEAparser.vdop);
 			} //else updateHdiluition(NMEAparser.hdop);
+		} else if(NMEAparser.RMCfound || NMEAparser.GLLfound) { //position without altitude
+			updateTime(NMEAparser.newerTimestamp,NMEAparser.timeHour,NMEAparser.timeMin,NMEAparser.timeSec); //updateTime must be done always before of updatePosition
+			posChanged=updatePosition(NMEAparser.latGra,NMEAparser.latMin,NMEAparser.latNorth,NMEAparser.lonGra,NMEAparser.lonMin,NMEAparser.lonEast,dateChanged);
 		}
 		if(NMEAparser.RMCfound) {
-			if(!NMEAparser.GGAfound) {
-				updateTime(NMEAparser.newerTimestamp,NMEAparser.timeHour,NMEAparser.timeMin,NMEAparser.timeSec,false); //updateTime must be done always before of updatePosition
-				posChanged=updatePosition(NMEAparser.latGra,NMEAparser.latMin,NMEAparser.latNorth,NMEAparser.lonGra,NMEAparser.lonMin,NMEAparser.lonEast,dateChanged);
-			}
 			updateSpeed(NMEAparser.groundSpeedKnots);
 			updateDirection(NMEAparser.trueTrack,NMEAparser.magneticVariation,NMEAparser.magneticVariationToEast,NMEAparser.newerTimestamp);
+		} else if(NMEAparser.VTGfound) { //VTG has no magnetic variation: keep the last one received
+			updateSpeed(NMEAparser.groundSpeedKnots);
+			updateDirection(NMEAparser.trueTrack,gps.magneticVariation,gps.isMagVarToEast,NMEAparser.newerTimestamp);
+		}
+		if(posChanged||altChanged) {
+			NMEAparser.stats.fixes++;
+			GPSreceiverNavigate();
 		}
-		if(posChanged||altChanged) NavUpdatePosition(gps.lat,gps.lon,gps.realAltMt,gps.speedKmh,gps.timestamp);
-		pthread_mutex_unlock(&gps.mutex);
-		if(getMainStatus()==MAIN_DISPLAY_HSI) FBrenderFlush();
 		BlackBoxCommit();
 		NMEAparser.GGAfound=false;
 		NMEAparser.RMCfound=false;
 		NMEAparser.GSAfound=false;
+		NMEAparser.VTGfound=false;
+		NMEAparser.GLLfound=false;
+		NMEAparser.ZDAfound=false;
 	}
 }
 
-int parseNMEAsentence() {
-	if(strlen(NMEAparser.sentence)<6) return -1; //wrong sentence
-	int r=2;
-	switch(NMEAparser.sentence[3]){
-		case 'G': //GGA GSA GSV GLL GBS
-			switch(NMEAparser.sentence[4]){
-				case 'G': //GGA
-					if(NMEAparser.sentence[5]=='A') {
-						r=parseGGA();
-						#ifdef PRINT_SENTENCES
-						printLog("Time difference: %f\n",NMEAparser.newerTimestamp-NMEAparser.rcvdTimestamp);
-						#endif
-					}
-					break;
-				case 'S': //GSA GSV
-					if(NMEAparser.sentence[5]=='A') r=parseGSA(); //GSA
-					else if(NMEAparser.sentence[5]=='V') r=parseGSV(); //GSV
-					break;
+int frameSentence(const char *start, int available, unsigned char *checksum) { //in a single pass split the fields and compute the checksum: position of the '*', 0 if more bytes are needed, -(bytes to skip) if not valid
+	const char *fieldStart=start+1;
+	*checksum=0;
+	NMEAparser.fieldId=0;
+	for(int i=1;i<available;i++) {
+		char c=start[i];
+		if(c=='*') {
+			if(i+3>available) return 0; //the checksum is in the next read
+			if(NMEAparser.fieldId<MAX_FIELDS) {
+				NMEAparser.fields[NMEAparser.fieldId].str=fieldStart;
+				NMEAparser.fields[NMEAparser.fieldId].len=start+i-fieldStart;
 			}
-			break;
-		case 'R': //RMC
-			if(NMEAparser.sentence[4]=='M' && NMEAparser.sentence[5]=='C') r=parseRMC();
-			break;
+			return i;
+		}
+		if(c<' ' || c>'~' || c=='$') return -i; //truncated sentence
+		if(i==MAX_SENTENCE_LENGTH-3) return -i; //too long to be a sentence
+		*checksum^=c;
+		if(c==',') {
+			if(NMEAparser.fieldId<MAX_FIELDS-1) {
+				NMEAparser.fields[NMEAparser.fieldId].str=fieldStart;
+				NMEAparser.fields[NMEAparser.fieldId++].len=start+i-fieldStart;
+			} else NMEAparser.fieldId=MAX_FIELDS; //too many fields: it will be discarded
+			fieldStart=start+i+1;
+		}
 	}
+	return 0;
+}
+
+int parseNMEAsentence() {
+	const struct NMEAfield *address=&NMEAparser.fields[0]; //talker and sentence ID: ttsss
+	if(address->len<5) return -1; //wrong sentence
+	if(!NMEAparser.defaultHandlersRegistered) registerDefaultHandlers();
+	unsigned int key=packKey(address->str,address->str+2);
+	int r=2, pos=findHandler(key); //an handler for this talker has the precedence...
+	if(pos<0) pos=findHandler(key&~KEY_TALKER_MASK); //... on the one for any talker
+	if(pos>=0) r=NMEAparser.handlers[pos].handler(NMEAparser.fields,NMEAparser.fieldId);
 	#ifdef PRINT_SENTENCES
-	if(r<0) printLog("WARNING: parsing sentence %s returned: %d\n",NMEAparser.sentence,r);
-	else if(r==2) printLog("Received unexpected sentence: %s\n",NMEAparser.sentence);
+	if(r<0) printLog("WARNING: parsing sentence %.*s returned: %d\n",NMEAparser.currSentenceLen,NMEAparser.currSentence,r);
+	else if(r==2) printLog("Received unexpected sentence: %.*s\n",NMEAparser.currSentenceLen,NMEAparser.currSentence);
 	#endif
 	return 1;
 }
 
-bool updatePosition(int newlatDeg, float newlatMin, bool newisLatN, int newlonDeg, float newlonMin, bool newisLonE, bool dateChaged) {
-	if(gps.latMinDecimal!=newlatMin||gps.lonMinDecimal!=newlonMin) {
-		gps.latDeg=newlatDeg;
-		gps.lonDeg=newlonDeg;
-		gps.latMinDecimal=newlatMin;
-		gps.lonMinDecimal=newlonMin;
-		gps.isLatN=newisLatN;
-		gps.isLonE=newisLonE;
-		gps.lat=latDegMin2rad(gps.latDeg,gps.latMinDecimal,gps.isLatN);
-		gps.lon=lonDegMin2rad(gps.lonDeg,gps.lonMinDecimal,gps.isLonE);
-		if(getMainStatus()==MAIN_DISPLAY_HSI) {
-			int latMin,lonMin;
-			double latSec,lonSec;
-			convertDecimal2DegMin(gps.latMinDecimal,&latMin,&latSec);
-			convertDecimal2DegMin(gps.lonMinDecimal,&lonMin,&lonSec);
-			PrintPosition(gps.latDeg,latMin,latSec,gps.isLatN,gps.lonDeg,lonMin,lonSec,gps.isLonE);
-		} else if(getMainStatus()==MAIN_DISPLAY_SUNRISE_SUNSET) {
-			//TODO: ....
+bool NMEAparserRegister(const char *talker, const char *sentence, NMEAhandler handler) { //to be called before starting the GPS receiver, NULL handler to remove it
+	if(!NMEAparser.defaultHandlersRegistered) registerDefaultHandlers();
+	return addHandler(talker,sentence,handler);
+}
+
+void NMEAparserGetStats(struct NMEAparserStats *stats) { //to be called by the GPS thread
+	*stats=NMEAparser.stats;
+}
+
+void registerDefaultHandlers(void) {
+	NMEAparser.defaultHandlersRegistered=true;
+	addHandler(NMEA_ANY_TALKER,"GGA",parseGGA);
+	addHandler(NMEA_ANY_TALKER,"RMC",parseRMC);
+	addHandler(NMEA_ANY_TALKER,"GSA",parseGSA);
+	addHandler(NMEA_ANY_TALKER,"VTG",parseVTG);
+	addHandler(NMEA_ANY_TALKER,"GLL",parseGLL);
+	addHandler(NMEA_ANY_TALKER,"GNS",parseGNS);
+	addHandler(NMEA_ANY_TALKER,"ZDA",parseZDA);
+	addHandler(NMEA_ANY_TALKER,"GST",parseGST);
+	addHandler(NMEA_ANY_TALKER,"GBS",parseGBS);
+	addHandler(NMEA_ANY_TALKER,"GSV",ignoreSentence); //satellites of GLONASS, Galileo, BeiDou... have IDs out of our table
+	addHandler("GP","GSV",parseGSV);
+	addHandler("GN","GSV",parseGSV);
+}
+
+bool addHandler(const char *talker, const char *sentence, NMEAhandler handler) {
+	unsigned int key=packKey(talker,sentence);
+	if(key==0) {
+		printLog("NMEAparser: ERROR invalid talker or sentence ID of the handler.\n");
+		return false;
+	}
+	int pos=findHandler(key);
+	if(pos>=0) { //already present: replace or remove it
+		if(handler!=NULL) NMEAparser.handlers[pos].handler=handler;
+		else {
+			NMEAparser.numOfHandlers--;
+			memmove(&NMEAparser.handlers[pos],&NMEAparser.handlers[pos+1],(NMEAparser.numOfHandlers-pos)*sizeof(struct handlerEntry));
 		}
-		BlackBoxRecordPos(gps.lat,gps.lon,gps.timestamp,gps.hour,gps.minute,gps.second,gps.day,gps.month,gps.year,dateChaged);
 		return true;
 	}
-	return false;
+	if(handler==NULL) return true; //nothing to remove
+	if(NMEAparser.numOfHandlers==NMEA_MAX_HANDLERS) {
+		printLog("NMEAparser: ERROR too many sentence handlers.\n");
+		return false;
+	}
+	pos=-1-pos; //keep the table sorted
+	memmove(&NMEAparser.handlers[pos+1],&NMEAparser.handlers[pos],(NMEAparser.numOfHandlers-pos)*sizeof(struct handlerEntry));
+	NMEAparser.handlers[pos].key=key;
+	NMEAparser.handlers[pos].handler=handler;
+	NMEAparser.numOfHandlers++;
+	return true;
+}
+
+unsigned int packChar(char c) { //from '0'..'Z' to 1..43, 0 is not valid
+	if(c<'0' || c>'Z') return 0;
+	return c-'0'+1;
+}
+
+unsigned int packKey(const char *talker, const char *sentence) { //2 chars of the talker and 3 of the sentence ID, 0 if not valid
+	unsigned int key=0, code;
+	int i;
+	for(i=0;i<2;i++) {
+		code=0;
+		if(talker!=NMEA_ANY_TALKER && (code=packChar(talker[i]))==0) return 0;
+		key=(key<<KEY_CHAR_BITS)|code;
+	}
+	for(i=0;i<3;i++) {
+		if((code=packChar(sentence[i]))==0) return 0;
+		key=(key<<KEY_CHAR_BITS)|code;
+	}
+	return key;
+}
+
+int findHandler(unsigned int key) { //binary search, if not found returns -1-(position where it should be)
+	int low=0, high=NMEAparser.numOfHandlers-1;
+	while(low<=high) {
+		int mid=(low+high)/2;
+		if(NMEAparser.handlers[mid].key==key) return mid;
+		if(NMEAparser.handlers[mid].key<key) low=mid+1;
+		else high=mid-1;
+	}
+	return -1-low;
+}
+
+void startNewEpoch(float timestamp) { //a sentence with a newer time: forget what was received before
+	NMEAparser.newerTimestamp=timestamp;
+	NMEAparser.GGAfound=false;
+	NMEAparser.RMCfound=false;
+	NMEAparser.GSAfound=false;
+	NMEAparser.VTGfound=false;
+	NMEAparser.GLLfound=false;
+	NMEAparser.ZDAfound=false;
 }
 
 bool updateAltitude(float newAltitude, char altUnit, float timestamp) {
@@ -254,10 +332,6 @@ bool updateAltitude(float newAltitude, char altUnit, float timestamp) {
 		double deltaMt=GeoidalGetSeparation(Rad2Deg(gps.lat),Rad2Deg(gps.lon));
 		newAltitudeMt-=deltaMt;
 		newAltitudeFt-=m2Ft(deltaMt);
-		if(getMainStatus()==MAIN_DISPLAY_HSI) {
-			HSIdrawVSIscale(newAltitudeFt);
-			PrintAltitude(newAltitudeMt,newAltitudeFt);
-		}
 //		if(NMEAparser.altTimestamp!=0) {
 //			float deltaT;
 //			if(timestamp>NMEAparser.altTimestamp) deltaT=timestamp-NMEAparser.altTimestamp;
@@ -291,7 +365,6 @@ void updateDirection(float newTrueTrack, float magneticVar, bool isVarToEast, fl
 				if(isVarToEast) gps.magneticTrack=newTrueTrack-magneticVar;
 				else gps.magneticTrack=newTrueTrack+magneticVar;
 			}
-			if(getMainStatus()==MAIN_DISPLAY_HSI) HSIupdateDir(newTrueTrack);
 			if(NMEAparser.dirTimestamp!=0 && gps.speedKmh>10) {
 				float deltaT;
 				if(timestamp>NMEAparser.dirTimestamp) deltaT=timestamp-NMEAparser.dirTimestamp;
@@ -315,22 +388,64 @@ void updateDirection(float newTrueTrack, float magneticVar, bool isVarToEast, fl
 	NMEAparser.dirTimestamp=timestamp;
 }
 
-bool parseTime(char* field, int* timeHour, int* timeMin, float* timeSec) {
-	if(field[0]=='\0') return false;
-	return (sscanf(field,"%2d%2d%f",timeHour,timeMin,timeSec)==3); //Hour, Minute, second hhmmss.sss
+int hexValue(char c) {
+	if(c>='0' && c<='9') return c-'0';
+	if(c>='A' && c<='F') return c-'A'+10;
+	if(c>='a' && c<='f') return c-'a'+10;
+	return -1;
+}
+
+char firstChar(const struct NMEAfield *f) {
+	if(f->len==0) return '\0';
+	return f->str[0];
+}
+
+bool parseDigits(const char *str, int numDigits, int *value) { //exactly numDigits decimal digits
+	int v=0;
+	for(int i=0;i<numDigits;i++) {
+		if(str[i]<'0' || str[i]>'9') return false;
+		v=v*10+(str[i]-'0');
+	}
+	*value=v;
+	return true;
+}
+
+bool parseDecimal(const char *str, int len, float *value) { //[+-]ddd[.ddd] without the overhead of sscanf
+	int i=0, intPart=0, fracPart=0, fracDiv=1;
+	bool negative=false, digits=false;
+	if(len>0 && (str[0]=='-' || str[0]=='+')) negative=(str[i++]=='-');
+	for(;i<len && str[i]>='0' && str[i]<='9';i++) {
+		intPart=intPart*10+(str[i]-'0');
+		digits=true;
+	}
+	if(i<len && str[i]=='.') for(i++;i<len && str[i]>='0' && str[i]<='9';i++) {
+		if(fracDiv<100000000) { //further digits are beyond the float precision
+			fracPart=fracPart*10+(str[i]-'0');
+			fracDiv*=10;
+		}
+		digits=true;
+	}
+	if(!digits) return false;
+	double v=intPart+(double)fracPart/fracDiv;
+	*value=negative?-v:v;
+	return true;
+}
+
+bool parseTime(const struct NMEAfield *f, int* timeHour, int* timeMin, float* timeSec) {
+	if(f->len<6) return false;
+	return parseDigits(f->str,2,timeHour) && parseDigits(f->str+2,2,timeMin) && parseDecimal(f->str+4,f->len-4,timeSec); //Hour, Minute, second hhmmss.sss
 }
 
-bool parseDate(char* field, int* dd, int* mm, int* yy)
-{
-	if(field[0]=='\0') return false;
-	if(sscanf(field,"%2d%2d%d",dd,mm,yy)!=3) return false; //Date ddmmyy
+bool parseDate(const struct NMEAfield *f, int* dd, int* mm, int* yy) {
+	if(f->len<5) return false;
+	if(!parseDigits(f->str,2,dd) || !parseDigits(f->str+2,2,mm) || !parseDigits(f->str+4,f->len-4,yy)) return false; //Date ddmmyy
 	return (*dd>0 && *mm>0);
 }
 
-bool parseLatitude(char* firstField, char* secondField, int* latDeg, float* latMin, bool* latNorth) {
-	if(firstField[0]=='\0' || secondField[0]=='\0') return false;
-	if(sscanf(firstField,"%2d%f",latDeg,latMin)!=2) return false; //Latitude ddmm.mm
-	switch(secondField[0]) { //North or South
+bool parseLatitude(const struct NMEAfield *firstField, const struct NMEAfield *secondField, int* latDeg, float* latMin, bool* latNorth) {
+	if(firstField->len<3 || secondField->len==0) return false;
+	if(!parseDigits(firstField->str,2,latDeg) || !parseDecimal(firstField->str+2,firstField->len-2,latMin)) return false; //Latitude ddmm.mm
+	switch(secondField->str[0]) { //North or South
 		case 'N':
 			*latNorth=true;
 			return true;
@@ -342,14 +457,14 @@ bool parseLatitude(char* firstField, char* secondField, int* latDeg, float* latM
 	}
 }
 
-bool parseLongitude(char* firstField, char* secondField, int* lonDeg, float* lonMin, bool* lonEast) {
-	if(firstField[0]=='\0' || secondField[0]=='\0') return false;
-	if(sscanf(firstField,"%3d%f",lonDeg,lonMin)!=2) return false; //Longitude dddmm.mm
+bool parseLongitude(const struct NMEAfield *firstField, const struct NMEAfield *secondField, int* lonDeg, float* lonMin, bool* lonEast) {
+	if(firstField->len<4 || secondField->len==0) return false;
+	if(!parseDigits(firstField->str,3,lonDeg) || !parseDecimal(firstField->str+3,firstField->len-3,lonMin)) return false; //Longitude dddmm.mm
 	return parseEastWest(secondField,lonEast);
 }
 
-bool parseValid(char* field, bool* isValid) {
-	switch(field[0]) {
+bool parseValid(const struct NMEAfield *f, bool* isValid) {
+	switch(firstChar(f)) {
 		case 'A':
 			*isValid=true;
 			return true;
@@ -361,8 +476,8 @@ bool parseValid(char* field, bool* isValid) {
 	}
 }
 
-bool parseEastWest(char* field, bool* isEast) {
-	switch(field[0]) { //East or West
+bool parseEastWest(const struct NMEAfield *f, bool* isEast) {
+	switch(firstChar(f)) { //East or West
 		case 'E':
 			*isEast=true;
 			return true;
@@ -374,61 +489,67 @@ bool parseEastWest(char* field, bool* isEast) {
 	}
 }
 
-bool parseInteger(char* field, int* value)
-{
-	if(field[0]=='\0') return false;
-	return (sscanf(field,"%d",value)==1);
+bool parseInteger(const struct NMEAfield *f, int* value) {
+	int i=0, v=0;
+	bool negative=false;
+	if(f->len>0 && f->str[0]=='-') {
+		negative=true;
+		i++;
+	}
+	if(i==f->len || f->str[i]<'0' || f->str[i]>'9') return false;
+	for(;i<f->len && f->str[i]>='0' && f->str[i]<='9';i++) v=v*10+(f->str[i]-'0');
+	*value=negative?-v:v;
+	return true;
+}
+
+bool parseFloat(const struct NMEAfield *f, float* value) {
+	return parseDecimal(f->str,f->len,value);
+}
+
+int parseGGA(const struct NMEAfield *f, int lastField) {
+	if(lastField != 14) return 0;
+	int quality=firstChar(&f[6])-'0'; //Quality
+	char geoidalUnit=firstChar(&f[12]); //Geoidal Separation unit
+	if(geoidalUnit != 'M') {
+		#ifdef PRINT_SENTENCES
+		printLog("WARNING: Geoidal separation unit not in meters!");
+		#endif
+		return 0;
+	}
+	return storeFix(f,quality!=Q_NO_FIX,firstChar(&f[10])); //Altitude unit
 }
 
-bool parseFloat(char* field, float* value)
-{
-	if(field[0]=='\0') return false;
-	return (sscanf(field,"%f",value)==1);
+int parseGNS(const struct NMEAfield *f, int lastField) { //like GGA but for multiple constellations
+	if(lastField!=12 && lastField!=13) return 0;
+	bool hasFix=false;
+	for(int i=0;i<f[6].len;i++) if(f[6].str[i]!='N') hasFix=true; //Mode indicator: one char for each constellation, N is no fix
+	return storeFix(f,hasFix,'M'); //altitude is always in meters
 }
 
-int parseGGA() {
-	if(NMEAparser.fieldId != 14) return 0;
+int storeFix(const struct NMEAfield *f, bool hasFix, char altUnit) { //common part of GGA and GNS: they have the same fields from 1 to 9
 	int timeHour, timeMin;
 	float timeSec;
-	if(!parseTime(NMEAparser.fields[1],&timeHour,&timeMin,&timeSec)) return -1;
+	if(!parseTime(&f[1],&timeHour,&timeMin,&timeSec)) return -1;
 	int latGra=-91, lonGra=-181;
 	float latMin, lonMin;
 	bool latNorth, lonEast;
-	parseLatitude(NMEAparser.fields[2], NMEAparser.fields[3], &latGra, &latMin, &latNorth);
-	parseLongitude(NMEAparser.fields[4], NMEAparser.fields[5], &lonGra,&lonMin, &lonEast);
-	int quality=NMEAparser.fields[6][0]-'0'; //Quality
+	parseLatitude(&f[2],&f[3], &latGra, &latMin, &latNorth);
+	parseLongitude(&f[4],&f[5], &lonGra,&lonMin, &lonEast);
 	int numOfSatellites=-1;
-	parseInteger(NMEAparser.fields[7],&numOfSatellites); //Number of satellites
+	parseInteger(&f[7],&numOfSatellites); //Number of satellites
 	float hDilutionPrecision=-1;
-	parseFloat(NMEAparser.fields[8],&hDilutionPrecision); //H dilution
+	parseFloat(&f[8],&hDilutionPrecision); //H dilution
 	float alt=-1;
-	parseFloat(NMEAparser.fields[9],&alt); //Altitude
-	char altUnit=NMEAparser.fields[10][0]; //Altitude unit
-	float geoidalSeparation=0;
-	parseFloat(NMEAparser.fields[11],&geoidalSeparation); //Geoidal separation
-	char geoidalUnit=NMEAparser.fields[12][0]; //Geoidal Separation unit
-	if(geoidalUnit != 'M') {
-		#ifdef PRINT_SENTENCES
-		printLog("WARNING: Geoidal separation unit not in meters!");
-		#endif
-		return 0;
-	}
-	float diffAge=0;
-	parseFloat(NMEAparser.fields[13],&diffAge); //Age of differential GPS data
-	int diffRef=-1;
-	parseInteger(NMEAparser.fields[14],&diffRef); //Differential reference station ID, the last one
+	parseFloat(&f[9],&alt); //Altitude
 	float timestamp=timeHour*3600+timeMin*60+timeSec;
+	#ifdef PRINT_SENTENCES
+	printLog("Time difference: %f\n",timestamp-NMEAparser.rcvdTimestamp);
+	#endif
 	if(timestamp<NMEAparser.newerTimestamp) return 0; //the sentence is old
-	if(quality!=Q_NO_FIX) {
-		if(timestamp>NMEAparser.newerTimestamp) { //this is a new one sentence
-			NMEAparser.newerTimestamp=timestamp;
-			NMEAparser.GGAfound=true;
-			NMEAparser.RMCfound=false;
-			NMEAparser.GSAfound=false;
-		} else { //timestamp==newerTimestamp
-			if(NMEAparser.GGAfound) return 0;
-			else NMEAparser.GGAfound=true;
-		}
+	if(hasFix) {
+		if(timestamp>NMEAparser.newerTimestamp) startNewEpoch(timestamp); //this is a new one sentence
+		else if(NMEAparser.GGAfound) return 0; //timestamp==newerTimestamp
+		NMEAparser.GGAfound=true;
 		NMEAparser.alt=alt;
 		NMEAparser.altUnit=altUnit;
 		NMEAparser.latGra=latGra;
@@ -448,38 +569,34 @@ int parseGGA() {
 		updateFixMode(MODE_NO_FIX); //show that there is no fix
 		if(timestamp>NMEAparser.newerTimestamp) {
 			NMEAparser.newerTimestamp=timestamp;
-			updateTime(timestamp,timeHour,timeMin,timeSec,true); //show the time
+			updateTime(timestamp,timeHour,timeMin,timeSec);
 		}
 	}
 	return 0;
 }
 
-int parseRMC() {
-	if(NMEAparser.fieldId!=12 && NMEAparser.fieldId!=11) return 0;
+int parseRMC(const struct NMEAfield *f, int lastField) {
+	if(lastField!=12 && lastField!=11) return 0;
 	int timeHour=-1,timeMin=-1;
 	float timeSec=0;
-	if(!parseTime(NMEAparser.fields[1],&timeHour,&timeMin,&timeSec)) return -1;
+	if(!parseTime(&f[1],&timeHour,&timeMin,&timeSec)) return -1;
 	bool isValid=false;
-	if(!parseValid(NMEAparser.fields[2], &isValid)) return -2; //Status
+	if(!parseValid(&f[2], &isValid)) return -2; //Status
 	int timeDay=-1,timeMonth=-1,timeYear=-1;
-	if(!parseDate(NMEAparser.fields[9],&timeDay,&timeMonth,&timeYear)) return -9; //Date
+	if(!parseDate(&f[9],&timeDay,&timeMonth,&timeYear)) return -9; //Date
 	float timestamp=timeHour*3600+timeMin*60+timeSec;
 	if(timeDay!=gps.day) {
-		NMEAparser.newerTimestamp=timestamp; //change of date
+		startNewEpoch(timestamp); //change of date
 		NMEAparser.timeDay=timeDay;
 		NMEAparser.timeMonth=timeMonth;
 		NMEAparser.timeYear=timeYear;
 		NMEAparser.RMCfound=isValid;
-		NMEAparser.GGAfound=false;
-		NMEAparser.GSAfound=false;
-		updateTime(timestamp,timeHour,timeMin,timeSec,isValid); //show the time
+		updateTime(timestamp,timeHour,timeMin,timeSec);
 	} else if(timestamp<NMEAparser.newerTimestamp) return 0; //the sentence is old
 	else if(timestamp>NMEAparser.newerTimestamp) { //new sentence
-		NMEAparser.newerTimestamp=timestamp;
-		updateTime(timestamp,timeHour,timeMin,timeSec,isValid); //show the time
+		startNewEpoch(timestamp);
+		updateTime(timestamp,timeHour,timeMin,timeSec);
 		NMEAparser.RMCfound=isValid;
-		NMEAparser.GGAfound=false;
-		NMEAparser.GSAfound=false;
 	} else { // timestamp==NMEAparser.newerTimestamp
 		if(NMEAparser.RMCfound) return 0;
 		else NMEAparser.RMCfound=isValid;
@@ -489,18 +606,18 @@ int parseRMC() {
 		int latGra=-91, lonGra=-181;
 		float latMin=0, lonMin=0;
 		bool latNorth=true, lonEast=true;
-		parseLatitude(NMEAparser.fields[3], NMEAparser.fields[4], &latGra, &latMin, &latNorth);
-		parseLongitude(NMEAparser.fields[5], NMEAparser.fields[6], &lonGra,&lonMin, &lonEast);
+		parseLatitude(&f[3],&f[4], &latGra, &latMin, &latNorth);
+		parseLongitude(&f[5],&f[6], &lonGra,&lonMin, &lonEast);
 		float groundSpeedKnots=0;
-		parseFloat(NMEAparser.fields[7],&groundSpeedKnots); //Ground speed Knots
+		parseFloat(&f[7],&groundSpeedKnots); //Ground speed Knots
 		float trueTrack=0;
-		parseFloat(NMEAparser.fields[8],&trueTrack); //True track
+		parseFloat(&f[8],&trueTrack); //True track
 		float magneticVariation=0;
-		parseFloat(NMEAparser.fields[10],&magneticVariation); //Magnetic declination
+		parseFloat(&f[10],&magneticVariation); //Magnetic declination
 		bool magneticVariationToEast=true;
-		parseEastWest(NMEAparser.fields[11], &magneticVariationToEast); //Magnetic declination East or West, can be the last one
+		parseEastWest(&f[11], &magneticVariationToEast); //Magnetic declination East or West, can be the last one
 		char faa=FAA_ABSENT;
-		if(NMEAparser.fieldId==12) faa=NMEAparser.fields[12][0]; //FAA Indicator (optional)
+		if(lastField==12) faa=firstChar(&f[12]); //FAA Indicator (optional)
 		NMEAparser.latGra=latGra;
 		NMEAparser.latMin=latMin;
 		NMEAparser.latNorth=latNorth;
@@ -519,10 +636,10 @@ int parseRMC() {
 	return 0;
 }
 
-int parseGSA() {
-	if(NMEAparser.fieldId!=17) return 0;
+int parseGSA(const struct NMEAfield *f, int lastField) {
+	if(lastField!=17) return 0;
 	bool autoSelectionMode;
-	switch(NMEAparser.fields[1][0]) {  //Mode
+	switch(firstChar(&f[1])) {  //Mode
 		case 'A':
 			autoSelectionMode=true;
 			break;
@@ -533,16 +650,16 @@ int parseGSA() {
 			return (-1);
 	}
 	int mode=MODE_NO_FIX;
-	if(!parseInteger(NMEAparser.fields[2],&mode)) return -2; //Signal Strength
+	if(!parseInteger(&f[2],&mode)) return -2; //Signal Strength
 	int satellites[12];
 	int numOfSatellites=0;
-	for(short i=0;i<12;i++) if(parseInteger(NMEAparser.fields[i+3],&satellites[i])) numOfSatellites++; //Satellites IDs
+	for(short i=0;i<12;i++) if(parseInteger(&f[i+3],&satellites[i])) numOfSatellites++; //Satellites IDs
 	float pdop=0;
-	if(!parseFloat(NMEAparser.fields[15],&pdop)) return -15; //PDOP
+	if(!parseFloat(&f[15],&pdop)) return -15; //PDOP
 	float hdop=0;
-	if(!parseFloat(NMEAparser.fields[16],&hdop)) return -16; //HDOP
+	if(!parseFloat(&f[16],&hdop)) return -16; //HDOP
 	float vdop=0;
-	if(!parseFloat(NMEAparser.fields[17],&vdop)) return -17; //VDOP, the last one
+	if(!parseFloat(&f[17],&vdop)) return -17; //VDOP, the last one
 	updateFixMode(mode);
 	if(mode!=MODE_NO_FIX) {
 		if(NMEAparser.GSAfound) return 0;
@@ -559,15 +676,16 @@ int parseGSA() {
 	return 0;
 }
 
-int parseGSV() {
+int parseGSV(const struct NMEAfield *f, int lastField) {
 	int numOfGSVmsg=NMEAparser.numOfGSVmsg; //take a note of numOfGSV...
 	int GSVmsgSeqNo=NMEAparser.GSVmsgSeqNo; // ... and seq number
 	NMEAparser.numOfGSVmsg=0; // reset "a priori"
 	NMEAparser.GSVmsgSeqNo=0;
-	if(NMEAparser.fieldId < 7) return 0;
+	if(lastField < 7) return 0;
 	int sen,seq,sat; //Number of GSV messages, GSV message seq no, total number of satellites in view
-	if(parseInteger(NMEAparser.fields[1],&sen) && parseInteger(NMEAparser.fields[2],&seq) && parseInteger(NMEAparser.fields[3],&sat)) {
-		if(sen<=0 || seq<=0 || seq>sen || sat<0 || sat>MAX_NUM_SAT) return -2;
+	if(parseInteger(&f[1],&sen) && parseInteger(&f[2],&seq) && parseInteger(&f[3],&sat)) {
+		if(sen<=0 || seq<=0 || seq>sen || sat<0) return -2;
+		if(sat>MAX_NUM_SAT) sat=MAX_NUM_SAT; //GN sequences can count more satellites than our table
 	} else return -1;
 	if(seq==1) { //the first one resets GSVmsgSeqNo counter
 		numOfGSVmsg=sen;
@@ -580,15 +698,20 @@ int parseGSV() {
 		if(seq!=++GSVmsgSeqNo) return -4;
 		if(sat!=NMEAparser.GSVtotalSatInView) return -5;
 	}
-	int pos=5;
+	int pos=4; //ID of the first satellite
 	bool ok=true;
-	while(pos<=NMEAparser.fieldId && ok) {
+	while(pos<=lastField && ok) {
 		int satId;
-		if(!(ok=parseInteger(NMEAparser.fields[pos++],&satId))) break;
-		if(!(ok=(satId<=0 || satId>MAX_NUM_SAT))) break;
+		if(!(ok=parseInteger(&f[pos++],&satId))) break;
+		if(satId<=0 || satId>MAX_NUM_SAT) { //SBAS, GLONASS or other IDs not in our table
+			pos+=SAT_SNR-SAT_ELEVATION+1; //skip its elevation, azimuth and SNR
+			continue;
+		}
 		satId--;
-		for(int i=SAT_ELEVATION; i<=SAT_SNR && ok && pos<=NMEAparser.fieldId; i++) {
-			if(!(ok=parseInteger(NMEAparser.fields[pos++],&gps.satellites[satId][i]))) gps.satellites[satId][i]=-1;
+		for(int i=SAT_ELEVATION; i<=SAT_SNR && ok && pos<=lastField; i++) {
+			if(f[pos].len==0) gps.satellites[satId][i]=-1; //empty: SNR of a satellite not tracked
+			else if(!(ok=parseInteger(&f[pos],&gps.satellites[satId][i]))) gps.satellites[satId][i]=-1;
+			pos++;
 		}
 	}
 	if(!ok) return(-1-pos);
@@ -597,12 +720,96 @@ int parseGSV() {
 	return 1;
 }
 
-unsigned int getCRCintValue(void) {
-	if(NMEAparser.rcvdBytesOfSentence<9) return -1;
-	char asciiCheksum[2]; //two digits
-	asciiCheksum[0]=NMEAparser.sentence[NMEAparser.rcvdBytesOfSentence-2];
-	asciiCheksum[1]=NMEAparser.sentence[NMEAparser.rcvdBytesOfSentence-1];
-	unsigned int checksum;
-	sscanf(asciiCheksum,"%x",&checksum); //read as hex
-	return checksum;
+int parseVTG(const struct NMEAfield *f, int lastField) { //no time: it belongs to the last time received
+	if(lastField!=8 && lastField!=9) return 0;
+	if(lastField==9 && firstChar(&f[9])==FAA_NOTVAL) return 0; //FAA Indicator (optional)
+	float groundSpeedKnots=0;
+	if(!parseFloat(&f[5],&groundSpeedKnots)) return -5; //Ground speed Knots
+	float trueTrack=gps.trueTrack;
+	parseFloat(&f[1],&trueTrack); //True track, it can be empty when not moving
+	if(NMEAparser.VTGfound) return 0;
+	NMEAparser.VTGfound=true;
+	NMEAparser.groundSpeedKnots=groundSpeedKnots;
+	NMEAparser.trueTrack=trueTrack;
+	return 1;
+}
+
+int parseGLL(const struct NMEAfield *f, int lastField) {
+	if(lastField!=6 && lastField!=7) return 0;
+	int timeHour, timeMin;
+	float timeSec;
+	if(!parseTime(&f[5],&timeHour,&timeMin,&timeSec)) return -5;
+	bool isValid=false;
+	if(!parseValid(&f[6], &isValid)) return -6; //Status
+	if(lastField==7 && firstChar(&f[7])==FAA_NOTVAL) isValid=false; //FAA Indicator (optional)
+	if(!isValid) return 0;
+	int latGra, lonGra;
+	float latMin, lonMin;
+	bool latNorth, lonEast;
+	if(!parseLatitude(&f[1],&f[2], &latGra, &latMin, &latNorth)) return -1;
+	if(!parseLongitude(&f[3],&f[4], &lonGra,&lonMin, &lonEast)) return -3;
+	float timestamp=timeHour*3600+timeMin*60+timeSec;
+	if(timestamp<NMEAparser.newerTimestamp) return 0; //the sentence is old
+	if(timestamp>NMEAparser.newerTimestamp) startNewEpoch(timestamp); //new sentence
+	else if(NMEAparser.GLLfound) return 0;
+	NMEAparser.GLLfound=true;
+	NMEAparser.latGra=latGra;
+	NMEAparser.latMin=latMin;
+	NMEAparser.latNorth=latNorth;
+	NMEAparser.lonGra=lonGra;
+	NMEAparser.lonMin=lonMin;
+	NMEAparser.lonEast=lonEast;
+	NMEAparser.timeHour=timeHour;
+	NMEAparser.timeMin=timeMin;
+	NMEAparser.timeSec=timeSec;
+	return 1;
+}
+
+int parseZDA(const struct NMEAfield *f, int lastField) {
+	if(lastField!=6) return 0;
+	int timeHour, timeMin;
+	float timeSec;
+	if(!parseTime(&f[1],&timeHour,&timeMin,&timeSec)) return -1;
+	int timeDay, timeMonth, timeYear;
+	if(!parseInteger(&f[2],&timeDay) || timeDay<1 || timeDay>31) return -2; //Day
+	if(!parseInteger(&f[3],&timeMonth) || timeMonth<1 || timeMonth>12) return -3; //Month
+	if(!parseInteger(&f[4],&timeYear)) return -4; //Year with 4 digits
+	float timestamp=timeHour*3600+timeMin*60+timeSec;
+	if(timeDay!=gps.day) startNewEpoch(timestamp); //change of date
+	else if(timestamp<NMEAparser.newerTimestamp) return 0; //the sentence is old
+	else if(timestamp>NMEAparser.newerTimestamp) startNewEpoch(timestamp); //new sentence
+	else if(NMEAparser.ZDAfound) return 0;
+	NMEAparser.ZDAfound=true;
+	NMEAparser.timeDay=timeDay;
+	NMEAparser.timeMonth=timeMonth;
+	NMEAparser.timeYear=timeYear;
+	updateTime(timestamp,timeHour,timeMin,timeSec);
+	return 1;
+}
+
+int parseGST(const struct NMEAfield *f, int lastField) {
+	if(lastField!=8) return 0;
+	float latErr, lonErr, altErr;
+	if(!parseFloat(&f[6],&latErr)) return -6; //Standard deviation of latitude error in m
+	if(!parseFloat(&f[7],&lonErr)) return -7; //Standard deviation of longitude error in m
+	if(!parseFloat(&f[8],&altErr)) return -8; //Standard deviation of altitude error in m
+	updatePositionErrors(latErr,lonErr,altErr);
+	return 1;
+}
+
+int parseGBS(const struct NMEAfield *f, int lastField) {
+	if(lastField<8) return 0;
+	float latErr, lonErr, altErr;
+	if(!parseFloat(&f[2],&latErr)) return -2; //Expected error in latitude in m
+	if(!parseFloat(&f[3],&lonErr)) return -3; //Expected error in longitude in m
+	if(!parseFloat(&f[4],&altErr)) return -4; //Expected error in altitude in m
+	int failedSat=-1;
+	parseInteger(&f[5],&failedSat); //ID of most likely failed satellite, empty if none
+	updatePositionErrors(latErr,lonErr,altErr);
+	updateSuspectSat(failedSat);
+	return 1;
+}
+
+int ignoreSentence(const struct NMEAfield *f, int lastField) { //known sentences not used
+	return 0;
 }
@@ -6,7 +6,7 @@
 // Copyright   : (C) 2010-2020 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 22/11/2013
+// Last change : 17/10/2026
 // Description : Parses NMEA sentences from a GPS device
 //============================================================================
 
@@ -15,9 +15,30 @@
 
 #define NMEA_BUFFER_SIZE         (4096*6)
 #define MAX_SENTENCE_LENGTH 255
+#define NMEA_MAX_HANDLERS        32   //maximum number of sentence handlers that can be registered
+#define NMEA_ANY_TALKER          NULL //to register an handler for a sentence coming from any talker
 
-void NMEAparserProcessBuffer(unsigned char *buf, int redBytes);
+#include "Common.h"
 
+struct NMEAfield { //a field of the sentence: it points into the read buffer, it is not null terminated
+	const char *str;
+	int len;
+};
+
+//Handler of a sentence: fields[0] is the address (talker and sentence ID), lastField is the index of the last field
+//It returns 1 if the sentence has been accepted, 0 if it has been ignored and a negative number on error
+typedef int (*NMEAhandler)(const struct NMEAfield *fields, int lastField);
+
+struct NMEAparserStats {
+	unsigned long sentences;        //sentences received with the right checksum
+	unsigned long wrongSentences;   //sentences discarded because of wrong checksum or too many fields
+	unsigned long fixes;            //new positions or altitudes given to the navigator
+};
+
+int NMEAparserProcessSentence(const char *start, int available, bool *accepted);
+void NMEAparserCommit(void);
+bool NMEAparserRegister(const char *talker, const char *sentence, NMEAhandler handler);
+void NMEAparserGetStats(struct NMEAparserStats *stats);
 
 
 #endif
@@ -6,7 +6,7 @@
 // Copyright   : (C) 2010-2020 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 28/2/2016
+// Last change : 17/10/2026
 // Description : Navigation manager
 //============================================================================
 
@@ -18,31 +18,76 @@
 #include <string.h>
 #include <math.h>
 #include <pthread.h>
-#include <libroxml/roxml.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 #include "Navigator.h"
 #include "Configuration.h"
 #include "AirCalc.h"
 #include "GPSreceiver.h"
-#include "FBrender.h"
-#include "HSI.h"
 #include "Ephemerides.h"
+#include "SpatialIndex.h"
+#include "GPXreader.h"
 
 
-typedef struct wp {
-	int seqNo;            //sequence number
-	char *name;           //name of the WP
-	double latitude;      //rad
-	double longitude;     //rad
-	double altitude;      //meters
-	double dist;          //distance to to this WP in rad
-	double initialCourse; //initial true course to to this WP in rad
-	double finalCourse;   //final true course to this WP in rad
-	double bisector1;     //bisector in rad between this leg and the next
-	double bisector2;     //opposite bisector to bisector1 in rad
-	double arrTimestamp;  //arrival to this WP timestamp in seconds (from h 0:00)
-	struct wp *prev;      //Pointer to the previous waypoint in the list
-	struct wp *next;      //Pointer to the next waypoint in the list
-} *wayPoint;
+struct FlightPlan { //the route as structure of arrays, all of them in one single arena
+	int size;              //number of waypoints that the arena can hold
+	void *arena;           //the only allocation of the flight plan
+	double *latitude;      //rad
+	double *longitude;     //rad
+	double *sinLat;        //sine of the latitude
+	double *cosLat;        //cosine of the latitude
+	double *altitude;      //meters
+	double *dist;          //length of the leg to this WP in rad
+	double *initialCourse; //initial true course of the leg to this WP in rad
+	double *finalCourse;   //final true course of the leg to this WP in rad
+	double *bisector1;     //bisector in rad between the leg to this WP and the next
+	double *bisector2;     //opposite bisector to bisector1 in rad
+	double *totDist;       //distance in rad from the departure along the route to this WP
+	double *arrTimestamp;  //arrival to this WP timestamp in seconds (from h 0:00)
+	char (*name)[MAX_WP_NAME_LENGTH]; //names of the WPs
+};
+
+#define PLAN_NUM_ARRAYS 12 //number of arrays of doubles in the flight plan
+#define PLAN_MIN_SIZE   16 //waypoints allocated for a plan when the number is not known
+
+#define PLAN_CACHE_MAGIC   0x50464E41 //"ANFP" in the cache of the flight plan
+#define PLAN_CACHE_VERSION 1          //to be increased when the plan, the GPX reading or the legs calculation change
+#define PLAN_WP_BYTES      (PLAN_NUM_ARRAYS*sizeof(double)+MAX_WP_NAME_LENGTH) //bytes of each WP in the arena
+
+struct PlanCacheHeader { //at the beginning of the cache file, followed by the arena of the plan with size=numWayPoints
+	unsigned int magic;
+	unsigned int version;
+	unsigned int gpxSize;  //size and modification time of the GPX from which the cache has been made
+	int gpxMtime;
+	int numWayPoints;
+	unsigned int hash;     //of this header with hash=0 followed by the arena
+};
+
+#define LOAD_PROGRESS_WPS 60 //percent done when all the WPs are read, the rest is to calculate the legs
+
+enum pointRank { //kind of points taken as WPs: the first route, else the waypoints, else the first track
+	RANK_NONE,
+	RANK_TRACK,
+	RANK_WAYPOINTS,
+	RANK_ROUTE
+};
+
+struct PlanLoader { //the flight plan being loaded by the loader thread, published only when complete
+	pthread_t thread;
+	volatile enum navLoadStatus status;
+	volatile int progress;      //percent of the work done
+	volatile bool cancel;       //set to stop the loader thread
+	char *GPXfile;
+	int result;                 //number of WPs loaded or error code, as returned by NavLoadFlightPlan
+	struct FlightPlan plan;
+	int numWayPoints;
+	enum pointRank rank;        //kind of the points in the plan
+	bool noMemory;
+	double totalDistKm;
+	char *routeLogPath;
+};
 
 struct NavigatorStruct {
 	enum navigatorStatus status;
@@ -50,27 +95,49 @@ struct NavigatorStruct {
 	double trueCourse, remainDist, previousAltitude;
 	double totalDistKm, prevWPsTotDist; //Km
 	double prevWpAvgSpeed, prevTotAvgSpeed; //Km/h
-	wayPoint dept, currWP, dest;
+	struct FlightPlan plan;
+	int currWP, dest; //indexes of the WPs in the plan, the departure is always the first
 	char *routeLogPath;
-	FILE *routeLog;
 	double atd, trackErr, bearing;
 	double WPreaminDist,WPaverageSpeed,WPremaingTime;
 	double TotRemainDist,TotAverageSpeed,TotArrivalTime;
+	struct PlanLoader loader;
+	pthread_mutex_t mutex; //protects the navigation state shared between the GPS, render, main and loader threads
 };
 
 void NavConfigure(void);
+bool allocFlightPlan(struct FlightPlan *plan, const int numWayPoints, const int size);
+bool addWayPoint(struct FlightPlan *plan, int *numWayPoints, double latWP, double lonWP, double altWPmt, const char *WPname);
+void swapWayPoints(struct FlightPlan *plan, int i, int j);
+bool calcLegs(struct FlightPlan *plan, const int numWayPoints, volatile bool *cancel, volatile int *progress);
+void reverseArray(double *array, int first, int last);
+void reverseLegs(struct FlightPlan *plan, const int numWayPoints);
+void writeRouteLog(const struct FlightPlan *plan, const int numWayPoints, FILE *routeLog, double *totalDistKm);
+char* replaceExtension(const char *path, const char *ext);
+unsigned int hashBytes(unsigned int hash, const void *data, size_t len);
+bool loadPlanCache(struct PlanLoader *loader, const struct stat *gpxStat);
+void savePlanCache(const struct PlanLoader *loader, const struct stat *gpxStat);
 short NavCalculateRoute(void);
+bool addGPXpoint(const struct GPXpoint *point, int percent, void *data);
+int readGPX(struct PlanLoader *loader);
+int readFlightPlan(struct PlanLoader *loader);
+void clearRoute(void);
+void* loaderLoop(void *ptr);
 void NavFindNextWP(double lat, double lon);
 void updateDtgEteEtaAs(double atd, float timestamp, double remainDist);
+void updateNavigation(double lat, double lon, double altMt, double speedKmh, float timestamp);
 
 static struct NavigatorStruct Navigator = {
 	.status=NAV_STATUS_NOT_INIT,
 	.numWayPoints=0,
 	.previousAltitude=-1000,
-	.routeLog=NULL,
-	.currWP=NULL,
+	.plan={.size=0,.arena=NULL},
+	.currWP=0,
+	.dest=0,
 	.trueCourse=0,
-	.trackErr=0
+	.trackErr=0,
+	.loader={.status=NAV_LOAD_IDLE,.plan={.size=0,.arena=NULL}},
+	.mutex=PTHREAD_MUTEX_INITIALIZER
 };
 
 void NavConfigure(void) {
@@ -82,233 +149,495 @@ void NavConfigure(void) {
 	else Navigator.status=oldStatus;
 }
 
-short NavCalculateRoute(void) {
+bool allocFlightPlan(struct FlightPlan *plan, const int numWayPoints, const int size) { //allocate the arena for size WPs keeping the ones already in the plan
+	double *arrays=(double*)malloc(size*(PLAN_NUM_ARRAYS*sizeof(double)+MAX_WP_NAME_LENGTH));
+	if(arrays==NULL) {
+		printLog("ERROR: not enough memory for a flight plan of %d waypoints.\n",size);
+		return false;
+	}
+	if(plan->arena!=NULL) { //move the WPs already loaded in the new arena
+		int i;
+		double *oldArrays=(double*)plan->arena;
+		for(i=0;i<PLAN_NUM_ARRAYS;i++) memcpy(arrays+i*size,oldArrays+i*plan->size,numWayPoints*sizeof(double));
+		memcpy(arrays+PLAN_NUM_ARRAYS*size,plan->name,numWayPoints*MAX_WP_NAME_LENGTH);
+		free(plan->arena);
+	}
+	plan->arena=arrays;
+	plan->size=size;
+	plan->latitude=arrays;
+	plan->longitude=arrays+size;
+	plan->sinLat=arrays+2*size;
+	plan->cosLat=arrays+3*size;
+	plan->altitude=arrays+4*size;
+	plan->dist=arrays+5*size;
+	plan->initialCourse=arrays+6*size;
+	plan->finalCourse=arrays+7*size;
+	plan->bisector1=arrays+8*size;
+	plan->bisector2=arrays+9*size;
+	plan->totDist=arrays+10*size;
+	plan->arrTimestamp=arrays+11*size;
+	plan->name=(char(*)[MAX_WP_NAME_LENGTH])(arrays+PLAN_NUM_ARRAYS*size); //the names after all the doubles
+	return true;
+}
+
+bool addWayPoint(struct FlightPlan *plan, int *numWayPoints, double latWP, double lonWP, double altWPmt, const char *WPname) {
+	if(*numWayPoints==plan->size) //arena full: move the plan in a bigger one
+		if(!allocFlightPlan(plan,*numWayPoints,plan->size<PLAN_MIN_SIZE?PLAN_MIN_SIZE:2*plan->size)) return false;
+	int wp=(*numWayPoints)++;
+	plan->latitude[wp]=latWP;
+	plan->longitude[wp]=lonWP;
+	plan->sinLat[wp]=sin(latWP);
+	plan->cosLat[wp]=cos(latWP);
+	plan->altitude[wp]=altWPmt;
+	if(WPname!=NULL) {
+		strncpy(plan->name[wp],WPname,MAX_WP_NAME_LENGTH-1);
+		plan->name[wp][MAX_WP_NAME_LENGTH-1]='\0';
+	} else snprintf(plan->name[wp],MAX_WP_NAME_LENGTH,"Unamed WP %d",wp+1);
+	return true;
+}
+
+void swapWayPoints(struct FlightPlan *plan, int i, int j) { //swap just the data of the WPs, the legs have to be recalculated
+	char name[MAX_WP_NAME_LENGTH];
+	double tmp;
+	tmp=plan->latitude[i]; plan->latitude[i]=plan->latitude[j]; plan->latitude[j]=tmp;
+	tmp=plan->longitude[i]; plan->longitude[i]=plan->longitude[j]; plan->longitude[j]=tmp;
+	tmp=plan->sinLat[i]; plan->sinLat[i]=plan->sinLat[j]; plan->sinLat[j]=tmp;
+	tmp=plan->cosLat[i]; plan->cosLat[i]=plan->cosLat[j]; plan->cosLat[j]=tmp;
+	tmp=plan->altitude[i]; plan->altitude[i]=plan->altitude[j]; plan->altitude[j]=tmp;
+	memcpy(name,plan->name[i],MAX_WP_NAME_LENGTH);
+	memcpy(plan->name[i],plan->name[j],MAX_WP_NAME_LENGTH);
+	memcpy(plan->name[j],name,MAX_WP_NAME_LENGTH);
+}
+
+bool calcLegs(struct FlightPlan *plan, const int numWayPoints, volatile bool *cancel, volatile int *progress) { //legs of the plan, returns false if canceled
+	int prev,wp;
+	plan->dist[0]=0;
+	plan->totDist[0]=0;
+	for(wp=1;wp<numWayPoints;wp++) {
+		if(cancel!=NULL && *cancel) return false;
+		if(progress!=NULL) *progress=LOAD_PROGRESS_WPS+(100-LOAD_PROGRESS_WPS)*wp/numWayPoints;
+		prev=wp-1;
+		plan->initialCourse[wp]=calcGreatCircleRouteTrig(plan->latitude[prev],plan->sinLat[prev],plan->cosLat[prev],plan->longitude[prev],plan->latitude[wp],plan->longitude[wp],&plan->dist[wp]);
+		plan->finalCourse[wp]=calcGreatCircleFinalCourse(plan->latitude[prev],plan->longitude[prev],plan->latitude[wp],plan->longitude[wp]);
+		plan->totDist[wp]=plan->totDist[prev]+plan->dist[wp];
+		if(prev!=0) calcBisector(plan->finalCourse[prev],plan->initialCourse[wp],&plan->bisector1[prev],&plan->bisector2[prev]); //calc bisectors for prev WP
+	}
+	return true;
+}
+
+void reverseArray(double *array, int first, int last) {
+	double tmp;
+	for(;first<last;first++,last--) {
+		tmp=array[first];
+		array[first]=array[last];
+		array[last]=tmp;
+	}
+}
+
+void reverseLegs(struct FlightPlan *plan, const int numWayPoints) { //the WPs are already swapped: each leg is an old one run backwards, no trigonometry needed
+	int wp,last=numWayPoints-1;
+	double initialCourse;
+	reverseArray(plan->dist,1,last);
+	reverseArray(plan->initialCourse,1,last);
+	reverseArray(plan->finalCourse,1,last);
+	for(wp=1;wp<numWayPoints;wp++) {
+		initialCourse=plan->initialCourse[wp]; //the initial course backwards is the opposite of the final one and vice versa
+		plan->initialCourse[wp]=absAngle(plan->finalCourse[wp]+M_PI);
+		plan->finalCourse[wp]=absAngle(initialCourse+M_PI);
+		plan->totDist[wp]=plan->totDist[wp-1]+plan->dist[wp];
+		if(wp>1) calcBisector(plan->finalCourse[wp-1],plan->initialCourse[wp],&plan->bisector1[wp-1],&plan->bisector2[wp-1]);
+	}
+}
+
+void writeRouteLog(const struct FlightPlan *plan, const int numWayPoints, FILE *routeLog, double *totalDistKm) { //the legs must be already calculated
+	int prev,wp;
+	*totalDistKm=0;
+	if(numWayPoints==1) {
+		fprintf(routeLog,"* Route with only one waypoint: %s\n",plan->name[0]);
+		return;
+	}
+	for(wp=1;wp<numWayPoints;wp++) {
+		prev=wp-1;
+		double remainDistance=Rad2Km(plan->dist[wp]);
+		*totalDistKm+=remainDistance;
+		fprintf(routeLog,"* Travel from %s to %s\n",plan->name[prev],plan->name[wp]);
+		fprintf(routeLog,"Initial course to WP: %07.3f°\n",Rad2Deg(plan->initialCourse[wp]));
+		fprintf(routeLog,"Final   course to WP: %07.3f°\n",Rad2Deg(plan->finalCourse[wp]));
+		fprintf(routeLog,"Horizontal distance to WP is: %.3f Km\n",remainDistance);
+		double timeHours=remainDistance/config.cruiseSpeed; //hours
+		int hours,mins;
+		float secs;
+		convertDecimal2DegMinSec(timeHours,&hours,&mins,&secs);
+		fprintf(routeLog,"Flight time to WP: %2d:%02d:%02d\n",hours,mins,(int)secs);
+		fprintf(routeLog,"Initial altitude: %.0f m  %.0f Ft\n",plan->altitude[prev],m2Ft(plan->altitude[prev]));
+		fprintf(routeLog,"Final altitude: %.0f m  %.0f Ft\n",plan->altitude[wp],m2Ft(plan->altitude[wp]));
+		double altDiff=plan->altitude[wp]-plan->altitude[prev];
+		double slope=altDiff/1000/remainDistance;
+		fprintf(routeLog,"Slope: %.2f %%\n",slope*100);
+		double climb=altDiff/(timeHours*3600); // m/s
+		fprintf(routeLog,"Estimated climb rate: %.2f m/s  %.0f Ft/min\n\n",climb,ms2FtMin(climb)); //just to have an idea
+	}
+	fprintf(routeLog,"TOTAL distance from departure along all WPs to Navigator.destination is: %.3f Km\n",*totalDistKm);
+	double totalTimeHours=*totalDistKm/config.cruiseSpeed;
+	int hours,mins;
+	float secs;
+	convertDecimal2DegMinSec(totalTimeHours,&hours,&mins,&secs);
+	fprintf(routeLog,"TOTAL flight time: %2d:%02d:%02d\n",hours,mins,(int)secs);
+	double fuelNeeded=config.fuelConsumption*totalTimeHours;
+	fprintf(routeLog,"TOTAL fuel needed: %.2f liters\n\n",fuelNeeded);
+}
+
+short NavCalculateRoute(void) { //the legs must be already calculated by calcLegs, the mutex must be already locked
 	if(Navigator.status==NAV_STATUS_NO_ROUTE_SET) Navigator.status=NAV_STATUS_NAV_BUSY;
 	else if(Navigator.status!=NAV_STATUS_NAV_BUSY) return -1;
-	if(Navigator.dept!=NULL) {
-		if(Navigator.numWayPoints>1) {
-				if(Navigator.dept->next==NULL) return -3;
-		} else if(Navigator.numWayPoints!=1) return -4;
-	} else return -5;
-	Navigator.totalDistKm=0;
+	if(Navigator.numWayPoints<1) return -5;
+	struct FlightPlan *plan=&Navigator.plan;
 	Navigator.prevWPsTotDist=0;
-	Navigator.dest=Navigator.currWP;
-	calcFlightPlanEphemerides(Navigator.dest->latitude,Navigator.dest->longitude,false);
+	Navigator.dest=Navigator.numWayPoints-1;
+	calcFlightPlanEphemerides(plan->latitude[Navigator.dest],plan->longitude[Navigator.dest],false);
 	if(Navigator.numWayPoints>1) {
-		Navigator.currWP=Navigator.dept->next;
-		do {
-			Navigator.currWP->initialCourse=calcGreatCircleRoute(Navigator.currWP->prev->latitude,Navigator.currWP->prev->longitude,Navigator.currWP->latitude,Navigator.currWP->longitude,&Navigator.currWP->dist);
-			Navigator.currWP->finalCourse=calcGreatCircleFinalCourse(Navigator.currWP->prev->latitude,Navigator.currWP->prev->longitude,Navigator.currWP->latitude,Navigator.currWP->longitude);
-			double remainDistance=Rad2Km(Navigator.currWP->dist);
-			Navigator.totalDistKm+=remainDistance;
-			fprintf(Navigator.routeLog,"* Travel from %s to %s\n",Navigator.currWP->prev->name,Navigator.currWP->name);
-			fprintf(Navigator.routeLog,"Initial course to WP: %07.3f°\n",Rad2Deg(Navigator.currWP->initialCourse));
-			fprintf(Navigator.routeLog,"Final   course to WP: %07.3f°\n",Rad2Deg(Navigator.currWP->finalCourse));
-			fprintf(Navigator.routeLog,"Horizontal distance to WP is: %.3f Km\n",remainDistance);
-			if(Navigator.currWP->prev!=Navigator.dept) calcBisector(Navigator.currWP->prev->finalCourse,Navigator.currWP->initialCourse,&Navigator.currWP->prev->bisector1,&Navigator.currWP->prev->bisector2); //calc bisectors for prev WP
-			double timeHours=remainDistance/config.cruiseSpeed; //hours
-			if(Navigator.currWP==Navigator.dept->next) {
-				Navigator.WPreaminDist=remainDistance;
-				Navigator.WPaverageSpeed=config.cruiseSpeed;
-				Navigator.WPremaingTime=timeHours;
-			}
-			int hours,mins;
-			float secs;
-			convertDecimal2DegMinSec(timeHours,&hours,&mins,&secs);
-			fprintf(Navigator.routeLog,"Flight time to WP: %2d:%02d:%02d\n",hours,mins,(int)secs);
-			fprintf(Navigator.routeLog,"Initial altitude: %.0f m  %.0f Ft\n",Navigator.currWP->prev->altitude,m2Ft(Navigator.currWP->prev->altitude));
-			fprintf(Navigator.routeLog,"Final altitude: %.0f m  %.0f Ft\n",Navigator.currWP->altitude,m2Ft(Navigator.currWP->altitude));
-			double altDiff=Navigator.currWP->altitude-Navigator.currWP->prev->altitude;
-			double slope=altDiff/1000/remainDistance;
-			fprintf(Navigator.routeLog,"Slope: %.2f %%\n",slope*100);
-			double climb=altDiff/(timeHours*3600); // m/s
-			fprintf(Navigator.routeLog,"Estimated climb rate: %.2f m/s  %.0f Ft/min\n\n",climb,ms2FtMin(climb)); //just to have an idea
-			Navigator.currWP=Navigator.currWP->next;
-		} while(Navigator.currWP!=NULL);
-		fprintf(Navigator.routeLog,"TOTAL distance from departure along all WPs to Navigator.destination is: %.3f Km\n",Navigator.totalDistKm);
-		Navigator.trueCourse=Navigator.dept->next->initialCourse;
+		Navigator.WPreaminDist=Rad2Km(plan->dist[1]);
+		Navigator.WPaverageSpeed=config.cruiseSpeed;
+		Navigator.WPremaingTime=Navigator.WPreaminDist/config.cruiseSpeed;
+		Navigator.trueCourse=plan->initialCourse[1];
 		double totalTimeHours=Navigator.totalDistKm/config.cruiseSpeed;
-		int hours,mins;
-		float secs;
-		convertDecimal2DegMinSec(totalTimeHours,&hours,&mins,&secs);
-		fprintf(Navigator.routeLog,"TOTAL flight time: %2d:%02d:%02d\n",hours,mins,(int)secs);
-		pthread_mutex_lock(&gps.mutex);
-		Navigator.TotArrivalTime=gps.timestamp;
-		pthread_mutex_unlock(&gps.mutex);
+		struct GPSdata snapshot;
+		GPSgetSnapshot(&snapshot);
+		Navigator.TotArrivalTime=snapshot.timestamp;
 		if(Navigator.TotArrivalTime<0) Navigator.TotArrivalTime=getCurrentTime(); //In this case we don't have the time from GPS so we take it from the internal clock
 		Navigator.TotArrivalTime=Navigator.TotArrivalTime/3600+totalTimeHours; //hours, in order to obtain the ETA
 		Navigator.TotRemainDist=Navigator.totalDistKm;
 		Navigator.TotAverageSpeed=config.cruiseSpeed;
-		double fuelNeeded=config.fuelConsumption*totalTimeHours;
-		fprintf(Navigator.routeLog,"TOTAL fuel needed: %.2f liters\n\n",fuelNeeded);
-		calcFlightPlanEphemerides(Navigator.dept->latitude,Navigator.dept->longitude,true);
-		Navigator.currWP=Navigator.dept->next;
-	} else //Navigator.numWayPoints==1
-		fprintf(Navigator.routeLog,"* Route with only one waypoint: %s\n",Navigator.currWP->name);
-	if(Navigator.routeLog!=NULL) fclose(Navigator.routeLog); //Close the route log file when not needed
+		calcFlightPlanEphemerides(plan->latitude[0],plan->longitude[0],true);
+		SpatialIndexBuild(plan->sinLat,plan->cosLat,plan->longitude,Navigator.numWayPoints); //if it fails NavFindNextWP will search without it
+		Navigator.currWP=1;
+	} else Navigator.currWP=0; //Navigator.numWayPoints==1
 	Navigator.status=NAV_STATUS_TO_START_NAV;
 	return 1;
 }
 
-int NavLoadFlightPlan(char* GPXfile) {
-	if(GPXfile==NULL) return -1;
-	if(Navigator.status==NAV_STATUS_NOT_INIT) NavConfigure();
-	if(Navigator.status==NAV_STATUS_NOT_INIT) return -2;
-	NavClearRoute();
-	Navigator.routeLogPath=strdup(GPXfile);
-	int len=strlen(Navigator.routeLogPath);
-	Navigator.routeLogPath[len-3]='t';
-	Navigator.routeLogPath[len-2]='x';
-	Navigator.routeLogPath[len-1]='t';
-	Navigator.routeLog=fopen(Navigator.routeLogPath,"w"); //Create the route log file: NavCalculateRoute() will write in it
-	if(Navigator.routeLog==NULL) {
+bool addGPXpoint(const struct GPXpoint *point, int percent, void *data) { //called by the GPX reader for each point, data is the loader
+	struct PlanLoader *loader=(struct PlanLoader*)data;
+	enum pointRank rank;
+	if(loader->cancel) return false;
+	loader->progress=LOAD_PROGRESS_WPS*percent/100;
+	switch(point->type) {
+		case GPX_ROUTE_POINT:
+			if(point->list>0) return true; //TODO: here we load just the first route may be there are others routes in the GPX file...
+			rank=RANK_ROUTE;
+			break;
+		case GPX_WAYPOINT:
+			rank=RANK_WAYPOINTS;
+			break;
+		default:
+			if(point->list>0) return true; //all the segments of the first track
+			rank=RANK_TRACK;
+			break;
+	}
+	if(rank<loader->rank) return true;
+	if(rank>loader->rank) { //better kind of points: the ones taken so far are dropped
+		loader->rank=rank;
+		loader->numWayPoints=0;
+	}
+	if(!addWayPoint(&loader->plan,&loader->numWayPoints,Deg2Rad(point->lat),Deg2Rad(-point->lon),point->ele,point->name[0]!='\0'?point->name:NULL)) { //East longitudes are positive according to the GPX standard
+		loader->noMemory=true;
+		return false;
+	}
+	return true;
+}
+
+char* replaceExtension(const char *path, const char *ext) { //new string with the last 3 characters of path replaced by ext
+	char *newPath=strdup(path);
+	int len=strlen(newPath);
+	if(len>=3) strcpy(newPath+len-3,ext);
+	return newPath;
+}
+
+unsigned int hashBytes(unsigned int hash, const void *data, size_t len) { //FNV-1a, start with 2166136261
+	const unsigned char *bytes=(const unsigned char*)data;
+	while(len--) hash=(hash^*bytes++)*16777619;
+	return hash;
+}
+
+bool loadPlanCache(struct PlanLoader *loader, const struct stat *gpxStat) { //take the plan from its cache if this is still valid for the GPX
+	char *cachePath=replaceExtension(loader->GPXfile,"fpc");
+	int fd=open(cachePath,O_RDONLY);
+	free(cachePath);
+	if(fd<0) return false;
+	struct stat cacheStat;
+	if(fstat(fd,&cacheStat)!=0 || cacheStat.st_size<(off_t)sizeof(struct PlanCacheHeader)) {
+		close(fd);
+		return false;
+	}
+	void *map=mmap(NULL,cacheStat.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+	close(fd);
+	if(map==MAP_FAILED) return false;
+	struct PlanCacheHeader header;
+	memcpy(&header,map,sizeof(struct PlanCacheHeader));
+	size_t arenaBytes=cacheStat.st_size-sizeof(struct PlanCacheHeader);
+	bool valid=header.magic==PLAN_CACHE_MAGIC && header.version==PLAN_CACHE_VERSION &&
+		header.gpxSize==(unsigned int)gpxStat->st_size && header.gpxMtime==(int)gpxStat->st_mtime &&
+		header.numWayPoints>0 && arenaBytes==header.numWayPoints*PLAN_WP_BYTES;
+	if(valid) {
+		unsigned int hash=header.hash;
+		header.hash=0;
+		valid=hashBytes(hashBytes(2166136261U,&header,sizeof(struct PlanCacheHeader)),(char*)map+sizeof(struct PlanCacheHeader),arenaBytes)==hash;
+	}
+	if(valid) valid=allocFlightPlan(&loader->plan,0,header.numWayPoints);
+	if(valid) { //the arena in the file has exactly the layout of the one just allocated
+		memcpy(loader->plan.arena,(char*)map+sizeof(struct PlanCacheHeader),arenaBytes);
+		loader->numWayPoints=header.numWayPoints;
+	}
+	munmap(map,cacheStat.st_size);
+	return valid;
+}
+
+void savePlanCache(const struct PlanLoader *loader, const struct stat *gpxStat) { //written in a temporary file then renamed: a cache is never seen half written
+	const struct FlightPlan *plan=&loader->plan;
+	int i,num=loader->numWayPoints;
+	struct PlanCacheHeader header;
+	memset(&header,0,sizeof(struct PlanCacheHeader)); //also the padding is hashed
+	header.magic=PLAN_CACHE_MAGIC;
+	header.version=PLAN_CACHE_VERSION;
+	header.gpxSize=gpxStat->st_size;
+	header.gpxMtime=gpxStat->st_mtime;
+	header.numWayPoints=num;
+	header.hash=hashBytes(2166136261U,&header,sizeof(struct PlanCacheHeader));
+	for(i=0;i<PLAN_NUM_ARRAYS;i++) header.hash=hashBytes(header.hash,(double*)plan->arena+i*plan->size,num*sizeof(double));
+	header.hash=hashBytes(header.hash,plan->name,num*MAX_WP_NAME_LENGTH);
+	char *cachePath=replaceExtension(loader->GPXfile,"fpc");
+	char *tmpPath=replaceExtension(loader->GPXfile,"tmp");
+	FILE *cache=fopen(tmpPath,"wb");
+	bool written=cache!=NULL && fwrite(&header,sizeof(struct PlanCacheHeader),1,cache)==1;
+	for(i=0;i<PLAN_NUM_ARRAYS && written;i++) written=fwrite((double*)plan->arena+i*plan->size,sizeof(double),num,cache)==(size_t)num;
+	if(written) written=fwrite(plan->name,MAX_WP_NAME_LENGTH,num,cache)==(size_t)num;
+	if(cache!=NULL && fclose(cache)!=0) written=false;
+	if(written) written=rename(tmpPath,cachePath)==0;
+	if(!written) {
+		printLog("WARNING: not possible to write the cache of the flight plan: %s\n",cachePath);
+		unlink(tmpPath);
+	}
+	free(cachePath);
+	free(tmpPath);
+}
+
+int readGPX(struct PlanLoader *loader) { //read the WPs of the GPX in the plan of the loader, returns what GPXreaderParse returns
+	loader->numWayPoints=0;
+	loader->rank=RANK_NONE;
+	loader->noMemory=false;
+	return GPXreaderParse(loader->GPXfile,addGPXpoint,loader); //the plan grows while the file is read
+}
+
+int readFlightPlan(struct PlanLoader *loader) { //read the GPX, or its cache, and calculate the legs in the plan of the loader, returns the number of WPs or an error code
+	char *GPXfile=loader->GPXfile;
+	struct stat gpxStat;
+	if(stat(GPXfile,&gpxStat)!=0) {
+		printLog("ERROR no such file '%s'\n",GPXfile);
+		return -4;
+	}
+	loader->routeLogPath=replaceExtension(GPXfile,"txt");
+	FILE *routeLog=fopen(loader->routeLogPath,"w"); //Create the route log file: writeRouteLog() will write in it
+	if(routeLog==NULL) {
 		printLog("ERROR not possible to write the route log file.\n");
-		Navigator.status=NAV_STATUS_NO_ROUTE_SET;
 		return -3;
 	}
-	node_t* root=roxml_load_doc(GPXfile);
-	if(root==NULL) {
+	if(loadPlanCache(loader,&gpxStat)) { //the legs are already there: just the route log to write
+		writeRouteLog(&loader->plan,loader->numWayPoints,routeLog,&loader->totalDistKm);
+		fclose(routeLog);
+		return loader->numWayPoints;
+	}
+	int numPoints=readGPX(loader);
+	if(numPoints==-1) {
 		printLog("ERROR no such file '%s'\n",GPXfile);
+		fclose(routeLog);
 		return -4;
 	}
-	char* text=NULL;
-	//TODO: here we load just the first route may be there are others routes in the GPX file...
-	node_t* route=roxml_get_chld(root,"rte",0);
-	if(route==NULL) {
+	if(loader->noMemory) {
+		fclose(routeLog);
+		return -6;
+	}
+	if(numPoints<-1) printLog("WARNING: GPX file '%s' is not complete, using the points read.\n",GPXfile);
+	if(loader->numWayPoints<1 && !loader->cancel) {
 		printLog("ERROR no route found in GPX file: '%s'\n",GPXfile);
-		roxml_release(RELEASE_ALL);
-		roxml_close(root);
+		fclose(routeLog);
 		return -5;
 	}
-	node_t* wp;
-	int total=roxml_get_chld_nb(route);
-	if(total<1) {
-		printLog("ERROR no waypoints found in route in GPX file: '%s'\n",GPXfile);
-		roxml_release(RELEASE_ALL);
-		roxml_close(root);
-		return 0;
+	bool calculated=!loader->cancel && calcLegs(&loader->plan,loader->numWayPoints,&loader->cancel,&loader->progress);
+	if(calculated) writeRouteLog(&loader->plan,loader->numWayPoints,routeLog,&loader->totalDistKm);
+	fclose(routeLog); //Close the route log file when not needed
+	if(!calculated) {
+		printLog("Loading of '%s' canceled.\n",GPXfile);
+		return NAV_LOAD_CANCELED;
 	}
-	int wpcounter=0,i;
-	node_t* node;
-	double latX,lonX,altX;
-	for(i=0;i<total;i++) {
-		wp=roxml_get_chld(route,NULL,i);
-		text=roxml_get_name(wp,NULL,0);
-		if(strcmp(text,"rtept")==0) {
-			wpcounter++;
-			node=roxml_get_attr(wp,"lat",0);
-			if(node!=NULL) {
-				text=roxml_get_content(node,NULL,0,NULL);
-				latX=atof(text);
-			} else break; //WP without latitude, skip it
-			node=roxml_get_attr(wp,"lon",0);
-			if(node!=NULL) {
-				text=roxml_get_content(node,NULL,0,NULL);
-				lonX=atof(text);
-			} else break; //WP without longitude, skip it
-			node=roxml_get_chld(wp,"ele",0);
-			if(node!=NULL) {
-				text=roxml_get_content(node,NULL,0,NULL);
-				if(text!=NULL) altX=atof(text);
-				else altX=0;
-			} else altX=0; //WP altitude missing we put it to 0
-			node=roxml_get_chld(wp,"name",0);
-			if(node!=NULL) {
-				text=roxml_get_content(node,NULL,0,NULL);
-				if(text==NULL) asprintf(&text,"Unamed WP %d",wpcounter);
-			} else asprintf(&text,"Unamed WP %d",wpcounter);
-			NavAddWayPoint(Deg2Rad(latX),Deg2Rad(-lonX),altX,text); //East longitudes are positive according to the GPX standard
+	if(numPoints>0) savePlanCache(loader,&gpxStat); //not for incomplete files: they could be still being written
+	return loader->numWayPoints;
+}
+
+void clearRoute(void) { //the mutex must be already locked
+	SpatialIndexClear();
+	free(Navigator.plan.arena); //all the WPs go away with their arena
+	Navigator.plan.arena=NULL;
+	Navigator.plan.size=0;
+	Navigator.numWayPoints=0;
+	Navigator.currWP=0;
+	Navigator.dest=0;
+	Navigator.trueCourse=0;
+	Navigator.trackErr=0;
+	Navigator.remainDist=-1;
+	Navigator.atd=-1;
+	Navigator.WPreaminDist=-1;
+	Navigator.TotRemainDist=-1;
+	free(Navigator.routeLogPath);
+	Navigator.routeLogPath=NULL;
+}
+
+void* loaderLoop(void *ptr) { //reads the new flight plan, it will be ran in a separate thread
+	struct PlanLoader *loader=&Navigator.loader;
+	loader->result=readFlightPlan(loader);
+	if(loader->result>0) { //publish the new plan in place of the old one
+		pthread_mutex_lock(&Navigator.mutex);
+		Navigator.status=NAV_STATUS_NAV_BUSY;
+		clearRoute();
+		Navigator.plan=loader->plan;
+		Navigator.numWayPoints=loader->numWayPoints;
+		Navigator.totalDistKm=loader->totalDistKm;
+		Navigator.routeLogPath=loader->routeLogPath;
+		if(NavCalculateRoute()<0) {
+			printLog("ERROR: NavCalculateRoute FAILED.\n");
+			clearRoute();
+			Navigator.status=NAV_STATUS_NO_ROUTE_SET;
+			loader->result=-3;
 		}
+		pthread_mutex_unlock(&Navigator.mutex);
+	} else { //the current plan, if any, remains
+		free(loader->plan.arena);
+		free(loader->routeLogPath);
 	}
-	roxml_release(RELEASE_ALL);
-	roxml_close(root);
-	if(NavCalculateRoute()<0) {
-		printLog("ERROR: NavCalculateRoute FAILED.\n");
-		NavClearRoute();
-		return -3;
+	loader->plan.arena=NULL;
+	loader->plan.size=0;
+	loader->routeLogPath=NULL;
+	loader->progress=100;
+	MEMORY_BARRIER();
+	loader->status=NAV_LOAD_DONE;
+	pthread_exit(NULL);
+	return NULL;
+}
+
+bool NavLoadFlightPlanStart(const char *GPXfile) { //load the flight plan in background, the result is taken with NavLoadFlightPlanEnd
+	if(GPXfile==NULL || Navigator.loader.status!=NAV_LOAD_IDLE) return false;
+	if(Navigator.status==NAV_STATUS_NOT_INIT) NavConfigure();
+	if(Navigator.status==NAV_STATUS_NOT_INIT) return false;
+	struct PlanLoader *loader=&Navigator.loader;
+	loader->GPXfile=strdup(GPXfile);
+	loader->progress=0;
+	loader->cancel=false;
+	loader->result=0;
+	loader->status=NAV_LOAD_RUNNING;
+	if(pthread_create(&loader->thread,NULL,loaderLoop,(void*)NULL)) {
+		printLog("ERROR: unable to start the thread to load the flight plan.\n");
+		free(loader->GPXfile);
+		loader->GPXfile=NULL;
+		loader->status=NAV_LOAD_IDLE;
+		return false;
 	}
-	return wpcounter;
+	return true;
+}
+
+enum navLoadStatus NavGetLoadStatus(int *progress) {
+	if(progress!=NULL) *progress=Navigator.loader.progress;
+	return Navigator.loader.status;
+}
+
+void NavCancelLoad(void) {
+	if(Navigator.loader.status==NAV_LOAD_RUNNING) Navigator.loader.cancel=true;
+}
+
+int NavLoadFlightPlanEnd(void) { //wait the end of the loader and return the number of WPs loaded or an error code
+	struct PlanLoader *loader=&Navigator.loader;
+	if(loader->status==NAV_LOAD_IDLE) return -1;
+	pthread_join(loader->thread,NULL);
+	free(loader->GPXfile);
+	loader->GPXfile=NULL;
+	loader->status=NAV_LOAD_IDLE;
+	return loader->result;
+}
+
+bool NavGetPlanInfo(const char *GPXfile, struct NavPlanInfo *info) { //summary of a flight plan without loading it: from its cache, else the GPX is read and the cache written
+	struct PlanLoader reader;
+	struct stat gpxStat;
+	bool found=false;
+	int wp;
+	if(GPXfile==NULL || info==NULL || stat(GPXfile,&gpxStat)!=0) return false;
+	memset(&reader,0,sizeof(struct PlanLoader));
+	reader.GPXfile=strdup(GPXfile);
+	if(loadPlanCache(&reader,&gpxStat)) found=true;
+	else {
+		int numPoints=readGPX(&reader);
+		if(reader.numWayPoints>0 && calcLegs(&reader.plan,reader.numWayPoints,NULL,NULL)) {
+			found=true;
+			if(numPoints>0) savePlanCache(&reader,&gpxStat); //the next selection of the plan will be faster
+		}
+	}
+	if(found) {
+		info->numWayPoints=reader.numWayPoints;
+		info->totalDistKm=0;
+		for(wp=1;wp<reader.numWayPoints;wp++) info->totalDistKm+=Rad2Km(reader.plan.dist[wp]); //as in the route log
+		strcpy(info->departure,reader.plan.name[0]);
+		strcpy(info->destination,reader.plan.name[reader.numWayPoints-1]);
+	}
+	free(reader.plan.arena);
+	free(reader.GPXfile);
+	return found;
+}
+
+int NavLoadFlightPlan(char* GPXfile) {
+	if(!NavLoadFlightPlanStart(GPXfile)) return -1;
+	return NavLoadFlightPlanEnd();
 }
 
 void NavAddWayPoint(double latWP, double lonWP, double altWPmt, char *WPname) {
 	if(Navigator.status!=NAV_STATUS_NO_ROUTE_SET) return;
-	wayPoint newWP;
-	newWP=(wayPoint)malloc(sizeof(struct wp));
-	newWP->name=strdup(WPname);
-	newWP->latitude=latWP;
-	newWP->longitude=lonWP;
-	newWP->altitude=altWPmt;
-	newWP->next=NULL;
-	if(Navigator.numWayPoints==0) { //its's the first
-		Navigator.dept=newWP;
-		newWP->prev=NULL;
-	} else {
-		Navigator.currWP->next=newWP;
-		newWP->prev=Navigator.currWP; //link to the previous
-	}
-	Navigator.currWP=newWP;
-	newWP->seqNo=Navigator.numWayPoints++;
+	if(addWayPoint(&Navigator.plan,&Navigator.numWayPoints,latWP,lonWP,altWPmt,WPname)) Navigator.currWP=Navigator.numWayPoints-1;
 }
 
 int NavReverseRoute(void) {
 	if(Navigator.status==NAV_STATUS_NAV_BUSY || Navigator.status==NAV_STATUS_NO_ROUTE_SET || Navigator.numWayPoints<2) return 0;
+	pthread_mutex_lock(&Navigator.mutex);
 	Navigator.status=NAV_STATUS_NAV_BUSY;
-	Navigator.dest=Navigator.dept;
-	Navigator.currWP=Navigator.dept;
-	wayPoint next;
-	int i=Navigator.numWayPoints-1;
-	while(Navigator.currWP->next!=NULL) {
-		Navigator.currWP->seqNo=i--;
-		next=Navigator.currWP->next;
-		Navigator.currWP->next=Navigator.currWP->prev;
-		Navigator.currWP->prev=next;
-		Navigator.currWP=next;
-	}
-	Navigator.currWP->seqNo=0;
-	Navigator.currWP->next=Navigator.currWP->prev;
-	Navigator.currWP->prev=NULL;
-	Navigator.dept=Navigator.currWP;
-	Navigator.currWP=Navigator.dest;
-	Navigator.routeLog=fopen(Navigator.routeLogPath,"a+"); //Reopen the route log file to write about the reversed route
-	if(Navigator.routeLog==NULL) {
+	int i;
+	for(i=0;i<Navigator.numWayPoints/2;i++) swapWayPoints(&Navigator.plan,i,Navigator.numWayPoints-1-i);
+	FILE *routeLog=fopen(Navigator.routeLogPath,"a+"); //Reopen the route log file to write about the reversed route
+	if(routeLog==NULL) {
+		pthread_mutex_unlock(&Navigator.mutex);
 		printLog("ERROR not possible to write the route log file.\n");
 		NavClearRoute();
 		return 0;
 	}
-	fprintf(Navigator.routeLog,"\n\n\nREVERSED ROUTE\n\n");
+	fprintf(routeLog,"\n\n\nREVERSED ROUTE\n\n");
+	reverseLegs(&Navigator.plan,Navigator.numWayPoints);
+	writeRouteLog(&Navigator.plan,Navigator.numWayPoints,routeLog,&Navigator.totalDistKm);
+	fclose(routeLog);
 	if(NavCalculateRoute()<0) {
+		pthread_mutex_unlock(&Navigator.mutex);
 		printLog("ERROR: NavCalculateRoute FAILED!\n");
 		NavClearRoute();
 		return 0;
 	}
+	pthread_mutex_unlock(&Navigator.mutex);
 	return 1;
 }
 
 void NavClearRoute(void) {
+	pthread_mutex_lock(&Navigator.mutex);
 	Navigator.status=NAV_STATUS_NAV_BUSY;
-	if(Navigator.numWayPoints!=0) {
-		do {
-			Navigator.currWP=Navigator.dept;
-			free(Navigator.currWP->name);
-			Navigator.currWP->name=NULL;
-			Navigator.dept=Navigator.currWP->next;
-			free(Navigator.currWP);
-			Navigator.currWP=NULL;
-		} while(Navigator.dept!=NULL);
-		Navigator.numWayPoints=0;
-	}
-	Navigator.trueCourse=0;
-	Navigator.trackErr=0;
-	Navigator.remainDist=-1;
-	Navigator.atd=-1;
-	Navigator.WPreaminDist=-1;
-	Navigator.TotRemainDist=-1;
-	free(Navigator.routeLogPath);
-	Navigator.routeLogPath=NULL;
+	clearRoute();
 	Navigator.status=NAV_STATUS_NO_ROUTE_SET;
+	pthread_mutex_unlock(&Navigator.mutex);
 }
 
 void NavClose(void) {
+	NavCancelLoad();
+	NavLoadFlightPlanEnd();
 	NavClearRoute();
 	Navigator.status=NAV_STATUS_NOT_INIT;
 }
@@ -320,88 +649,90 @@ void NavFindNextWP(double lat, double lon) {
 		Navigator.status=NAV_STATUS_NAV_TO_SINGLE_WP;
 		return;
 	}
-	wayPoint i, nearest=Navigator.dept;
-	double shortestDist=calcAngularDist(lat,lon,Navigator.dept->latitude,Navigator.dept->longitude);
-	for(i=Navigator.dept->next;i!=NULL;i=i->next) { //searching the nearest
-		double distance=calcAngularDist(lat,lon,i->latitude,i->longitude);
-		if(distance<=shortestDist) {
-			shortestDist=distance;
-			nearest=i;
-		}
-	}
-	printLog("\nNearest waypoint is: %s No: %d at %f Km\n",nearest->name,nearest->seqNo,Rad2Km(shortestDist));
+	struct FlightPlan *plan=&Navigator.plan;
+	double shortestDist;
+	int nearest=SpatialIndexNearestPoint(lat,lon,&shortestDist); //searching the nearest
+	if(nearest<0) nearest=calcNearestPoint(lat,lon,plan->latitude,plan->longitude,Navigator.numWayPoints,&shortestDist); //without index check all of them
+	printLog("\nNearest waypoint is: %s No: %d at %f Km\n",plan->name[nearest],nearest,Rad2Km(shortestDist));
 	if(nearest==Navigator.dest) {
-		if(Navigator.dept->latitude==Navigator.dest->latitude && Navigator.dept->longitude==Navigator.dest->longitude) { //Navigator.dept and Navigator.dest are the same place
-			if(calcAngularDist(lat,lon,Navigator.dept->latitude,Navigator.dept->longitude)<m2Rad(config.deptDistTolerance)) Navigator.currWP=Navigator.dept->next;
+		if(plan->latitude[0]==plan->latitude[Navigator.dest] && plan->longitude[0]==plan->longitude[Navigator.dest]) { //departure and destination are the same place
+			if(calcAngularDist(lat,lon,plan->latitude[0],plan->longitude[0])<m2Rad(config.deptDistTolerance)) Navigator.currWP=1;
 			else Navigator.currWP=Navigator.dest;
 		} else Navigator.currWP=Navigator.dest;
 	} else { //The nearest WP isn't the Navigator.destination
-		if(calcAngularDist(lat,lon,nearest->next->latitude,nearest->next->longitude)<=nearest->next->dist) Navigator.currWP=nearest->next;
+		int leg=-1;
+		if(nearest>0) leg=SpatialIndexNearestLeg(lat,lon,NULL); //in the middle of the route we are flying the nearest leg
+		if(leg>0) Navigator.currWP=leg;
+		else if(calcAngularDist(lat,lon,plan->latitude[nearest+1],plan->longitude[nearest+1])<=plan->dist[nearest+1]) Navigator.currWP=nearest+1;
 		else Navigator.currWP=nearest;
 	}
-	if(Navigator.currWP==Navigator.dept) {
-		if(calcAngularDist(lat,lon,Navigator.dept->latitude,Navigator.dept->longitude)<m2Rad(config.deptDistTolerance)) { //we are near the dpt
-			Navigator.currWP=Navigator.dept->next;
+	if(Navigator.currWP==0) {
+		if(calcAngularDist(lat,lon,plan->latitude[0],plan->longitude[0])<m2Rad(config.deptDistTolerance)) { //we are near the dpt
+			Navigator.currWP=1;
 			Navigator.status=NAV_STATUS_NAV_TO_WPT;
 		} else Navigator.status=NAV_STATUS_NAV_TO_DPT; //we have still to go to the departure
 	} else { //we are not traveling to the departure
-		if(Navigator.currWP->seqNo>1) { //  //Navigator.currWP->prev!=Navigator.dept  if we aren't traveling direcly from the departure
-			Navigator.prevWPsTotDist=0;
-			for(i=Navigator.dept->next;i!=Navigator.currWP;i=i->next) Navigator.prevWPsTotDist+=i->dist;
-			Navigator.prevWPsTotDist=Rad2Km(Navigator.prevWPsTotDist);
-			Navigator.currWP->prev->arrTimestamp=Navigator.dept->arrTimestamp+(Navigator.prevWPsTotDist/config.cruiseSpeed)*3600; //ETA to the previous WP, adding the time to reach the previous WP
+		if(Navigator.currWP>1) { //if we aren't traveling direcly from the departure
+			Navigator.prevWPsTotDist=Rad2Km(plan->totDist[Navigator.currWP-1]); //already summed along the route by NavCalculateRoute
+			plan->arrTimestamp[Navigator.currWP-1]=plan->arrTimestamp[0]+(Navigator.prevWPsTotDist/config.cruiseSpeed)*3600; //ETA to the previous WP, adding the time to reach the previous WP
 		}
 		Navigator.status=NAV_STATUS_NAV_TO_WPT;
 	}
 	if(Navigator.currWP==Navigator.dest) Navigator.status=NAV_STATUS_NAV_TO_DST;
-	printLog("Next waypoint is: %s\n\n\n",Navigator.currWP->name);
+	printLog("Next waypoint is: %s\n\n\n",plan->name[Navigator.currWP]);
 }
 
 void NavStartNavigation() {
+	struct FlightPlan *plan=&Navigator.plan;
 	if(Navigator.status!=NAV_STATUS_TO_START_NAV) return;
-	pthread_mutex_lock(&gps.mutex);
-	float timestamp=gps.timestamp; //timestamp is the real time when we start the travel try to get it from GPS
+	struct GPSdata snapshot;
+	GPSgetSnapshot(&snapshot);
+	float timestamp=snapshot.timestamp; //timestamp is the real time when we start the travel try to get it from GPS
 	if(timestamp==-1) timestamp=getCurrentTime(); //if not valid get it from internal clock
-	if(timestamp<0) {
-		pthread_mutex_unlock(&gps.mutex);
-		return;
-	}
-	if(gps.fixMode>MODE_NO_FIX && gps.lat!=100) { //if have fix give immediately the position to the nav. The lat!=100 is just to avoid the case of having fix but still not a position stored
-		NavFindNextWP(gps.lat,gps.lon);
-		if(Navigator.status==NAV_STATUS_NAV_TO_WPT || Navigator.status==NAV_STATUS_NAV_TO_DST || Navigator.status==NAV_STATUS_NAV_TO_SINGLE_WP) Navigator.dept->arrTimestamp=timestamp; //record the starting time for whole route
-		NavUpdatePosition(gps.lat,gps.lon,gps.realAltMt,gps.speedKmh,timestamp);
+	if(timestamp<0) return;
+	pthread_mutex_lock(&Navigator.mutex);
+	if(snapshot.fixMode>MODE_NO_FIX && snapshot.lat!=100) { //if have fix give immediately the position to the nav. The lat!=100 is just to avoid the case of having fix but still not a position stored
+		NavFindNextWP(snapshot.lat,snapshot.lon);
+		if(Navigator.status==NAV_STATUS_NAV_TO_WPT || Navigator.status==NAV_STATUS_NAV_TO_DST || Navigator.status==NAV_STATUS_NAV_TO_SINGLE_WP) plan->arrTimestamp[0]=timestamp; //record the starting time for whole route
+		updateNavigation(snapshot.lat,snapshot.lon,snapshot.realAltMt,snapshot.speedKmh,timestamp);
 	} else {
-		if(Navigator.numWayPoints>1) Navigator.currWP=Navigator.dept->next;
+		if(Navigator.numWayPoints>1) Navigator.currWP=1;
 		else Navigator.currWP=Navigator.dest;
 		Navigator.status=NAV_STATUS_WAIT_FIX;
 	}
-	pthread_mutex_unlock(&gps.mutex);
+	pthread_mutex_unlock(&Navigator.mutex);
 }
 
 void updateDtgEteEtaAs(double atd, float timestamp, double remainDist) {
-	if(timestamp>Navigator.currWP->prev->arrTimestamp) { //to avoid infinite, null or negative speed and time
+	struct FlightPlan *plan=&Navigator.plan;
+	if(timestamp>plan->arrTimestamp[Navigator.currWP-1]) { //to avoid infinite, null or negative speed and time
 		Navigator.WPreaminDist=Rad2Km(remainDist); //Km
 		if(atd>=0) {
-			Navigator.WPaverageSpeed=ms2Kmh(Rad2m(atd)/(timestamp-Navigator.currWP->prev->arrTimestamp));
+			Navigator.WPaverageSpeed=ms2Kmh(Rad2m(atd)/(timestamp-plan->arrTimestamp[Navigator.currWP-1]));
 			Navigator.prevWpAvgSpeed=Navigator.WPaverageSpeed;
 		} else Navigator.WPaverageSpeed=Navigator.prevWpAvgSpeed; //with negative ATDs we estimate using previous average speed
 		Navigator.WPremaingTime=Navigator.WPreaminDist/Navigator.WPaverageSpeed; //ETE (remaining time) in hours
-		if(getMainStatus()==MAIN_DISPLAY_HSI) PrintNavRemainingDistWP(Navigator.WPreaminDist,Navigator.WPaverageSpeed,Navigator.WPremaingTime);
 	}
-	if(timestamp>Navigator.dept->arrTimestamp) {
+	if(timestamp>plan->arrTimestamp[0]) {
 		double totCoveredDistKm=Navigator.prevWPsTotDist+Rad2Km(atd);
 		if(atd>=0) {
-			Navigator.TotAverageSpeed=ms2Kmh((totCoveredDistKm*1000)/(timestamp-Navigator.dept->arrTimestamp)); //Km/h
+			Navigator.TotAverageSpeed=ms2Kmh((totCoveredDistKm*1000)/(timestamp-plan->arrTimestamp[0])); //Km/h
 			Navigator.prevTotAvgSpeed=Navigator.TotAverageSpeed;
 		} else Navigator.TotAverageSpeed=Navigator.prevTotAvgSpeed;
 		Navigator.TotRemainDist=Navigator.totalDistKm-totCoveredDistKm; //Km
 		Navigator.TotArrivalTime=Navigator.TotRemainDist/Navigator.TotAverageSpeed; //hours
 		Navigator.TotArrivalTime+=timestamp/3600; //hours, in order to obtain the ETA
-		if(getMainStatus()==MAIN_DISPLAY_HSI) PrintNavRemainingDistDST(Navigator.TotRemainDist,Navigator.TotAverageSpeed,Navigator.TotArrivalTime);
 	}
 }
 
 void NavUpdatePosition(double lat, double lon, double altMt, double speedKmh, float timestamp) {
+	pthread_mutex_lock(&Navigator.mutex);
+	updateNavigation(lat,lon,altMt,speedKmh,timestamp);
+	pthread_mutex_unlock(&Navigator.mutex);
+}
+
+void updateNavigation(double lat, double lon, double altMt, double speedKmh, float timestamp) { //the mutex must be already locked
+	struct FlightPlan *plan=&Navigator.plan;
 	//TODO: somwhere here update ephemerides
 	switch(Navigator.status) {
 		case NAV_STATUS_NOT_INIT:
@@ -412,180 +743,125 @@ void NavUpdatePosition(double lat, double lon, double altMt, double speedKmh, fl
 			if(Navigator.previousAltitude==-1000) Navigator.previousAltitude=altMt;
 			else if(altMt-Navigator.previousAltitude>config.takeOffdiffAlt && speedKmh>config.stallSpeed) { //in this case start the navigation
 				NavFindNextWP(lat,lon);
-				if(Navigator.status==NAV_STATUS_NAV_TO_WPT || Navigator.status==NAV_STATUS_NAV_TO_DST || Navigator.status==NAV_STATUS_NAV_TO_SINGLE_WP) Navigator.dept->arrTimestamp=timestamp; //record the starting time for whole route
-				NavUpdatePosition(lat,lon,altMt,speedKmh,timestamp); //recursive call
-				if(getMainStatus()==MAIN_DISPLAY_HSI) PrintNavStatus(Navigator.status,Navigator.currWP->name);
+				if(Navigator.status==NAV_STATUS_NAV_TO_WPT || Navigator.status==NAV_STATUS_NAV_TO_DST || Navigator.status==NAV_STATUS_NAV_TO_SINGLE_WP) plan->arrTimestamp[0]=timestamp; //record the starting time for whole route
+				updateNavigation(lat,lon,altMt,speedKmh,timestamp); //recursive call
 				break;
 			}
-			if(Navigator.numWayPoints>1) Navigator.bearing=calcGreatCircleRoute(lat,lon,Navigator.dept->next->latitude,Navigator.dept->next->longitude,&Navigator.remainDist); //calc just course and distance
-			else Navigator.bearing=calcGreatCircleRoute(lat,lon,Navigator.dest->latitude,Navigator.dest->longitude,&Navigator.remainDist); //numWayPoint==1
-			if(getMainStatus()==MAIN_DISPLAY_HSI) {
-				PrintNavDTG(Navigator.remainDist);
-				HSIupdateCDI(Rad2Deg(Navigator.bearing),0,false,0);
-			}
+			if(Navigator.numWayPoints>1) Navigator.bearing=calcGreatCircleRoute(lat,lon,plan->latitude[1],plan->longitude[1],&Navigator.remainDist); //calc just course and distance
+			else Navigator.bearing=calcGreatCircleRoute(lat,lon,plan->latitude[Navigator.dest],plan->longitude[Navigator.dest],&Navigator.remainDist); //numWayPoint==1
 			break;
 		case NAV_STATUS_NAV_TO_DPT: //we are still going to the departure point
-			Navigator.bearing=calcGreatCircleRoute(lat,lon,Navigator.dept->latitude,Navigator.dept->longitude,&Navigator.remainDist); //calc just course and distance
-			if(getMainStatus()==MAIN_DISPLAY_HSI) {
-				PrintNavDTG(Navigator.remainDist);
-				HSIupdateCDI(Rad2Deg(Navigator.bearing),0,false,0);
-			}
+			Navigator.bearing=calcGreatCircleRoute(lat,lon,plan->latitude[0],plan->longitude[0],&Navigator.remainDist); //calc just course and distance
 			if(Navigator.remainDist<m2Rad(config.deptDistTolerance)) {
-				Navigator.currWP=Navigator.dept->next;
-				Navigator.dept->arrTimestamp=timestamp; //here we record the starting time for whole route
+				Navigator.currWP=1;
+				plan->arrTimestamp[0]=timestamp; //here we record the starting time for whole route
 				if(Navigator.currWP!=Navigator.dest) Navigator.status=NAV_STATUS_NAV_TO_WPT;
 				else Navigator.status=NAV_STATUS_NAV_TO_DST; //Next WP is already the final Navigator.destination
-				if(getMainStatus()==MAIN_DISPLAY_HSI) PrintNavStatus(Navigator.status,Navigator.currWP->name);
-				NavUpdatePosition(lat,lon,altMt,speedKmh,timestamp); //recursive call
+				updateNavigation(lat,lon,altMt,speedKmh,timestamp); //recursive call
 			}
 			break;
 		case NAV_STATUS_NAV_TO_WPT: {
-			Navigator.trackErr=Rad2m(calcGCCrossTrackError(Navigator.currWP->prev->latitude,Navigator.currWP->prev->longitude,Navigator.currWP->longitude,lat,lon,Navigator.currWP->initialCourse,&Navigator.atd));
-			if(Navigator.atd>=0) Navigator.remainDist=Navigator.currWP->dist-Navigator.atd;
-			else Navigator.remainDist=Navigator.currWP->dist+fabs(Navigator.atd); //negative ATD: we are still before the prev WP
+			Navigator.trackErr=Rad2m(calcGCCrossTrackErrorTrig(plan->latitude[Navigator.currWP-1],plan->sinLat[Navigator.currWP-1],plan->cosLat[Navigator.currWP-1],plan->longitude[Navigator.currWP-1],plan->longitude[Navigator.currWP],lat,lon,plan->initialCourse[Navigator.currWP],&Navigator.atd));
+			if(Navigator.atd>=0) Navigator.remainDist=plan->dist[Navigator.currWP]-Navigator.atd;
+			else Navigator.remainDist=plan->dist[Navigator.currWP]+fabs(Navigator.atd); //negative ATD: we are still before the prev WP
 			//TODO: Need to check here, the bearing can be taken from here...
-			Navigator.bearing=calcGreatCircleCourse(lat,lon,Navigator.currWP->latitude,Navigator.currWP->longitude); //Find the direct direction to curr WP (needed to check if we passed the bisector)
-			if(Navigator.atd>=0 && (Navigator.atd>=Navigator.currWP->dist || bisectorOverpassed(Navigator.currWP->finalCourse,Navigator.bearing,Navigator.currWP->bisector1,Navigator.currWP->bisector2))) { //consider this WP as reached
-				Navigator.currWP->arrTimestamp=timestamp;
-				Navigator.prevWPsTotDist+=Rad2Km(Navigator.currWP->dist);
-				Navigator.currWP=Navigator.currWP->next;
+			Navigator.bearing=calcGreatCircleCourse(lat,lon,plan->latitude[Navigator.currWP],plan->longitude[Navigator.currWP]); //Find the direct direction to curr WP (needed to check if we passed the bisector)
+			if(Navigator.atd>=0 && (Navigator.atd>=plan->dist[Navigator.currWP] || bisectorOverpassed(plan->finalCourse[Navigator.currWP],Navigator.bearing,plan->bisector1[Navigator.currWP],plan->bisector2[Navigator.currWP]))) { //consider this WP as reached
+				plan->arrTimestamp[Navigator.currWP]=timestamp;
+				Navigator.prevWPsTotDist+=Rad2Km(plan->dist[Navigator.currWP]);
+				Navigator.currWP++;
 				if(Navigator.currWP==Navigator.dest) Navigator.status=NAV_STATUS_NAV_TO_DST; //Next WP is the final Navigator.destination
-				if(getMainStatus()==MAIN_DISPLAY_HSI) PrintNavStatus(Navigator.status,Navigator.currWP->name);
-				NavUpdatePosition(lat,lon,altMt,speedKmh,timestamp); //Recursive call on the new WayPoint
+				updateNavigation(lat,lon,altMt,speedKmh,timestamp); //Recursive call on the new WayPoint
 				return;
 			} //else the WP or bisector is still not reached...
 			if(fabs(Navigator.trackErr)>config.trackErrorTolearnce) { //if we have bigger error
 				double latI,lonI; //the perpendicular point on the route
-				calcIntermediatePoint(Navigator.currWP->prev->latitude,Navigator.currWP->prev->longitude,Navigator.currWP->latitude,Navigator.currWP->longitude,Navigator.atd,Navigator.currWP->dist,&latI,&lonI);
-				Navigator.trueCourse=calcGreatCircleCourse(latI,lonI,Navigator.currWP->latitude,Navigator.currWP->longitude);
+				calcIntermediatePoint(plan->latitude[Navigator.currWP-1],plan->longitude[Navigator.currWP-1],plan->latitude[Navigator.currWP],plan->longitude[Navigator.currWP],Navigator.atd,plan->dist[Navigator.currWP],&latI,&lonI);
+				Navigator.trueCourse=calcGreatCircleCourse(latI,lonI,plan->latitude[Navigator.currWP],plan->longitude[Navigator.currWP]);
 			} else Navigator.trueCourse=Navigator.bearing; //with small error the bearing is fine enough
-			if(getMainStatus()==MAIN_DISPLAY_HSI) {
-				HSIupdateCDI(Rad2Deg(Navigator.trueCourse),Navigator.trackErr,true,Rad2Deg(Navigator.bearing));
-				PrintNavTrackATD(Navigator.atd);
-				if(Navigator.atd>=0) HSIupdateVSI(m2Ft((Navigator.currWP->altitude-Navigator.currWP->prev->altitude)/Navigator.currWP->dist*Navigator.atd+Navigator.currWP->prev->altitude));
-			}
 			updateDtgEteEtaAs(Navigator.atd,timestamp,Navigator.remainDist);
 		} break;
 		case NAV_STATUS_NAV_TO_DST: {
-			double atd, trackErr;
-			trackErr=Rad2m(calcGCCrossTrackError(Navigator.currWP->prev->latitude,Navigator.currWP->prev->longitude,Navigator.currWP->longitude,lat,lon,Navigator.currWP->initialCourse,&atd));
-			if(atd>=0) Navigator.remainDist=Navigator.currWP->dist-atd;
-			else Navigator.remainDist=Navigator.currWP->dist+fabs(atd); //negative ATD: we are still before the prev WP
-			if(atd>=Navigator.currWP->dist) { //consider Navigator.destination as reached (90 degrees bisector)
-				Navigator.currWP->arrTimestamp=timestamp;
+			Navigator.trackErr=Rad2m(calcGCCrossTrackErrorTrig(plan->latitude[Navigator.currWP-1],plan->sinLat[Navigator.currWP-1],plan->cosLat[Navigator.currWP-1],plan->longitude[Navigator.currWP-1],plan->longitude[Navigator.currWP],lat,lon,plan->initialCourse[Navigator.currWP],&Navigator.atd));
+			if(Navigator.atd>=0) Navigator.remainDist=plan->dist[Navigator.currWP]-Navigator.atd;
+			else Navigator.remainDist=plan->dist[Navigator.currWP]+fabs(Navigator.atd); //negative ATD: we are still before the prev WP
+			if(Navigator.atd>=plan->dist[Navigator.currWP]) { //consider Navigator.destination as reached (90 degrees bisector)
+				plan->arrTimestamp[Navigator.currWP]=timestamp;
 				Navigator.status=NAV_STATUS_END_NAV;
-				if(getMainStatus()==MAIN_DISPLAY_HSI) PrintNavStatus(Navigator.status,"Nowhere");
-				NavUpdatePosition(lat,lon,altMt,speedKmh,timestamp); //Recursive call on the new WayPoint
+				updateNavigation(lat,lon,altMt,speedKmh,timestamp); //Recursive call on the new WayPoint
 				return;
 			} //else the Navigator.destination is still not reached...
-			Navigator.bearing=calcGreatCircleCourse(lat,lon,Navigator.currWP->latitude,Navigator.currWP->longitude); //just find the direct direction to the Navigator.destination
-			if(fabs(trackErr)<config.trackErrorTolearnce) Navigator.trueCourse=Navigator.bearing; //with really small error
+			Navigator.bearing=calcGreatCircleCourse(lat,lon,plan->latitude[Navigator.currWP],plan->longitude[Navigator.currWP]); //just find the direct direction to the Navigator.destination
+			if(fabs(Navigator.trackErr)<config.trackErrorTolearnce) Navigator.trueCourse=Navigator.bearing; //with really small error
 			else { //otherwise we have bigger error and so we calculate it better...
 				double latI,lonI; //the perpendicular point on the route
-				calcIntermediatePoint(Navigator.currWP->prev->latitude,Navigator.currWP->prev->longitude,Navigator.currWP->latitude,Navigator.currWP->longitude,atd,Navigator.currWP->dist,&latI,&lonI);
-				Navigator.trueCourse=calcGreatCircleCourse(latI,lonI,Navigator.currWP->latitude,Navigator.currWP->longitude);
-			}
-			if(getMainStatus()==MAIN_DISPLAY_HSI) {
-				PrintNavTrackATD(atd);
-				HSIupdateCDI(Rad2Deg(Navigator.trueCourse),trackErr,true,Rad2Deg(Navigator.bearing));
-				if(atd>=0) HSIupdateVSI(m2Ft((Navigator.currWP->altitude-Navigator.currWP->prev->altitude)/Navigator.currWP->dist*atd+Navigator.currWP->prev->altitude));
+				calcIntermediatePoint(plan->latitude[Navigator.currWP-1],plan->longitude[Navigator.currWP-1],plan->latitude[Navigator.currWP],plan->longitude[Navigator.currWP],Navigator.atd,plan->dist[Navigator.currWP],&latI,&lonI);
+				Navigator.trueCourse=calcGreatCircleCourse(latI,lonI,plan->latitude[Navigator.currWP],plan->longitude[Navigator.currWP]);
 			}
-			updateDtgEteEtaAs(atd,timestamp,Navigator.remainDist);
+			updateDtgEteEtaAs(Navigator.atd,timestamp,Navigator.remainDist);
 		} break;
 		case NAV_STATUS_NAV_TO_SINGLE_WP: {
-			Navigator.bearing=calcGreatCircleRoute(lat,lon,Navigator.dest->latitude,Navigator.dest->longitude,&Navigator.remainDist); //calc just course and distance
-			if(getMainStatus()==MAIN_DISPLAY_HSI) HSIupdateCDI(Rad2Deg(Navigator.bearing),0,false,0);
+			Navigator.bearing=calcGreatCircleRoute(lat,lon,plan->latitude[Navigator.dest],plan->longitude[Navigator.dest],&Navigator.remainDist); //calc just course and distance
 			Navigator.WPreaminDist=Rad2Km(Navigator.remainDist); //Km
+			Navigator.WPaverageSpeed=-1;
 			Navigator.WPremaingTime=Navigator.WPreaminDist/speedKmh; //ETE (remaining time) in hours
-			if(getMainStatus()==MAIN_DISPLAY_HSI) PrintNavRemainingDistWP(Navigator.WPreaminDist,-1,Navigator.WPremaingTime);
-			else Navigator.WPaverageSpeed=-1;
+			Navigator.TotRemainDist=Navigator.WPreaminDist; //the only WP is also the destination
+			Navigator.TotAverageSpeed=-1;
 			Navigator.TotArrivalTime=Navigator.WPremaingTime+timestamp/3600; //hours, in order to obtain the ETA
-			if(getMainStatus()==MAIN_DISPLAY_HSI) PrintNavRemainingDistDST(Navigator.remainDist,-1,Navigator.TotArrivalTime);
-			else Navigator.TotAverageSpeed=-1;
 		} break;
 		case NAV_STATUS_END_NAV: //We have reached or passed the Navigator.destination
-			Navigator.bearing=calcGreatCircleRoute(lat,lon,Navigator.dest->latitude,Navigator.dest->longitude,&Navigator.remainDist); //calc just course and distance
-			if(getMainStatus()==MAIN_DISPLAY_HSI) {
-				PrintNavDTG(Navigator.remainDist);
-				HSIupdateCDI(Rad2Deg(Navigator.bearing),0,false,0);
-			}
+			Navigator.bearing=calcGreatCircleRoute(lat,lon,plan->latitude[Navigator.dest],plan->longitude[Navigator.dest],&Navigator.remainDist); //calc just course and distance
 			break;
 		case NAV_STATUS_WAIT_FIX:
 			NavFindNextWP(lat,lon);
-			NavUpdatePosition(lat,lon,altMt,speedKmh,timestamp);
+			updateNavigation(lat,lon,altMt,speedKmh,timestamp);
 			break;
 		default: //unknown state, we should be never here
 			break;
 	}
 }
 
-void NavRedrawNavInfo(void) { //this is to redraw HSI screen when returning from main menu
-	if(getMainStatus()!=MAIN_DISPLAY_HSI) return;
-	int latMin,lonMin;
-	double latSec,lonSec;
-	pthread_mutex_lock(&gps.mutex);
-	HSIfirstTimeDraw(gps.trueTrack,Rad2Deg(Navigator.trueCourse),Navigator.trackErr,
-			Navigator.status<=NAV_STATUS_NAV_BUSY, //This is when we have only a heading to show and no route planned
-			Navigator.status>=NAV_STATUS_NAV_TO_WPT && Navigator.status<=NAV_STATUS_NAV_TO_DST,
-			Rad2Deg(Navigator.bearing));
-	if(gps.altFt!=-100 && gps.altMt!=-100) {
-		HSIdrawVSIscale(gps.altFt);
-		PrintAltitude(gps.altMt,gps.altFt);
-	}
-	if(gps.latMinDecimal!=-70) {
-		convertDecimal2DegMin(gps.latMinDecimal,&latMin,&latSec);
-		convertDecimal2DegMin(gps.lonMinDecimal,&lonMin,&lonSec);
-		PrintPosition(gps.latDeg,latMin,latSec,gps.isLatN,gps.lonDeg,lonMin,lonSec,gps.isLonE);
-		PrintSpeed(gps.speedKmh,gps.speedKnots);
-	}
-	PrintTime(gps.hour,gps.minute,gps.second,true);
-	PrintNumOfSats(gps.activeSats,gps.satsInView);
-	PrintFixMode(gps.fixMode);
-	pthread_mutex_unlock(&gps.mutex);
+void NavGetData(struct NavData *data) { //copy the data to be shown on the HSI screen
+	struct FlightPlan *plan=&Navigator.plan;
+	memset(data,0,sizeof(struct NavData)); //also the padding, so that two copies can be compared with memcmp
+	pthread_mutex_lock(&Navigator.mutex);
+	data->status=Navigator.status;
 	switch(Navigator.status) {
 		case NAV_STATUS_NOT_INIT:
 		case NAV_STATUS_NO_ROUTE_SET:
-			PrintNavStatus(Navigator.status,"Nowhere");
+		case NAV_STATUS_END_NAV:
+			strcpy(data->WPname,"Nowhere");
 			break;
 		case NAV_STATUS_NAV_BUSY:
-			PrintNavStatus(Navigator.status,"Unknown");
-			break;
-		case NAV_STATUS_TO_START_NAV:
-		case NAV_STATUS_WAIT_FIX:
-		case NAV_STATUS_NAV_TO_DPT:
-			PrintNavStatus(Navigator.status,Navigator.currWP->name);
-			PrintNavRemainingDistWP(Navigator.WPreaminDist,Navigator.WPaverageSpeed,Navigator.WPremaingTime);
-			PrintNavRemainingDistDST(Navigator.TotRemainDist,Navigator.TotAverageSpeed,Navigator.TotArrivalTime);
-			if(Navigator.remainDist!=-1) PrintNavDTG(Navigator.remainDist);
+			strcpy(data->WPname,"Unknown");
 			break;
-		case NAV_STATUS_NAV_TO_WPT:
-		case NAV_STATUS_NAV_TO_DST:
-			PrintNavStatus(Navigator.status,Navigator.currWP->name);
-			PrintNavRemainingDistWP(Navigator.WPreaminDist,Navigator.WPaverageSpeed,Navigator.WPremaingTime);
-			PrintNavRemainingDistDST(Navigator.TotRemainDist,Navigator.TotAverageSpeed,Navigator.TotArrivalTime);
-			if(Navigator.atd!=-1) PrintNavTrackATD(Navigator.atd);
-			break;
-		case NAV_STATUS_NAV_TO_SINGLE_WP:
-			PrintNavStatus(Navigator.status,Navigator.currWP->name);
-			PrintNavRemainingDistWP(Navigator.WPreaminDist,Navigator.WPaverageSpeed,Navigator.WPremaingTime);
-			PrintNavRemainingDistDST(Navigator.TotRemainDist,Navigator.TotAverageSpeed,Navigator.TotArrivalTime);
-			break;
-		case NAV_STATUS_END_NAV:
-			PrintNavStatus(Navigator.status,"Nowhere");
-			if(Navigator.remainDist!=-1) PrintNavDTG(Navigator.remainDist);
-			break;
-		default: //unknown state, we should be never here
+		default:
+			if(Navigator.numWayPoints>0) strncpy(data->WPname,plan->name[Navigator.currWP],MAX_WP_NAME_LENGTH-1);
 			break;
 	}
+	data->trueCourse=Rad2Deg(Navigator.trueCourse);
+	data->bearing=Rad2Deg(Navigator.bearing);
+	data->trackErr=Navigator.trackErr;
+	data->remainDist=Navigator.remainDist;
+	data->atd=Navigator.atd;
+	data->WPremainDist=Navigator.WPreaminDist;
+	data->WPaverageSpeed=Navigator.WPaverageSpeed;
+	data->WPremainTime=Navigator.WPremaingTime;
+	data->TotRemainDist=Navigator.TotRemainDist;
+	data->TotAverageSpeed=Navigator.TotAverageSpeed;
+	data->TotArrivalTime=Navigator.TotArrivalTime;
+	if((Navigator.status==NAV_STATUS_NAV_TO_WPT || Navigator.status==NAV_STATUS_NAV_TO_DST) && Navigator.atd>=0) {
+		data->expectedAltFt=m2Ft((plan->altitude[Navigator.currWP]-plan->altitude[Navigator.currWP-1])/plan->dist[Navigator.currWP]*Navigator.atd+plan->altitude[Navigator.currWP-1]);
+		data->hasExpectedAlt=true;
+	} else data->hasExpectedAlt=false;
+	pthread_mutex_unlock(&Navigator.mutex);
 }
 
 void NavRedrawEphemeridalInfo(void) { //this is to redraw HSI screen when returning from main menu
 	//TODO: draw sunset screen ....
 	if(getMainStatus()!=MAIN_DISPLAY_SUNRISE_SUNSET) return;
 
-	//pthread_mutex_lock(&gps.mutex);
-	// get the data
-	//pthread_mutex_unlock(&gps.mutex);
+	// get the data with GPSgetSnapshot()
 
 	// prepare the screen depending on the navigator status
 	switch(Navigator.status) {
@@ -611,29 +887,33 @@ void NavRedrawEphemeridalInfo(void) { //this is to redraw HSI screen when return
 }
 
 void NavSkipCurrentWayPoint(void) {
+	struct FlightPlan *plan=&Navigator.plan;
+	pthread_mutex_lock(&Navigator.mutex);
 	if(Navigator.status==NAV_STATUS_NAV_TO_WPT || Navigator.status==NAV_STATUS_NAV_TO_DST) {
 		Navigator.status=NAV_STATUS_NAV_BUSY;
 		if(Navigator.currWP==Navigator.dest) {
 			Navigator.status=NAV_STATUS_END_NAV;
+			pthread_mutex_unlock(&Navigator.mutex);
 			return;
 		}
-		pthread_mutex_lock(&gps.mutex);
-		double lat=gps.lat;
-		double lon=gps.lon;
-		float timestamp=gps.timestamp;
-		pthread_mutex_unlock(&gps.mutex);
-		Navigator.currWP->arrTimestamp=timestamp; //we put the arrival timestamp when we skip it
+		struct GPSdata snapshot;
+		GPSgetSnapshot(&snapshot);
+		double lat=snapshot.lat;
+		double lon=snapshot.lon;
+		float timestamp=snapshot.timestamp;
+		plan->arrTimestamp[Navigator.currWP]=timestamp; //we put the arrival timestamp when we skip it
 		double atd;
-		calcGCCrossTrackError(Navigator.currWP->prev->latitude,Navigator.currWP->prev->longitude,Navigator.currWP->longitude,lat,lon,Navigator.currWP->initialCourse,&atd);
+		calcGCCrossTrackErrorTrig(plan->latitude[Navigator.currWP-1],plan->sinLat[Navigator.currWP-1],plan->cosLat[Navigator.currWP-1],plan->longitude[Navigator.currWP-1],plan->longitude[Navigator.currWP],lat,lon,plan->initialCourse[Navigator.currWP],&atd);
 		Navigator.prevWPsTotDist+=Rad2Km(atd); //we add only the ATD
-		Navigator.totalDistKm-=Rad2Km(Navigator.currWP->dist)-Rad2Km(atd); //from the total substract the skipped reamaining dst
-		Navigator.totalDistKm-=Navigator.currWP->next->dist; //from the total substract the dst from skipped wp to the next
-		Navigator.currWP=Navigator.currWP->next; //jump to the next
-		Navigator.currWP->initialCourse=calcGreatCircleRoute(lat,lon,Navigator.currWP->latitude,Navigator.currWP->longitude,&Navigator.currWP->dist); //recalc course
-		Navigator.totalDistKm+=Rad2Km(Navigator.currWP->dist); //we add the new dst form current pos to the next WP
+		Navigator.totalDistKm-=Rad2Km(plan->dist[Navigator.currWP])-Rad2Km(atd); //from the total substract the skipped reamaining dst
+		Navigator.totalDistKm-=plan->dist[Navigator.currWP+1]; //from the total substract the dst from skipped wp to the next
+		Navigator.currWP++; //jump to the next
+		plan->initialCourse[Navigator.currWP]=calcGreatCircleRoute(lat,lon,plan->latitude[Navigator.currWP],plan->longitude[Navigator.currWP],&plan->dist[Navigator.currWP]); //recalc course
+		Navigator.totalDistKm+=Rad2Km(plan->dist[Navigator.currWP]); //we add the new dst form current pos to the next WP
 		if(Navigator.currWP!=Navigator.dest) Navigator.status=NAV_STATUS_NAV_TO_WPT;
 		else Navigator.status=NAV_STATUS_NAV_TO_DST;
 	}
+	pthread_mutex_unlock(&Navigator.mutex);
 }
 
 enum navigatorStatus NavGetStatus(void) {
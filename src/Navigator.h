@@ -6,7 +6,7 @@
 // Copyright   : (C) 2010-2020 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 28/2/2016
+// Last change : 17/10/2026
 // Description : Header of the navigation manager: Navigator.c
 //============================================================================
 
@@ -28,9 +28,43 @@ enum navigatorStatus {
 	NAV_STATUS_END_NAV
 };
 
+enum navLoadStatus {
+	NAV_LOAD_IDLE,    //no flight plan being loaded
+	NAV_LOAD_RUNNING, //the loader thread is reading the flight plan
+	NAV_LOAD_DONE     //the loader thread has finished: NavLoadFlightPlanEnd gives the result
+};
+
+#define NAV_LOAD_CANCELED -7 //returned by NavLoadFlightPlanEnd when the loading has been canceled
+
+#define MAX_WP_NAME_LENGTH 32
+
+struct NavData { //copy of the navigation data shown on the HSI screen
+	enum navigatorStatus status;
+	char WPname[MAX_WP_NAME_LENGTH];                     //name of the waypoint we are going to
+	double trueCourse,bearing;                           //deg
+	double trackErr;                                     //cross track error in m
+	double remainDist,atd;                               //rad
+	double WPremainDist,WPaverageSpeed,WPremainTime;     //Km, Km/h and hours to the current WP
+	double TotRemainDist,TotAverageSpeed,TotArrivalTime; //Km, Km/h and ETA in hours to the destination
+	double expectedAltFt;                                //altitude expected on the leg
+	bool hasExpectedAlt;                                 //true if expectedAltFt is valid
+};
+
+struct NavPlanInfo { //summary of a flight plan not loaded
+	int numWayPoints;
+	double totalDistKm;
+	char departure[MAX_WP_NAME_LENGTH];
+	char destination[MAX_WP_NAME_LENGTH];
+};
+
 int NavLoadFlightPlan(char* GPXfile);
+bool NavLoadFlightPlanStart(const char *GPXfile);
+enum navLoadStatus NavGetLoadStatus(int *progress);
+void NavCancelLoad(void);
+int NavLoadFlightPlanEnd(void);
+bool NavGetPlanInfo(const char *GPXfile, struct NavPlanInfo *info);
 void NavAddWayPoint(double latWP, double lonWP, double altWP, char *WPname);
-void NavRedrawNavInfo(void);
+void NavGetData(struct NavData *data);
 void NavRedrawEphemeridalInfo(void);
 void NavClearRoute(void);
 void NavUpdatePosition(double lat, double lon, double alt, double speed, float timestamp);
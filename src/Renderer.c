@@ -0,0 +1,199 @@
+//============================================================================
+// Name        : Renderer.c
+// Since       : 17/10/2026
+// Author      : Alberto Realis-Luc <alberto.realisluc@gmail.com>
+// Web         : https://www.alus.it/airnavigator/
+// Copyright   : (C) 2010-2026 Alberto Realis-Luc
+// License     : GNU GPL v2
+// Repository  : https://github.com/alus-it/AirNavigator.git
+// Last change : 17/10/2026
+// Description : Render thread of the HSI screen, it draws the frames produced
+//               by the GPS thread at most once per display refresh
+//============================================================================
+
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include "Renderer.h"
+#include "FBrender.h"
+#include "HSI.h"
+#include "AirCalc.h"
+
+
+struct RendererStruct {
+	pthread_t thread;
+	volatile short running;             //-1 means still not initialized
+	pthread_mutex_t mutex;              //protects the queue and the redraw request
+	pthread_cond_t signal;              //signaled when a new frame or a redraw request arrives
+	struct RenderFrame queue[RENDER_QUEUE_SIZE];
+	int head,tail;                      //next slot to be written by the GPS thread and next slot to be read
+	bool redrawRequested;               //the whole HSI screen has to be drawn again
+	bool screenValid;                   //the HSI screen on the display has been completely drawn by the render thread
+	struct RenderFrame last;            //last frame drawn, used to draw only what changed
+	long framePeriodUs;                 //minimum time between two frames in microseconds
+	unsigned long received,drawn;       //number of frames received and really drawn
+};
+
+void buildFrame(struct RenderFrame *frame);
+void drawFrame(const struct RenderFrame *frame, bool full);
+void drawNavInfo(const struct NavData *nav);
+void* renderLoop(void *ptr);
+
+static struct RendererStruct Renderer = {
+	.running=-1,
+	.mutex=PTHREAD_MUTEX_INITIALIZER,
+	.signal=PTHREAD_COND_INITIALIZER,
+	.head=0,
+	.tail=0,
+	.redrawRequested=false,
+	.screenValid=false,
+	.received=0,
+	.drawn=0
+};
+
+bool RendererStart(void) {
+	if(Renderer.running==1) return true;
+	Renderer.framePeriodUs=1000000/FBrenderRefreshRate();
+	Renderer.running=1;
+	if(pthread_create(&Renderer.thread,NULL,renderLoop,(void*)NULL)) {
+		Renderer.running=0;
+		printLog("Renderer: ERROR unable to create the render thread.\n");
+		return false;
+	}
+	return true;
+}
+
+void buildFrame(struct RenderFrame *frame) { //take a copy of GPS and navigation data
+	GPSgetSnapshot(&frame->gps);
+	NavGetData(&frame->nav);
+}
+
+void RendererPush(void) { //called only by the GPS thread: the single producer of frames
+	if(Renderer.running!=1) return;
+	pthread_mutex_lock(&Renderer.mutex);
+	buildFrame(&Renderer.queue[Renderer.head]);
+	Renderer.head=(Renderer.head+1)%RENDER_QUEUE_SIZE;
+	if(Renderer.head==Renderer.tail) Renderer.tail=(Renderer.tail+1)%RENDER_QUEUE_SIZE; //queue full: drop the oldest frame
+	Renderer.received++;
+	pthread_cond_signal(&Renderer.signal);
+	pthread_mutex_unlock(&Renderer.mutex);
+}
+
+void RendererRedraw(void) { //this is to redraw HSI screen when returning from main menu
+	pthread_mutex_lock(&Renderer.mutex);
+	Renderer.redrawRequested=true;
+	pthread_cond_signal(&Renderer.signal);
+	pthread_mutex_unlock(&Renderer.mutex);
+}
+
+void RendererClose(void) {
+	if(Renderer.running!=1) return;
+	pthread_mutex_lock(&Renderer.mutex);
+	Renderer.running=0;
+	pthread_cond_signal(&Renderer.signal);
+	pthread_mutex_unlock(&Renderer.mutex);
+	pthread_join(Renderer.thread,NULL); //wait for thread death
+	printLog("Renderer: %lu frames received, %lu drawn.\n",Renderer.received,Renderer.drawn);
+}
+
+void* renderLoop(void *ptr) { //render function, it will be ran in a separate thread
+	static struct RenderFrame frame;
+	struct timeval lastFrameTime;
+	bool haveFrame, redraw;
+	gettimeofday(&lastFrameTime,NULL);
+	while(Renderer.running) {
+		pthread_mutex_lock(&Renderer.mutex);
+		while(Renderer.running && Renderer.head==Renderer.tail && !Renderer.redrawRequested)
+			pthread_cond_wait(&Renderer.signal,&Renderer.mutex);
+		haveFrame=(Renderer.head!=Renderer.tail);
+		if(haveFrame) { //take just the newest frame: the older ones are already outdated
+			frame=Renderer.queue[(Renderer.head+RENDER_QUEUE_SIZE-1)%RENDER_QUEUE_SIZE];
+			Renderer.tail=Renderer.head;
+		}
+		redraw=Renderer.redrawRequested;
+		Renderer.redrawRequested=false;
+		pthread_mutex_unlock(&Renderer.mutex);
+		if(!Renderer.running) break;
+		if(getMainStatus()!=MAIN_DISPLAY_HSI) { //the HSI is not shown: nothing to draw
+			Renderer.screenValid=false;
+			continue;
+		}
+		if(redraw || !Renderer.screenValid) buildFrame(&frame); //fresh data also for the navigation
+		FBrenderLock();
+		if(getMainStatus()==MAIN_DISPLAY_HSI) { //check again: the main thread could have changed screen meanwhile
+			drawFrame(&frame,redraw || !Renderer.screenValid);
+			Renderer.screenValid=true;
+			FBrenderFlush();
+			Renderer.drawn++;
+		} else Renderer.screenValid=false;
+		FBrenderUnlock();
+		long long waitUs=Renderer.framePeriodUs-elapsedUs(&lastFrameTime);
+		if(waitUs>0 && waitUs<=Renderer.framePeriodUs) usleep(waitUs); //frames arriving meanwhile will be coalesced
+		gettimeofday(&lastFrameTime,NULL);
+	}
+	pthread_exit(NULL);
+	return NULL;
+}
+
+void drawFrame(const struct RenderFrame *frame, bool full) { //draw all or only what changed from the last frame
+	const struct GPSdata *curr=&frame->gps, *prev=&Renderer.last.gps;
+	const struct NavData *nav=&frame->nav;
+	if(full) HSIfirstTimeDraw(curr->trueTrack,nav->trueCourse,nav->trackErr,
+			nav->status<=NAV_STATUS_NAV_BUSY, //This is when we have only a heading to show and no route planned
+			nav->status>=NAV_STATUS_NAV_TO_WPT && nav->status<=NAV_STATUS_NAV_TO_DST,
+			nav->bearing);
+	else if(curr->trueTrack!=prev->trueTrack) HSIupdateDir(curr->trueTrack);
+	if(curr->altFt!=-100 && (full || curr->realAltFt!=prev->realAltFt)) {
+		HSIdrawVSIscale(curr->realAltFt);
+		PrintAltitude(curr->realAltMt,curr->realAltFt);
+	}
+	if(curr->latMinDecimal!=-70 && (full || curr->latMinDecimal!=prev->latMinDecimal || curr->lonMinDecimal!=prev->lonMinDecimal)) {
+		int latMin,lonMin;
+		double latSec,lonSec;
+		convertDecimal2DegMin(curr->latMinDecimal,&latMin,&latSec);
+		convertDecimal2DegMin(curr->lonMinDecimal,&lonMin,&lonSec);
+		PrintPosition(curr->latDeg,latMin,latSec,curr->isLatN,curr->lonDeg,lonMin,lonSec,curr->isLonE);
+	}
+	if(curr->speedKnots!=-100 && (full || curr->speedKnots!=prev->speedKnots)) PrintSpeed(curr->speedKmh,curr->speedKnots);
+	if(full || curr->timestamp!=prev->timestamp || curr->fixMode!=prev->fixMode) PrintTime(curr->hour,curr->minute,curr->second,curr->fixMode<=MODE_NO_FIX);
+	if(full || curr->activeSats!=prev->activeSats || curr->satsInView!=prev->satsInView) PrintNumOfSats(curr->activeSats,curr->satsInView);
+	if(full || curr->fixMode!=prev->fixMode) PrintFixMode(curr->fixMode);
+	if(full || memcmp(nav,&Renderer.last.nav,sizeof(struct NavData))!=0) drawNavInfo(nav);
+	Renderer.last=*frame;
+}
+
+void drawNavInfo(const struct NavData *nav) {
+	PrintNavStatus(nav->status,nav->WPname);
+	switch(nav->status) {
+		case NAV_STATUS_TO_START_NAV:
+		case NAV_STATUS_WAIT_FIX:
+		case NAV_STATUS_NAV_TO_DPT:
+			PrintNavRemainingDistWP(nav->WPremainDist,nav->WPaverageSpeed,nav->WPremainTime);
+			PrintNavRemainingDistDST(nav->TotRemainDist,nav->TotAverageSpeed,nav->TotArrivalTime);
+			if(nav->remainDist!=-1) PrintNavDTG(nav->remainDist);
+			if(nav->status!=NAV_STATUS_WAIT_FIX) HSIupdateCDI(nav->bearing,0,false,0);
+			break;
+		case NAV_STATUS_NAV_TO_WPT:
+		case NAV_STATUS_NAV_TO_DST:
+			PrintNavRemainingDistWP(nav->WPremainDist,nav->WPaverageSpeed,nav->WPremainTime);
+			PrintNavRemainingDistDST(nav->TotRemainDist,nav->TotAverageSpeed,nav->TotArrivalTime);
+			if(nav->atd!=-1) PrintNavTrackATD(nav->atd);
+			HSIupdateCDI(nav->trueCourse,nav->trackErr,true,nav->bearing);
+			if(nav->hasExpectedAlt) HSIupdateVSI(nav->expectedAltFt);
+			break;
+		case NAV_STATUS_NAV_TO_SINGLE_WP:
+			PrintNavRemainingDistWP(nav->WPremainDist,nav->WPaverageSpeed,nav->WPremainTime);
+			PrintNavRemainingDistDST(nav->TotRemainDist,nav->TotAverageSpeed,nav->TotArrivalTime);
+			HSIupdateCDI(nav->bearing,0,false,0);
+			break;
+		case NAV_STATUS_END_NAV:
+			if(nav->remainDist!=-1) PrintNavDTG(nav->remainDist);
+			HSIupdateCDI(nav->bearing,0,false,0);
+			break;
+		default: //nothing else to show
+			break;
+	}
+}
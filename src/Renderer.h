@@ -0,0 +1,32 @@
+//============================================================================
+// Name        : Renderer.h
+// Since       : 17/10/2026
+// Author      : Alberto Realis-Luc <alberto.realisluc@gmail.com>
+// Web         : https://www.alus.it/airnavigator/
+// Copyright   : (C) 2010-2026 Alberto Realis-Luc
+// License     : GNU GPL v2
+// Repository  : https://github.com/alus-it/AirNavigator.git
+// Last change : 17/10/2026
+// Description : Header of the HSI screen render thread: Renderer.c
+//============================================================================
+
+#ifndef RENDERER_H_
+#define RENDERER_H_
+
+#include "Common.h"
+#include "GPSreceiver.h"
+#include "Navigator.h"
+
+#define RENDER_QUEUE_SIZE 8 //number of frames that can wait to be drawn, older ones are dropped
+
+struct RenderFrame { //what is needed to draw the HSI screen, copied from the GPS thread
+	struct GPSdata gps;
+	struct NavData nav;
+};
+
+bool RendererStart(void);
+void RendererPush(void);
+void RendererRedraw(void);
+void RendererClose(void);
+
+#endif /* RENDERER_H_ */
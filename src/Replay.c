@@ -0,0 +1,139 @@
+//============================================================================
+// Name        : Replay.c
+// Since       : 17/10/2026
+// Author      : Alberto Realis-Luc <alberto.realisluc@gmail.com>
+// Web         : https://www.alus.it/airnavigator/
+// Copyright   : (C) 2010-2026 Alberto Realis-Luc
+// License     : GNU GPL v2
+// Repository  : https://github.com/alus-it/AirNavigator.git
+// Last change : 17/10/2026
+// Description : Replays a GPS byte stream recorded in a file through the same
+//               parsing path of the GPS device, paced on the GPS time
+//============================================================================
+
+
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "Replay.h"
+#include "GPSreceiver.h"
+#include "GPSdemux.h"
+
+#define REPLAY_READ_SIZE 512 //bytes given at once to the demultiplexer, as read from a serial port: frames are split between reads
+
+struct ReplayStruct {
+	unsigned char *data;               //the whole file mapped in memory, read only
+	size_t size;
+	double speed;                      //1 is real time, N is N times faster, 0 is as fast as possible
+	float firstTimestamp;              //GPS time when the pacing started, -1 if still not received
+	float lastTimestamp;               //last GPS time seen
+	struct timeval paceStart;          //when the pacing started
+	unsigned long reads;               //chunks given to the demultiplexer
+	long long parseUs, maxReadUs;      //total time spent in the demultiplexer and time of the slowest chunk
+	struct GPSdemuxStats before;       //frame counters when the replay started
+	struct GPSreceiverTiming timingBefore;
+};
+
+void waitForGPStime(void);
+void printStats(long long totalUs, size_t bytes);
+
+static struct ReplayStruct Replay = {
+	.data=NULL,
+	.size=0
+};
+
+bool ReplayRun(const char *fileName, double speed, volatile short *running) { //to be called by the GPS thread instead of reading the device
+	int fd=open(fileName,O_RDONLY);
+	if(fd<0) {
+		printLog("Replay: ERROR unable to open: %s\n",fileName);
+		return false;
+	}
+	struct stat st;
+	if(fstat(fd,&st)!=0 || st.st_size==0) {
+		printLog("Replay: ERROR empty or unreadable file: %s\n",fileName);
+		close(fd);
+		return false;
+	}
+	Replay.size=st.st_size;
+	Replay.data=mmap(NULL,Replay.size,PROT_READ,MAP_PRIVATE,fd,0);
+	close(fd); //the mapping remains valid
+	if(Replay.data==MAP_FAILED) {
+		printLog("Replay: ERROR unable to map in memory: %s\n",fileName);
+		Replay.data=NULL;
+		return false;
+	}
+	madvise(Replay.data,Replay.size,MADV_SEQUENTIAL);
+	Replay.speed=speed;
+	Replay.firstTimestamp=-1;
+	Replay.lastTimestamp=-1;
+	Replay.reads=0;
+	Replay.parseUs=0;
+	Replay.maxReadUs=0;
+	GPSdemuxGetStats(&Replay.before);
+	GPSreceiverGetTiming(&Replay.timingBefore);
+	GPSreceiverEnableTiming(true);
+	if(speed>REPLAY_FASTEST) printLog("Replay: replaying %s at %.1fx\n",fileName,speed);
+	else printLog("Replay: replaying %s as fast as possible\n",fileName);
+	struct timeval start, readStart;
+	gettimeofday(&start,NULL);
+	size_t pos=0;
+	while(pos<Replay.size && *running) {
+		size_t len=Replay.size-pos;
+		if(len>REPLAY_READ_SIZE) len=REPLAY_READ_SIZE;
+		gettimeofday(&readStart,NULL);
+		GPSdemuxProcessBuffer(Replay.data+pos,len); //directly from the mapped file: no copies, NMEA, SiRF or UBX as from the device
+		long long readUs=elapsedUs(&readStart);
+		Replay.parseUs+=readUs;
+		if(readUs>Replay.maxReadUs) Replay.maxReadUs=readUs;
+		Replay.reads++;
+		pos+=len;
+		if(Replay.speed>REPLAY_FASTEST) waitForGPStime();
+	}
+	long long totalUs=elapsedUs(&start);
+	GPSreceiverEnableTiming(false);
+	munmap(Replay.data,Replay.size);
+	Replay.data=NULL;
+	printStats(totalUs,pos);
+	return true;
+}
+
+void waitForGPStime(void) { //sleep until the time passed is the GPS time of the data parsed divided by the speed
+	if(gps.timestamp<0) return; //still no time received
+	float gpsElapsed=gps.timestamp-Replay.lastTimestamp;
+	if(gpsElapsed<0) gpsElapsed+=86400; //passed midnight
+	if(Replay.firstTimestamp<0 || gpsElapsed>REPLAY_MAX_GAP) { //start or restart the pacing from here
+		Replay.firstTimestamp=gps.timestamp;
+		Replay.lastTimestamp=gps.timestamp;
+		gettimeofday(&Replay.paceStart,NULL);
+		return;
+	}
+	Replay.lastTimestamp=gps.timestamp;
+	gpsElapsed=gps.timestamp-Replay.firstTimestamp;
+	if(gpsElapsed<0) gpsElapsed+=86400;
+	long long waitUs=(long long)(gpsElapsed*1000000/Replay.speed)-elapsedUs(&Replay.paceStart);
+	if(waitUs>0) usleep(waitUs);
+}
+
+void printStats(long long totalUs, size_t bytes) {
+	struct GPSdemuxStats now;
+	struct GPSreceiverTiming timing;
+	int i;
+	GPSdemuxGetStats(&now);
+	GPSreceiverGetTiming(&timing);
+	unsigned long fixes=timing.fixes-Replay.timingBefore.fixes;
+	unsigned long publications=timing.publications-Replay.timingBefore.publications;
+	long long navUs=timing.navUs-Replay.timingBefore.navUs, publishUs=timing.publishUs-Replay.timingBefore.publishUs;
+	double secs=(totalUs>0)?totalUs/1000000.0:0.000001;
+	printLog("Replay: %lu bytes in %lu reads replayed in %.3f s\n",(unsigned long)bytes,Replay.reads,secs);
+	for(i=0;i<GPS_PROTOCOLS;i++) {
+		unsigned long frames=now.protocol[i].frames-Replay.before.protocol[i].frames;
+		unsigned long errors=now.protocol[i].errors-Replay.before.protocol[i].errors;
+		if(frames>0 || errors>0) printLog("Replay: %lu %s frames (%.1f/s), %lu discarded\n",frames,GPSdemuxProtocolName(i),frames/secs,errors);
+	}
+	printLog("Replay: %lu fixes (%.1f/s)\n",fixes,fixes/secs);
+	printLog("Replay: latency: parsing %.1f us per read (slowest read %lld us), navigation %.1f us per fix, publishing %.1f us per publication\n",
+			(double)(Replay.parseUs-navUs-publishUs)/(Replay.reads>0?Replay.reads:1),Replay.maxReadUs,
+			(double)navUs/(fixes>0?fixes:1),(double)publishUs/(publications>0?publications:1));
+}
@@ -0,0 +1,24 @@
+//============================================================================
+// Name        : Replay.h
+// Since       : 17/10/2026
+// Author      : Alberto Realis-Luc <alberto.realisluc@gmail.com>
+// Web         : https://www.alus.it/airnavigator/
+// Copyright   : (C) 2010-2026 Alberto Realis-Luc
+// License     : GNU GPL v2
+// Repository  : https://github.com/alus-it/AirNavigator.git
+// Last change : 17/10/2026
+// Description : Header of the replay of recorded GPS data: Replay.c
+//============================================================================
+
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include "Common.h"
+
+#define REPLAY_FASTEST  0  //replay speed: as fast as possible
+#define REPLAY_REALTIME 1  //replay speed: same pace of the recording
+#define REPLAY_MAX_GAP  10 //sec, longer gaps in the GPS time of the recording are not waited
+
+bool ReplayRun(const char *fileName, double speed, volatile short *running);
+
+#endif /* REPLAY_H_ */
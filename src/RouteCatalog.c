@@ -0,0 +1,403 @@
+//============================================================================
+// Name        : RouteCatalog.c
+// Since       : 17/10/2026
+// Author      : Alberto Realis-Luc <alberto.realisluc@gmail.com>
+// Web         : https://www.alus.it/airnavigator/
+// Copyright   : (C) 2010-2026 Alberto Realis-Luc
+// License     : GNU GPL v2
+// Repository  : https://github.com/alus-it/AirNavigator.git
+// Last change : 17/10/2026
+// Description : Sorted catalog of the GPX flight plans of the routes directory
+//============================================================================
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include "RouteCatalog.h"
+
+// The directory is scanned once: the GPX files are kept in one array sorted by name,
+// so any of them can be reached by its index. Then only the changes notified by the
+// kernel are applied. Without inotify the directory is scanned again when its
+// modification time changes. The info of a flight plan is read only when asked and
+// kept until the file changes: it is read by a worker thread, because without its
+// cache the whole GPX has to be parsed, and it is taken at the next refresh.
+
+#if defined(__NR_inotify_init) && defined(__NR_inotify_add_watch)
+#define CATALOG_INOTIFY //glibc 2.3 has no wrappers for inotify: its system calls are used directly
+#define CATALOG_IN_ATTRIB      0x00000004
+#define CATALOG_IN_CLOSE_WRITE 0x00000008
+#define CATALOG_IN_MOVED_FROM  0x00000040
+#define CATALOG_IN_MOVED_TO    0x00000080
+#define CATALOG_IN_CREATE      0x00000100
+#define CATALOG_IN_DELETE      0x00000200
+#define CATALOG_IN_DELETE_SELF 0x00000400
+#define CATALOG_IN_MOVE_SELF   0x00000800
+#define CATALOG_IN_Q_OVERFLOW  0x00004000
+#define CATALOG_IN_IGNORED     0x00008000
+
+struct catalogEvent { //as struct inotify_event, followed by the name
+	int wd;
+	unsigned int mask;
+	unsigned int cookie;
+	unsigned int len;
+};
+#endif
+
+#define CATALOG_MIN_SIZE      16   //routes allocated at the first one found
+#define CATALOG_EVENTS_BUFFER 1024 //bytes of the events read at once
+
+enum catalogInfoStatus {
+	CATALOG_INFO_IDLE,
+	CATALOG_INFO_RUNNING, //the worker is reading the info of a flight plan
+	CATALOG_INFO_DONE     //the info has to be taken and the worker joined
+};
+
+struct RouteCatalogStruct {
+	char *dirPath;
+	struct RouteInfo *routes; //sorted by file name
+	int num, size;            //routes in the catalog and allocated
+	int notifyFd;             //-1 when the changes are not notified by the kernel
+	long dirMtime;            //of the directory at the last scan
+	int *selected;            //index kept on the same route while the catalog changes, NULL if none
+	pthread_t infoThread;
+	volatile enum catalogInfoStatus infoStatus;
+	char *infoFile;           //name of the file whose info is being read
+	char *infoPath;
+	long infoSize, infoMtime; //of the file when its info started to be read
+	bool infoValid;
+	struct NavPlanInfo info;  //written by the worker
+};
+
+bool isGPXfile(const char *fileName);
+int compareNames(const char *a, const char *b);
+int compareRoutes(const void *a, const void *b);
+int findRoute(const char *fileName, bool *found);
+bool statRoute(const char *fileName, struct stat *st);
+bool insertRoute(const int index, const char *fileName, const struct stat *st);
+void removeRoute(const int index);
+bool updateRoute(const char *fileName);
+bool scanDirectory(void);
+#ifdef CATALOG_INOTIFY
+bool readEvents(void);
+#endif
+void* infoLoop(void *ptr);
+bool startInfo(const int index);
+bool takeInfo(void);
+
+static struct RouteCatalogStruct RouteCatalog = {
+	.dirPath=NULL,
+	.routes=NULL,
+	.num=0,
+	.size=0,
+	.notifyFd=-1,
+	.dirMtime=0,
+	.selected=NULL,
+	.infoStatus=CATALOG_INFO_IDLE,
+	.infoFile=NULL,
+	.infoPath=NULL
+};
+
+bool isGPXfile(const char *fileName) {
+	int len=strlen(fileName);
+	return len>3 && strcasecmp(fileName+len-3,"gpx")==0;
+}
+
+int compareNames(const char *a, const char *b) { //case insensitive, case only to tell apart names otherwise equal
+	int cmp=strcasecmp(a,b);
+	return cmp!=0?cmp:strcmp(a,b);
+}
+
+int compareRoutes(const void *a, const void *b) {
+	return compareNames(((const struct RouteInfo*)a)->fileName,((const struct RouteInfo*)b)->fileName);
+}
+
+int findRoute(const char *fileName, bool *found) { //binary search: index of the route or where it has to be inserted
+	int lo=0, hi=RouteCatalog.num, mid, cmp;
+	*found=false;
+	while(lo<hi) {
+		mid=(lo+hi)/2;
+		cmp=compareNames(RouteCatalog.routes[mid].fileName,fileName);
+		if(cmp==0) {
+			*found=true;
+			return mid;
+		}
+		if(cmp<0) lo=mid+1;
+		else hi=mid;
+	}
+	return lo;
+}
+
+bool statRoute(const char *fileName, struct stat *st) { //true if it is a regular file in the directory
+	char *path;
+	bool exists;
+	if(asprintf(&path,"%s/%s",RouteCatalog.dirPath,fileName)<0) return false;
+	exists=stat(path,st)==0 && S_ISREG(st->st_mode);
+	free(path);
+	return exists;
+}
+
+bool insertRoute(const int index, const char *fileName, const struct stat *st) {
+	if(RouteCatalog.num==RouteCatalog.size) { //array full: move the catalog in a bigger one
+		int size=RouteCatalog.size<CATALOG_MIN_SIZE?CATALOG_MIN_SIZE:2*RouteCatalog.size;
+		struct RouteInfo *routes=(struct RouteInfo*)realloc(RouteCatalog.routes,size*sizeof(struct RouteInfo));
+		if(routes==NULL) {
+			printLog("RouteCatalog: ERROR not enough memory for %d routes.\n",size);
+			return false;
+		}
+		RouteCatalog.routes=routes;
+		RouteCatalog.size=size;
+	}
+	struct RouteInfo *route=&RouteCatalog.routes[index];
+	memmove(route+1,route,(RouteCatalog.num-index)*sizeof(struct RouteInfo));
+	memset(route,0,sizeof(struct RouteInfo));
+	route->fileName=strdup(fileName);
+	route->size=st->st_size;
+	route->mtime=st->st_mtime;
+	if(RouteCatalog.selected!=NULL && RouteCatalog.num>0 && index<=*RouteCatalog.selected) (*RouteCatalog.selected)++;
+	RouteCatalog.num++;
+	return true;
+}
+
+void removeRoute(const int index) {
+	free(RouteCatalog.routes[index].fileName);
+	RouteCatalog.num--;
+	memmove(&RouteCatalog.routes[index],&RouteCatalog.routes[index+1],(RouteCatalog.num-index)*sizeof(struct RouteInfo));
+	if(RouteCatalog.selected!=NULL) { //if the selected one is removed the next one takes its place
+		if(index<*RouteCatalog.selected) (*RouteCatalog.selected)--;
+		if(*RouteCatalog.selected>=RouteCatalog.num) *RouteCatalog.selected=RouteCatalog.num>0?RouteCatalog.num-1:0;
+	}
+}
+
+bool updateRoute(const char *fileName) { //apply a change of the file, returns true if the catalog changed
+	struct stat st;
+	bool found;
+	int index=findRoute(fileName,&found);
+	if(!statRoute(fileName,&st)) { //the file is gone
+		if(!found) return false;
+		removeRoute(index);
+		return true;
+	}
+	if(!found) return insertRoute(index,fileName,&st);
+	struct RouteInfo *route=&RouteCatalog.routes[index];
+	if(route->size==(long)st.st_size && route->mtime==(long)st.st_mtime) return false;
+	route->size=st.st_size;
+	route->mtime=st.st_mtime;
+	route->infoRead=false; //to be read again
+	return true;
+}
+
+bool scanDirectory(void) { //scan the whole directory keeping the info of the files not changed
+	struct RouteInfo *oldRoutes=RouteCatalog.routes;
+	int i, oldNum=RouteCatalog.num, oldIndex, *selected=RouteCatalog.selected;
+	struct dirent *entry;
+	struct stat st;
+	bool found;
+	DIR *dir=opendir(RouteCatalog.dirPath);
+	if(dir==NULL) {
+		printLog("RouteCatalog: ERROR could not open the directory: %s\n",RouteCatalog.dirPath);
+		return false;
+	}
+	if(stat(RouteCatalog.dirPath,&st)==0) RouteCatalog.dirMtime=st.st_mtime;
+	RouteCatalog.routes=NULL;
+	RouteCatalog.num=0;
+	RouteCatalog.size=0;
+	RouteCatalog.selected=NULL; //found again by name at the end
+	while((entry=readdir(dir))!=NULL) if(isGPXfile(entry->d_name) && statRoute(entry->d_name,&st)) {
+		if(!insertRoute(RouteCatalog.num,entry->d_name,&st)) break; //appended, sorted later
+	}
+	closedir(dir);
+	if(RouteCatalog.num>1) qsort(RouteCatalog.routes,RouteCatalog.num,sizeof(struct RouteInfo),compareRoutes);
+	RouteCatalog.selected=selected;
+	if(selected!=NULL) {
+		if(*selected>=0 && *selected<oldNum) *selected=findRoute(oldRoutes[*selected].fileName,&found); //if it is gone the next one
+		if(*selected>=RouteCatalog.num) *selected=RouteCatalog.num>0?RouteCatalog.num-1:0;
+	}
+	for(i=0;i<oldNum;i++) { //the info still valid is kept
+		struct RouteInfo *oldRoute=&oldRoutes[i];
+		if(oldRoute->infoRead) {
+			oldIndex=findRoute(oldRoute->fileName,&found);
+			if(found && RouteCatalog.routes[oldIndex].size==oldRoute->size && RouteCatalog.routes[oldIndex].mtime==oldRoute->mtime) {
+				RouteCatalog.routes[oldIndex].infoRead=true;
+				RouteCatalog.routes[oldIndex].infoValid=oldRoute->infoValid;
+				RouteCatalog.routes[oldIndex].info=oldRoute->info;
+			}
+		}
+		free(oldRoute->fileName);
+	}
+	free(oldRoutes);
+	return true;
+}
+
+#ifdef CATALOG_INOTIFY
+bool readEvents(void) { //apply the changes notified, returns true if the catalog changed
+	char buffer[CATALOG_EVENTS_BUFFER];
+	struct catalogEvent event;
+	bool changed=false, rescan=false;
+	int len, pos;
+	while((len=read(RouteCatalog.notifyFd,buffer,CATALOG_EVENTS_BUFFER))>0) {
+		for(pos=0;pos+(int)sizeof(struct catalogEvent)<=len;pos+=sizeof(struct catalogEvent)+event.len) {
+			memcpy(&event,buffer+pos,sizeof(struct catalogEvent));
+			if(event.mask&CATALOG_IN_Q_OVERFLOW) rescan=true; //some events are lost
+			else if(event.mask&(CATALOG_IN_DELETE_SELF|CATALOG_IN_MOVE_SELF|CATALOG_IN_IGNORED)) { //the directory is not watched any more
+				close(RouteCatalog.notifyFd);
+				RouteCatalog.notifyFd=-1;
+				rescan=true;
+				break;
+			} else if(event.len>0 && pos+(int)sizeof(struct catalogEvent)+(int)event.len<=len) {
+				const char *fileName=buffer+pos+sizeof(struct catalogEvent);
+				if(isGPXfile(fileName) && updateRoute(fileName)) changed=true;
+			}
+		}
+		if(RouteCatalog.notifyFd<0) break;
+	}
+	if(rescan && scanDirectory()) changed=true;
+	return changed;
+}
+#endif
+
+bool RouteCatalogOpen(const char *dirPath) {
+	if(dirPath==NULL) return false;
+	RouteCatalogClose();
+	RouteCatalog.dirPath=strdup(dirPath);
+#ifdef CATALOG_INOTIFY
+	RouteCatalog.notifyFd=syscall(__NR_inotify_init); //watch the directory before scanning it: no change can be missed
+	if(RouteCatalog.notifyFd>=0) {
+		unsigned int mask=CATALOG_IN_CREATE|CATALOG_IN_DELETE|CATALOG_IN_MOVED_FROM|CATALOG_IN_MOVED_TO|CATALOG_IN_CLOSE_WRITE|CATALOG_IN_ATTRIB|CATALOG_IN_DELETE_SELF|CATALOG_IN_MOVE_SELF;
+		if(fcntl(RouteCatalog.notifyFd,F_SETFL,O_NONBLOCK)!=0 || syscall(__NR_inotify_add_watch,RouteCatalog.notifyFd,RouteCatalog.dirPath,mask)<0) {
+			close(RouteCatalog.notifyFd);
+			RouteCatalog.notifyFd=-1;
+		}
+	}
+#endif
+	if(RouteCatalog.notifyFd<0) printLog("RouteCatalog: changes not notified, the directory will be checked at each refresh.\n");
+	return scanDirectory();
+}
+
+bool RouteCatalogRefresh(int *selected) { //apply the changes of the directory keeping selected on the same route, returns true if the catalog changed
+	struct stat st;
+	bool changed=false;
+	if(RouteCatalog.dirPath==NULL) return false;
+	RouteCatalog.selected=selected;
+	if(takeInfo()) changed=true;
+#ifdef CATALOG_INOTIFY
+	if(RouteCatalog.notifyFd>=0) {
+		if(readEvents()) changed=true;
+	} else
+#endif
+	if(stat(RouteCatalog.dirPath,&st)==0 && (long)st.st_mtime!=RouteCatalog.dirMtime && scanDirectory()) changed=true;
+	RouteCatalog.selected=NULL;
+	return changed;
+}
+
+int RouteCatalogCount(void) {
+	return RouteCatalog.num;
+}
+
+const struct RouteInfo* RouteCatalogGet(const int index, const bool readInfo) { //readInfo to read the info of the flight plan if not yet done
+	if(index<0 || index>=RouteCatalog.num) return NULL;
+	struct RouteInfo *route=&RouteCatalog.routes[index];
+	if(readInfo && !route->infoRead && RouteCatalog.infoStatus==CATALOG_INFO_IDLE) startInfo(index);
+	return route;
+}
+
+bool RouteCatalogInfoPending(void) { //true while the worker reads the info of a flight plan
+	return RouteCatalog.infoStatus!=CATALOG_INFO_IDLE;
+}
+
+int RouteCatalogFind(const char *fileName) { //index of the file or -1 if not in the catalog
+	bool found;
+	int index;
+	if(fileName==NULL) return -1;
+	index=findRoute(fileName,&found);
+	return found?index:-1;
+}
+
+char* RouteCatalogPath(const int index) { //full path of the file, to be freed
+	char *path;
+	if(index<0 || index>=RouteCatalog.num) return NULL;
+	if(asprintf(&path,"%s/%s",RouteCatalog.dirPath,RouteCatalog.routes[index].fileName)<0) return NULL;
+	return path;
+}
+
+void RouteCatalogClose(void) {
+	int i;
+	if(RouteCatalog.infoStatus!=CATALOG_INFO_IDLE) { //the worker can't be stopped: wait for it
+		pthread_join(RouteCatalog.infoThread,NULL);
+		RouteCatalog.infoStatus=CATALOG_INFO_DONE;
+	}
+	takeInfo();
+	for(i=0;i<RouteCatalog.num;i++) free(RouteCatalog.routes[i].fileName);
+	free(RouteCatalog.routes);
+	RouteCatalog.routes=NULL;
+	RouteCatalog.num=0;
+	RouteCatalog.size=0;
+	free(RouteCatalog.dirPath);
+	RouteCatalog.dirPath=NULL;
+	if(RouteCatalog.notifyFd>=0) close(RouteCatalog.notifyFd);
+	RouteCatalog.notifyFd=-1;
+}
+
+void* infoLoop(void *ptr) { //reads the info of a flight plan, it will be ran in a separate thread
+	RouteCatalog.infoValid=NavGetPlanInfo(RouteCatalog.infoPath,&RouteCatalog.info);
+	MEMORY_BARRIER();
+	RouteCatalog.infoStatus=CATALOG_INFO_DONE;
+	pthread_exit(NULL);
+	return NULL;
+}
+
+bool startInfo(const int index) { //read the info of the route in background
+	struct RouteInfo *route=&RouteCatalog.routes[index];
+	RouteCatalog.infoPath=RouteCatalogPath(index);
+	RouteCatalog.infoFile=strdup(route->fileName);
+	if(RouteCatalog.infoPath==NULL || RouteCatalog.infoFile==NULL) {
+		free(RouteCatalog.infoPath);
+		free(RouteCatalog.infoFile);
+		RouteCatalog.infoPath=RouteCatalog.infoFile=NULL;
+		return false;
+	}
+	RouteCatalog.infoSize=route->size;
+	RouteCatalog.infoMtime=route->mtime;
+	RouteCatalog.infoStatus=CATALOG_INFO_RUNNING;
+	if(pthread_create(&RouteCatalog.infoThread,NULL,infoLoop,(void*)NULL)) {
+		printLog("RouteCatalog: ERROR unable to start the thread to read the flight plan info.\n");
+		RouteCatalog.infoStatus=CATALOG_INFO_IDLE;
+		free(RouteCatalog.infoPath);
+		free(RouteCatalog.infoFile);
+		RouteCatalog.infoPath=RouteCatalog.infoFile=NULL;
+		route->infoValid=false; //not to try again at each redraw
+		route->infoRead=true;
+		return false;
+	}
+	return true;
+}
+
+bool takeInfo(void) { //give the info read by the worker to its route, true if it has been given
+	bool found=false;
+	int index=0;
+	if(RouteCatalog.infoStatus!=CATALOG_INFO_DONE) return false;
+	pthread_join(RouteCatalog.infoThread,NULL);
+	if(RouteCatalog.dirPath!=NULL) index=findRoute(RouteCatalog.infoFile,&found); //the catalog can be changed meanwhile
+	if(found) {
+		struct RouteInfo *route=&RouteCatalog.routes[index];
+		found=(route->size==RouteCatalog.infoSize && route->mtime==RouteCatalog.infoMtime); //else the file changed: its info will be read again
+		if(found) {
+			route->info=RouteCatalog.info;
+			route->infoValid=RouteCatalog.infoValid;
+			route->infoRead=true;
+		}
+	}
+	free(RouteCatalog.infoPath);
+	free(RouteCatalog.infoFile);
+	RouteCatalog.infoPath=RouteCatalog.infoFile=NULL;
+	RouteCatalog.infoStatus=CATALOG_INFO_IDLE;
+	return found;
+}
@@ -0,0 +1,38 @@
+//============================================================================
+// Name        : RouteCatalog.h
+// Since       : 17/10/2026
+// Author      : Alberto Realis-Luc <alberto.realisluc@gmail.com>
+// Web         : https://www.alus.it/airnavigator/
+// Copyright   : (C) 2010-2026 Alberto Realis-Luc
+// License     : GNU GPL v2
+// Repository  : https://github.com/alus-it/AirNavigator.git
+// Last change : 17/10/2026
+// Description : Header of the catalog of the GPX flight plans: RouteCatalog.c
+//============================================================================
+
+#ifndef ROUTECATALOG_H_
+#define ROUTECATALOG_H_
+
+#include "Common.h"
+#include "Navigator.h"
+
+#define ROUTE_CATALOG_PAGE_ROWS 7 //flight plans shown in each page of the select route screen
+
+struct RouteInfo {
+	char *fileName;          //name of the GPX file in the directory
+	long size, mtime;        //of the file when its info has been read
+	bool infoRead;           //true once info has been read, false again when the file changes
+	bool infoValid;          //false if the file has no valid flight plan
+	struct NavPlanInfo info;
+};
+
+bool RouteCatalogOpen(const char *dirPath);
+bool RouteCatalogRefresh(int *selected);
+int RouteCatalogCount(void);
+const struct RouteInfo* RouteCatalogGet(const int index, const bool readInfo);
+bool RouteCatalogInfoPending(void);
+int RouteCatalogFind(const char *fileName);
+char* RouteCatalogPath(const int index);
+void RouteCatalogClose(void);
+
+#endif /* ROUTECATALOG_H_ */
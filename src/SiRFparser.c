@@ -3,220 +3,293 @@
 // Since       : 6/7/2011
 // Author      : Alberto Realis-Luc <alberto.realisluc@gmail.com>
 // Web         : https://www.alus.it/airnavigator/
-// Copyright   : (C) 2010-2020 Alberto Realis-Luc
+// Copyright   : (C) 2010-2026 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 27/11/2013
+// Last change : 17/10/2026
 // Description : Parses SiRF messages from a GPS device
 //============================================================================
 
-//TODO: This has to be finished and reviewed
+//#define PRINT_MESSAGES
 
 #include <stdlib.h>
 #include <string.h>
-#include <fcntl.h>
-#include <stdint.h>
-//#include <time.h>
-//#include <sys/time.h>
+#include <math.h>
+#include <time.h>
 #include "SiRFparser.h"
 #include "Common.h"
 #include "GPSreceiver.h"
+#include "AirCalc.h"
+#include "BlackBox.h"
+#include "Geoidal.h"
 
-#define MAX_PAYLOAD_LENGHT 1023
+#define SIRF_START_1     0xA0
+#define SIRF_START_2     0xA2
+#define SIRF_END_1       0xB0
+#define SIRF_END_2       0xB3
+#define SIRF_HEADER_LEN  4    //start sequence and payload length
+#define SIRF_TRAILER_LEN 4    //checksum and end sequence
 
-#define SIRF_GEODETIC_MSGID 0x29
-#define SIRF_GEODETIC_MSG_LEN 91
+#define SIRF_MEASURED_NAV_MSGID 0x02
+#define SIRF_MEASURED_NAV_LEN   41
+#define SIRF_TRACKER_MSGID      0x04
+#define SIRF_TRACKER_CHANNELS   12
+#define SIRF_TRACKER_CHAN_LEN   15
+#define SIRF_TRACKER_LEN        (8+SIRF_TRACKER_CHANNELS*SIRF_TRACKER_CHAN_LEN)
+#define SIRF_CLOCK_MSGID        0x07
+#define SIRF_CLOCK_LEN          20
+#define SIRF_GEODETIC_MSGID     0x29
+#define SIRF_GEODETIC_LEN       91
+#define SIRF_NAV_TYPE_NO_FIX    0      //position fix type in bits 0-2 of nav type
+#define SIRF_NAV_TYPE_DR        7      //dead reckoning
+#define SIRF_NAV_VALID_DR_FIX   0x0040 //nav valid: invalid DR position fix
+#define SIRF_NAV_VALID_NO_TRACK 0x8000 //nav valid: no tracker data available for DR
 
+#define GPS_EPOCH_UNIX       315964800 //6/1/1980 00:00:00 UTC
+#define GPS_SECONDS_IN_WEEK  604800
+#define GPS_UTC_LEAP_SECONDS 18        //GPS time is ahead of UTC, the messages with UTC time are preferred
+#define GPS_WEEK_ROLLOVER    1024
 
-enum SiRFparserStatus {
-	SIRF_START_SEQ_1,   //waiting for start sequence
-	SIRF_START_SEQ_2,   //waiting for second byte of sequence
-	SIRF_PAYLOAD_LEN_1, //getting the first byte of payload length
-	SIRF_PAYLOAD_LEN_2, //getting the second byte of payload length
-	SIRF_PAYLOAD,       //getting bytes of the payload
-	SIRF_CHECKSUM_1,    //getting first byte of checksum
-	SIRF_CHECKSUM_2,    //getting the second byte of checksum
-	SIRF_END_SEQ_1,     //get first byte of end sequence
-	SIRF_END_SEQ_2      //get second byte of end sequence
-};
+#define WGS84_A   6378137.0         //semi-major axis in m
+#define WGS84_B   6356752.314245    //semi-minor axis in m
+#define WGS84_E2  6.69437999014e-3  //first eccentricity squared
+#define WGS84_EP2 6.73949674228e-3  //second eccentricity squared
 
-static struct SiRFparserStruct {
-	enum SiRFparserStatus frameStatus;
-	int payloadLength,rcvdBytesOfPayload,checksum;
-	unsigned char payload[MAX_PAYLOAD_LENGHT];
-	unsigned char firstBytePayloadLength,firstByteChecksum;
-};
 
-struct geodetic_nav_data {
-	uint8_t  msgID;
-	uint16_t navValid;
-	uint16_t navType;
-	uint16_t weekNo;
-	uint32_t TOW;
-	uint16_t year;
-	uint8_t month;
-	uint8_t day;
-	uint8_t hour;
-	uint8_t minute;
-	uint16_t second;
-	uint32_t satIDlist;
-	int32_t latitude;
-	int32_t longitude;
-	uint32_t altEllips;
-	uint32_t altitude;
-	uint8_t mapDatum;
-	uint16_t speed;
-	uint16_t course;
-	int16_t magneticVar;
-	int16_t climbRate;
-	int16_t headingRate;
-	uint32_t estHposPosErr;
-	uint32_t estVposPosErr;
-	uint32_t estTimeErr;
-	uint16_t estHvelocityErr;
-	int32_t clockBias;
-	uint32_t clockBiasErr;
-	int32_t clockDrift;
-	uint32_t clockDriftErr;
-	uint32_t distance;
-	uint16_t distErr;
-	uint16_t headingErr;
-	uint8_t SVcount;
-	uint8_t HDOP;
-	uint8_t addModeInfo;
+struct SiRFparserStruct {
+	int extWeek;                           //last GPS week with the rollovers, -1 if still unknown
+	bool geodeticFound;                    //the receiver sends the geodetic message: it is preferred to the measured nav
+	float newerTimestamp;                  //of the last navigation solution
+	struct SiRFparserStats stats;
 };
 
-inline uint16_t endian16_swap(uint16_t val);
-inline uint32_t endian32_swap(uint32_t val);
-void processPayload(char *payloadCopy, int len, long timestamp);
+bool frameMessage(const unsigned char *frame, int payloadLength);
+void decodeMessage(const unsigned char *payload, int len);
+void decodeGeodetic(const unsigned char *p);
+void decodeMeasuredNav(const unsigned char *p);
+void decodeTracker(const unsigned char *p);
+void decodeClock(const unsigned char *p);
+void publishFix(bool posChanged, bool altChanged);
+int fixModeOf(unsigned int fixType);
+void updateGPStime(int week, double tow);
+void ecef2geodetic(double x, double y, double z, double *lat, double *lon, double *h);
+unsigned int getU8(const unsigned char *p);
+unsigned int getU16(const unsigned char *p);
+int getS16(const unsigned char *p);
+unsigned long getU32(const unsigned char *p);
+long getS32(const unsigned char *p);
 
 static struct SiRFparserStruct SiRFparser = {
-	.frameStatus=SIRF_START_SEQ_1,
-	.payloadLength=0,
-	.rcvdBytesOfPayload=0,
-	.checksum=0,
-	.firstBytePayloadLength=0,
-	.firstByteChecksum=0
+	.extWeek=-1,
+	.geodeticFound=false,
+	.newerTimestamp=-1,
+	.stats={0,0,0,0}
 };
 
+bool SiRFparserProcessFrame(const unsigned char *frame, int len) { //a complete frame from the start to the end sequence
+	if(len<SIRF_HEADER_LEN+1+SIRF_TRAILER_LEN || frame[0]!=SIRF_START_1 || frame[1]!=SIRF_START_2 || ((frame[2]<<8)|frame[3])!=len-SIRF_HEADER_LEN-SIRF_TRAILER_LEN) {
+		SiRFparser.stats.wrongFrames++;
+		return false;
+	}
+	return frameMessage(frame,len-SIRF_HEADER_LEN-SIRF_TRAILER_LEN);
+}
 
-void SiRFparserProcessBuffer(unsigned char *buf, long timestamp, int redBytes) {
-	for(int i=0;i<redBytes;i++) {
-		printLog("%02X ",buf[i]); //////////////DEBUG
+void SiRFparserGetStats(struct SiRFparserStats *stats) { //to be called by the GPS thread
+	*stats=SiRFparser.stats;
+}
 
-	switch(SiRFparser.frameStatus) { //for each byte received in the buffer
-		case SIRF_START_SEQ_1: //waiting for start sequence
-			if(buf[i]==0xA0) SiRFparser.frameStatus=SIRF_START_SEQ_2; //found first byte of start sequence
-			break;
-		case SIRF_START_SEQ_2: //waiting for second byte of sequence
-			if(buf[i]==0xA2) SiRFparser.frameStatus=SIRF_PAYLOAD_LEN_1; //found second byte of start sequence
-			else SiRFparser.frameStatus=SIRF_START_SEQ_1;
-			break;
-		case SIRF_PAYLOAD_LEN_1: //getting the first byte of payload length
-			if(buf[i]<=0x7F) { //check if it is OK //should be <=0x03 if the payload is maximum 1023??
-				SiRFparser.firstBytePayloadLength=buf[i];
-				SiRFparser.frameStatus=SIRF_PAYLOAD_LEN_2;
-			} else SiRFparser.frameStatus=SIRF_START_SEQ_1;
-			break;
-		case SIRF_PAYLOAD_LEN_2: //getting the second byte of payload length
-			SiRFparser.payloadLength=SiRFparser.firstBytePayloadLength*256+buf[i];
-			SiRFparser.frameStatus=SIRF_PAYLOAD;
-			SiRFparser.rcvdBytesOfPayload=0;
-			break;
-		case SIRF_PAYLOAD: //getting bytes of the payload //TODO: implement pre-selection on msgID (first byte of payload)
-			SiRFparser.payload[SiRFparser.rcvdBytesOfPayload++]=buf[i];
-			if(SiRFparser.rcvdBytesOfPayload==SiRFparser.payloadLength) SiRFparser.frameStatus=SIRF_CHECKSUM_1;
-			break;
-		case SIRF_CHECKSUM_1: //payload finished, getting first byte of checksum
-			if(buf[i]<=0x7F) { //check if it is OK
-				SiRFparser.firstByteChecksum=buf[i];
-				SiRFparser.frameStatus=SIRF_CHECKSUM_2;
-			} else SiRFparser.frameStatus=SIRF_START_SEQ_1;
+bool frameMessage(const unsigned char *frame, int payloadLength) { //verify checksum and end sequence of a frame: A0 A2 len payload chk B0 B3
+	const unsigned char *payload=frame+SIRF_HEADER_LEN, *trailer=payload+payloadLength;
+	unsigned int checksum=0;
+	for(int i=0;i<payloadLength;i++) checksum=(checksum+payload[i])&0x7FFF;
+	if(trailer[2]!=SIRF_END_1 || trailer[3]!=SIRF_END_2 || getU16(trailer)!=checksum) {
+		SiRFparser.stats.wrongFrames++;
+		return false;
+	}
+	SiRFparser.stats.frames++;
+	decodeMessage(payload,payloadLength);
+	return true;
+}
+
+void decodeMessage(const unsigned char *payload, int len) { //the payload is decoded where it is: no copies
+	switch(payload[0]) { //message ID
+		case SIRF_GEODETIC_MSGID:
+			if(len==SIRF_GEODETIC_LEN) {
+				decodeGeodetic(payload);
+				return;
+			}
 			break;
-		case SIRF_CHECKSUM_2: //getting the second byte of checksum
-			SiRFparser.checksum=SiRFparser.firstByteChecksum*256+buf[i];
-			SiRFparser.frameStatus=SIRF_END_SEQ_1;
+		case SIRF_MEASURED_NAV_MSGID:
+			if(len==SIRF_MEASURED_NAV_LEN) {
+				decodeMeasuredNav(payload);
+				return;
+			}
 			break;
-		case SIRF_END_SEQ_1: //get first byte of end sequence
-			if(buf[i]==0xB0) SiRFparser.frameStatus=SIRF_END_SEQ_2;
-			else {
-				SiRFparser.frameStatus=SIRF_START_SEQ_1;
-				SiRFparser.rcvdBytesOfPayload=0;
+		case SIRF_TRACKER_MSGID:
+			if(len==SIRF_TRACKER_LEN) {
+				decodeTracker(payload);
+				return;
 			}
 			break;
-		case SIRF_END_SEQ_2: //get second byte of end sequence
-			if(buf[i]==0xB3) {
-				int j, calcChecksum=0;
-				for(j=0;j<SiRFparser.payloadLength;j++) calcChecksum=(calcChecksum+SiRFparser.payload[j])&0x7FFF;
-				if(calcChecksum==SiRFparser.checksum) { //CRC check
-					char *payloadCopy=malloc(SiRFparser.payloadLength);
-					if(payloadCopy!=NULL) {
-						memcpy(payloadCopy,SiRFparser.payload,SiRFparser.payloadLength);
-						processPayload(payloadCopy,SiRFparser.payloadLength,timestamp);
-					}
-				} else printLog("Wrong checksum :(\n");
+		case SIRF_CLOCK_MSGID:
+			if(len==SIRF_CLOCK_LEN) {
+				decodeClock(payload);
+				return;
 			}
-			SiRFparser.rcvdBytesOfPayload=0;
-			SiRFparser.frameStatus=SIRF_START_SEQ_1;
 			break;
 		default:
 			break;
-	} } printLog("\n\n"); //end of for(each byte) and switch(status) of received byte
-}
-
-void processPayload(char *payloadCopy, int len, long timestamp) {
-	unsigned char msgID=payloadCopy[0];
-	printLog("Received frame ID: %d of length: %d\n",msgID,len);
-	if(msgID==SIRF_GEODETIC_MSGID && len==SIRF_GEODETIC_MSG_LEN) { //we want to interpret only geodetic
-//TODO: put the data in the right place: in the gps struct of GPSreceiver
-//		time_t curr_time,gps_time;
-//		struct timeval new_time;
-//		//char * saved_tz=NULL;
-//		struct geodetic_nav_data * msg=(struct geodetic_nav_data *)payloadCopy;
-//		lat_deg=((int32_t)endian32_swap(msg->latitude))/10000000;
-//		lat_mins=((endian32_swap(msg->latitude)*60)/10000000)%60;
-//		long_deg=((int32_t)endian32_swap(msg->longitude))/10000000;
-//		long_mins=((endian32_swap(msg->longitude)*60)/10000000)%60;
-//		alt_cm=endian32_swap(msg->altitude);
-//		sat_id_list=endian32_swap(msg->satIDlist);
-//		sat_nb=msg->SVcount;
-//		speed_kmh=(endian16_swap(msg->speed)*36)/1000;
-//		time.tm_sec=endian16_swap(msg->second)/1000;
-//		time.tm_min=msg->minute;
-//		time.tm_hour=msg->hour;
-//		time.tm_mday=msg->day;
-//		time.tm_mon=msg->month-1;
-//		time.tm_year=endian16_swap(msg->year)-1900;
-//		time.tm_isdst=-1;
-//		printLog("lat: %d %d; lon: %d %d; time: %d/%d/%d %d:%d:%d\n",lat_deg,lat_mins,long_deg,long_mins,time.tm_mday,time.tm_mon,time.tm_year,time.tm_hour,time.tm_min,time.tm_sec);
-//		time(&curr_time);
-//		//saved_tz=strdup(getenv("TZ"));
-//		//unsetenv("TZ");
-//		gps_time=mktime(&time);
-//		if(abs(gps_time-curr_time)>10) {
-//			printLog("Syncing clock needed ! system : %d - GPS : %d\n",(int)curr_time,(int)gps_time);
-//			new_time.tv_sec=gps_time;
-//			new_time.tv_usec=0;
-//			settimeofday(&new_time,NULL);
-//		} else printLog("No need to sync.\n");
-//		//if(saved_tz!=NULL) {
-//		//	setenv("TZ",saved_tz,1);
-//		//	free(saved_tz);
-//		//}
-		printLog("Geodetic OK !\n");
 	}
-	free(payloadCopy);
+	SiRFparser.stats.ignoredFrames++;
+	#ifdef PRINT_MESSAGES
+	printLog("SiRFparser: ignored message ID: 0x%02X of length: %d\n",payload[0],len);
+	#endif
+}
+
+void decodeGeodetic(const unsigned char *p) { //message 0x29: the complete navigation solution in UTC and WGS84
+	SiRFparser.geodeticFound=true;
+	SiRFparser.extWeek=getU16(p+5); //extended GPS week
+	updateNumOfActiveSats(getU8(p+88));
+	unsigned int navValid=getU16(p+1), fixType=getU16(p+3)&0x07; //nav type: position fix type in bits 0-2
+	if(fixType==SIRF_NAV_TYPE_NO_FIX || (fixType==SIRF_NAV_TYPE_DR && (navValid&(SIRF_NAV_VALID_DR_FIX|SIRF_NAV_VALID_NO_TRACK)))) { //the other nav valid bits are only advisory, like less than 5 SVs
+		updateFixMode(MODE_NO_FIX);
+		return;
+	}
+	updateFixMode(fixModeOf(fixType));
+	int hour=getU8(p+15), minute=getU8(p+16);
+	float second=getU16(p+17)/1000.0; //ms
+	float timestamp=hour*3600+minute*60+second;
+	bool dateChanged=updateDate(getU8(p+14),getU8(p+13),getU16(p+11));
+	if(!dateChanged && timestamp<=SiRFparser.newerTimestamp) return; //old or already received
+	SiRFparser.newerTimestamp=timestamp;
+	updateTime(timestamp,hour,minute,second); //updateTime must be done always before of updatePosition
+	bool posChanged=updateLatLon(getS32(p+23)/1e7,getS32(p+27)/1e7,dateChanged); //deg*10^7
+	bool altChanged=updateAltitudes(getS32(p+31)/100.0,getS32(p+35)/100.0); //cm on the ellipsoid and on m.s.l.
+	updateTrack(getU16(p+40)/100.0,getU16(p+42)/100.0); //speed over ground m/s*100 and course over ground deg*100
+	gps.climbFtMin=ms2FtMin(getS16(p+46)/100.0); //m/s*100
+	gps.turnRateDegSec=getS16(p+48)/100.0; //deg/s*100
+	gps.turnRateDegMin=gps.turnRateDegSec*60;
+	float hErr=getU32(p+50)/100.0; //estimated horizontal and vertical position errors in cm
+	updatePositionErrors(hErr,hErr,getU32(p+54)/100.0);
+	gps.hdop=getU8(p+89)/5.0; //HDOP*5
+	publishFix(posChanged,altChanged);
+}
+
+void decodeMeasuredNav(const unsigned char *p) { //message 0x02: position and velocity in ECEF and GPS time
+	int mode=fixModeOf(getU8(p+19)&0x07); //mode 1: position fix type in bits 0-2
+	updateNumOfActiveSats(getU8(p+28));
+	if(SiRFparser.geodeticFound) return; //the geodetic message of the same solution has more data and the UTC time
+	updateFixMode(mode);
+	if(mode==MODE_NO_FIX) return;
+	int week=getU16(p+22);
+	if(SiRFparser.extWeek>=0) week+=(SiRFparser.extWeek-week+GPS_WEEK_ROLLOVER/2)/GPS_WEEK_ROLLOVER*GPS_WEEK_ROLLOVER; //the week here can be without rollovers
+	else if(week<GPS_WEEK_ROLLOVER) week+=2*GPS_WEEK_ROLLOVER; //assume the current era
+	float prevTimestamp=gps.timestamp;
+	int prevDay=gps.day;
+	updateGPStime(week,getU32(p+24)/100.0); //TOW s*100
+	if(gps.day==prevDay && gps.timestamp<=prevTimestamp) return; //old or already received
+	SiRFparser.newerTimestamp=gps.timestamp;
+	double x=getS32(p+1), y=getS32(p+5), z=getS32(p+9); //m
+	double vx=getS16(p+13)/8.0, vy=getS16(p+15)/8.0, vz=getS16(p+17)/8.0; //m/s*8
+	double lat, lon, h;
+	ecef2geodetic(x,y,z,&lat,&lon,&h);
+	double sinLat=sin(lat), cosLat=cos(lat), sinLon=sin(lon), cosLon=cos(lon);
+	double vEast=-sinLon*vx+cosLon*vy; //velocity from ECEF to local east, north, up
+	double vNorth=-sinLat*cosLon*vx-sinLat*sinLon*vy+cosLat*vz;
+	double vUp=cosLat*cosLon*vx+cosLat*sinLon*vy+sinLat*vz;
+	bool posChanged=updateLatLon(Rad2Deg(lat),Rad2Deg(lon),gps.day!=prevDay);
+	bool altChanged=updateAltitudes(h,h-GeoidalGetSeparation(Rad2Deg(lat),Rad2Deg(lon))); //h is on the ellipsoid
+	double track=Rad2Deg(atan2(vEast,vNorth));
+	if(track<0) track+=360;
+	updateTrack(sqrt(vEast*vEast+vNorth*vNorth),track);
+	gps.climbFtMin=ms2FtMin(vUp);
+	gps.hdop=getU8(p+20)/5.0; //HDOP*5
+	publishFix(posChanged,altChanged);
+}
+
+void decodeTracker(const unsigned char *p) { //message 0x04: satellites tracked in each channel
+	int i, j, inView=0, channels=getU8(p+7);
+	if(channels>SIRF_TRACKER_CHANNELS) channels=SIRF_TRACKER_CHANNELS;
+	for(i=0;i<MAX_NUM_SAT;i++) for(j=SAT_ELEVATION;j<=SAT_SNR;j++) gps.satellites[i][j]=-1; //reset all sats
+	for(i=0;i<channels;i++) {
+		const unsigned char *chan=p+8+i*SIRF_TRACKER_CHAN_LEN;
+		int satId=getU8(chan);
+		if(satId==0) continue; //channel not used
+		inView++;
+		if(satId>MAX_NUM_SAT) continue; //not in our table
+		int cNo=0;
+		for(j=0;j<10;j++) cNo+=getU8(chan+5+j); //C/No in dB-Hz of each 100 ms of the last second
+		gps.satellites[satId-1][SAT_AZIMUTH]=getU8(chan+1)*3/2; //deg*2/3
+		gps.satellites[satId-1][SAT_ELEVATION]=getU8(chan+2)/2; //deg*2
+		gps.satellites[satId-1][SAT_SNR]=cNo/10;
+	}
+	updateNumOfTotalSatsInView(inView);
+}
+
+void decodeClock(const unsigned char *p) { //message 0x07: clock status
+	SiRFparser.extWeek=getU16(p+1); //extended GPS week
+	updateNumOfActiveSats(getU8(p+7));
+	#ifdef PRINT_MESSAGES
+	printLog("SiRFparser: clock drift: %lu Hz bias: %lu ns\n",getU32(p+8),getU32(p+12));
+	#endif
+}
+
+void publishFix(bool posChanged, bool altChanged) { //give the new solution to the navigator and to the black box
+	if(posChanged||altChanged) {
+		SiRFparser.stats.fixes++;
+		GPSreceiverNavigate();
+	}
+	BlackBoxCommit();
+}
+
+int fixModeOf(unsigned int fixType) { //from the position fix type of the nav type and mode 1 fields
+	switch(fixType) {
+		case 0: //no navigation solution
+			return MODE_NO_FIX;
+		case 4: //KF solution with more than 3 satellites
+		case 6: //3D least squares solution
+			return MODE_3D_FIX;
+		default: //KF with 1, 2 or 3 satellites, 2D least squares or dead reckoning
+			return MODE_2D_FIX;
+	}
+}
+
+void updateGPStime(int week, double tow) { //from GPS time to UTC date and time
+	time_t t=GPS_EPOCH_UNIX+(time_t)week*GPS_SECONDS_IN_WEEK+(time_t)floor(tow)-GPS_UTC_LEAP_SECONDS;
+	struct tm utc;
+	gmtime_r(&t,&utc);
+	float second=utc.tm_sec+(tow-floor(tow));
+	updateDate(utc.tm_mday,utc.tm_mon+1,utc.tm_year+1900);
+	updateTime(utc.tm_hour*3600+utc.tm_min*60+second,utc.tm_hour,utc.tm_min,second);
+}
+
+void ecef2geodetic(double x, double y, double z, double *lat, double *lon, double *h) { //Bowring's method: mm accuracy near the Earth surface
+	double p=sqrt(x*x+y*y);
+	double theta=atan2(z*WGS84_A,p*WGS84_B);
+	double sinTheta=sin(theta), cosTheta=cos(theta);
+	*lat=atan2(z+WGS84_EP2*WGS84_B*sinTheta*sinTheta*sinTheta,p-WGS84_E2*WGS84_A*cosTheta*cosTheta*cosTheta);
+	*lon=atan2(y,x);
+	double sinLat=sin(*lat);
+	double n=WGS84_A/sqrt(1-WGS84_E2*sinLat*sinLat); //radius of curvature in the prime vertical
+	*h=p/cos(*lat)-n;
+}
+
+unsigned int getU8(const unsigned char *p) { //SiRF fields are big endian and not aligned
+	return p[0];
+}
+
+unsigned int getU16(const unsigned char *p) {
+	return (p[0]<<8)|p[1];
+}
+
+int getS16(const unsigned char *p) {
+	return (short)getU16(p);
 }
 
-inline uint16_t endian16_swap(uint16_t val) { //16 bits endianess helper
-	uint16_t temp;
-	temp = val & 0xFF;
-	temp = (val >> 8) | (temp << 8);
-	return temp;
+unsigned long getU32(const unsigned char *p) {
+	return ((unsigned long)p[0]<<24)|((unsigned long)p[1]<<16)|((unsigned long)p[2]<<8)|p[3];
 }
 
-inline uint32_t endian32_swap(uint32_t val) { //32 bits endianess hleper
-	uint32_t temp;
-	temp = ( val >> 24) | ((val & 0x00FF0000) >> 8) |  ((val & 0x0000FF00) << 8) | ((val & 0x000000FF) << 24);
-	return temp;
+long getS32(const unsigned char *p) {
+	return (long)(int)getU32(p);
 }
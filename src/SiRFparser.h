@@ -3,10 +3,10 @@
 // Since       : 6/7/2011
 // Author      : Alberto Realis-Luc <alberto.realisluc@gmail.com>
 // Web         : https://www.alus.it/airnavigator/
-// Copyright   : (C) 2010-2020 Alberto Realis-Luc
+// Copyright   : (C) 2010-2026 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 25/11/2013
+// Last change : 17/10/2026
 // Description : Parses SiRF messages from a GPS device
 //============================================================================
 
@@ -14,9 +14,19 @@
 #ifndef SIRFPARSER_H_
 #define SIRFPARSER_H_
 
-#define SIRF_BUFFER_SIZE        1034
+#include "Common.h"
 
-void SiRFparserProcessBuffer(unsigned char *buf, long timestamp, int redBytes);
+#define SIRF_MAX_PAYLOAD        1023 //the length is on 15 bits but the protocol limits the payload to 1023 bytes
+
+struct SiRFparserStats {
+	unsigned long frames;        //frames received with the right checksum
+	unsigned long wrongFrames;   //frames discarded because of wrong length, checksum or end sequence
+	unsigned long ignoredFrames; //frames of messages not decoded or with an unexpected length
+	unsigned long fixes;         //new positions or altitudes given to the navigator
+};
+
+bool SiRFparserProcessFrame(const unsigned char *frame, int len);
+void SiRFparserGetStats(struct SiRFparserStats *stats);
 
 
 #endif
@@ -0,0 +1,267 @@
+//============================================================================
+// Name        : SpatialIndex.c
+// Since       : 17/10/2026
+// Author      : Alberto Realis-Luc <alberto.realisluc@gmail.com>
+// Web         : https://www.alus.it/airnavigator/
+// Copyright   : (C) 2010-2026 Alberto Realis-Luc
+// License     : GNU GPL v2
+// Repository  : https://github.com/alus-it/AirNavigator.git
+// Last change : 17/10/2026
+// Description : k-d trees of the waypoints and of the legs of the flight plan
+//============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "SpatialIndex.h"
+
+// The waypoints are unit vectors on the sphere: the chord between two of them grows
+// with their great circle distance, so the nearest one is the nearest in the space
+// and it can be searched with a k-d tree. The tree is implicit: the node of the items
+// between lo and hi (excluded) is the one in the middle, its subtrees are the halves.
+// Each node keeps the bounding box of its subtree: a subtree farther than the best
+// item found so far is never visited.
+// A leg is kept in the tree as the ball around its middle that contains the whole arc.
+
+struct KdTree {
+	int num;              //number of items
+	int *item;            //item of each node
+	unsigned char *axis;  //split axis of each node
+	double (*box)[6];     //bounding box of the subtree of each node: min x,y,z then max x,y,z
+	double (*center)[3];  //center of each item
+	double *radius;       //radius of the ball around the center containing each item, NULL for the points
+};
+
+struct SpatialIndexStruct {
+	void *arena;            //the only allocation of the index, NULL when not built
+	int numPoints, numLegs;
+	double (*point)[3];     //unit vectors of the waypoints
+	double (*normal)[3];    //unit normal to the plane of the great circle of each leg, zero if undefined
+	double (*legCenter)[3]; //middle of each leg
+	double *legRadius;      //chord from the middle to the ends of each leg
+	struct KdTree points, legs;
+};
+
+void toUnitVector(const double sinLat, const double cosLat, const double lon, double v[3]);
+double dotProduct(const double a[3], const double b[3]);
+void crossProduct(const double a[3], const double b[3], double c[3]);
+double chordSquare(const double a[3], const double b[3]);
+double chordSquare2Angle(double c2);
+double pointDist2(const int item, const double q[3]);
+double legDist2(const int item, const double q[3]);
+double boxDist2(const double box[6], const double q[3]);
+void buildTree(struct KdTree *tree, int lo, int hi);
+void searchTree(const struct KdTree *tree, int lo, int hi, const double q[3], double (*dist2)(const int, const double*), double *best, int *bestItem);
+
+static struct SpatialIndexStruct SpatialIndex = {
+	.arena=NULL,
+	.numPoints=0,
+	.numLegs=0
+};
+
+void toUnitVector(const double sinLat, const double cosLat, const double lon, double v[3]) {
+	v[0]=cosLat*cos(lon);
+	v[1]=cosLat*sin(lon);
+	v[2]=sinLat;
+}
+
+double dotProduct(const double a[3], const double b[3]) {
+	return a[0]*b[0]+a[1]*b[1]+a[2]*b[2];
+}
+
+void crossProduct(const double a[3], const double b[3], double c[3]) {
+	c[0]=a[1]*b[2]-a[2]*b[1];
+	c[1]=a[2]*b[0]-a[0]*b[2];
+	c[2]=a[0]*b[1]-a[1]*b[0];
+}
+
+double chordSquare(const double a[3], const double b[3]) {
+	double dx=a[0]-b[0], dy=a[1]-b[1], dz=a[2]-b[2];
+	return dx*dx+dy*dy+dz*dz;
+}
+
+double chordSquare2Angle(double c2) { //great circle distance in rad from the square of the chord
+	if(c2>4) c2=4;
+	return 2*asin(sqrt(c2)/2);
+}
+
+double pointDist2(const int item, const double q[3]) {
+	return chordSquare(SpatialIndex.point[item],q);
+}
+
+double legDist2(const int item, const double q[3]) { //square of the chord to the nearest point of the leg
+	const double *a=SpatialIndex.point[item], *b=SpatialIndex.point[item+1], *n=SpatialIndex.normal[item];
+	if(n[0]!=0 || n[1]!=0 || n[2]!=0) {
+		double s=dotProduct(q,n); //sine of the cross track distance
+		double p[3]={q[0]-s*n[0],q[1]-s*n[1],q[2]-s*n[2]}; //projection of q on the plane of the leg
+		double ap[3], pb[3];
+		crossProduct(a,p,ap);
+		crossProduct(p,b,pb);
+		if(dotProduct(ap,n)>=0 && dotProduct(pb,n)>=0) { //the perpendicular falls inside the leg
+			double c=1-s*s;
+			return 2-2*sqrt(c>0?c:0);
+		}
+	}
+	double da=chordSquare(a,q), db=chordSquare(b,q); //otherwise the nearest is one of the ends
+	return da<db?da:db;
+}
+
+double boxDist2(const double box[6], const double q[3]) { //square of the distance from q to the box, 0 if inside
+	double d2=0;
+	int k;
+	for(k=0;k<3;k++) {
+		if(q[k]<box[k]) d2+=(box[k]-q[k])*(box[k]-q[k]);
+		else if(q[k]>box[k+3]) d2+=(q[k]-box[k+3])*(q[k]-box[k+3]);
+	}
+	return d2;
+}
+
+void buildTree(struct KdTree *tree, int lo, int hi) {
+	if(lo>=hi) return;
+	int i, j, k, mid=(lo+hi)/2;
+	double *box=tree->box[mid];
+	for(k=0;k<3;k++) {
+		box[k]=HUGE_VAL;
+		box[k+3]=-HUGE_VAL;
+	}
+	for(i=lo;i<hi;i++) { //box containing all the items of this subtree
+		const double *c=tree->center[tree->item[i]];
+		double r=(tree->radius!=NULL)?tree->radius[tree->item[i]]:0;
+		for(k=0;k<3;k++) {
+			if(c[k]-r<box[k]) box[k]=c[k]-r;
+			if(c[k]+r>box[k+3]) box[k+3]=c[k]+r;
+		}
+	}
+	int axis=0;
+	for(k=1;k<3;k++) if(box[k+3]-box[k]>box[axis+3]-box[axis]) axis=k; //split where the subtree is wider
+	tree->axis[mid]=axis;
+	int l=lo, h=hi-1;
+	while(l<h) { //quickselect: the item with the median center along the axis goes in the middle
+		double pivot=tree->center[tree->item[(l+h)/2]][axis];
+		i=l;
+		j=h;
+		while(i<=j) {
+			while(tree->center[tree->item[i]][axis]<pivot) i++;
+			while(tree->center[tree->item[j]][axis]>pivot) j--;
+			if(i<=j) {
+				int tmp=tree->item[i];
+				tree->item[i++]=tree->item[j];
+				tree->item[j--]=tmp;
+			}
+		}
+		if(mid<=j) h=j;
+		else if(mid>=i) l=i;
+		else break;
+	}
+	buildTree(tree,lo,mid);
+	buildTree(tree,mid+1,hi);
+}
+
+void searchTree(const struct KdTree *tree, int lo, int hi, const double q[3], double (*dist2)(const int, const double*), double *best, int *bestItem) {
+	if(lo>=hi) return;
+	int mid=(lo+hi)/2;
+	if(boxDist2(tree->box[mid],q)>*best) return; //nothing nearer in this subtree
+	int item=tree->item[mid], axis=tree->axis[mid];
+	double d2=dist2(item,q);
+	if(d2<*best || (d2==*best && item>*bestItem)) { //at the same distance the last one, as calcNearestPoint
+		*best=d2;
+		*bestItem=item;
+	}
+	if(q[axis]<tree->center[item][axis]) { //first the half where q is
+		searchTree(tree,lo,mid,q,dist2,best,bestItem);
+		searchTree(tree,mid+1,hi,q,dist2,best,bestItem);
+	} else {
+		searchTree(tree,mid+1,hi,q,dist2,best,bestItem);
+		searchTree(tree,lo,mid,q,dist2,best,bestItem);
+	}
+}
+
+bool SpatialIndexBuild(const double *sinLats, const double *cosLats, const double *lons, const int num) {
+	SpatialIndexClear();
+	if(num<1) return false;
+	int i, numLegs=num-1;
+	size_t numDoubles=9*num+13*numLegs; //points and boxes of the points, normals, centers, radii and boxes of the legs
+	double *arrays=(double*)malloc(numDoubles*sizeof(double)+(num+numLegs)*(sizeof(int)+1));
+	if(arrays==NULL) {
+		printLog("SpatialIndex: ERROR not enough memory to index %d waypoints.\n",num);
+		return false;
+	}
+	SpatialIndex.arena=arrays;
+	SpatialIndex.numPoints=num;
+	SpatialIndex.numLegs=numLegs;
+	SpatialIndex.point=(double(*)[3])arrays;
+	SpatialIndex.normal=(double(*)[3])(arrays+3*num);
+	SpatialIndex.legCenter=(double(*)[3])(arrays+3*num+3*numLegs);
+	SpatialIndex.legRadius=arrays+3*num+6*numLegs;
+	SpatialIndex.points.box=(double(*)[6])(arrays+3*num+7*numLegs);
+	SpatialIndex.legs.box=(double(*)[6])(arrays+9*num+7*numLegs);
+	SpatialIndex.points.item=(int*)(arrays+numDoubles);
+	SpatialIndex.legs.item=SpatialIndex.points.item+num;
+	SpatialIndex.points.axis=(unsigned char*)(SpatialIndex.legs.item+numLegs);
+	SpatialIndex.legs.axis=SpatialIndex.points.axis+num;
+	SpatialIndex.points.num=num;
+	SpatialIndex.points.center=SpatialIndex.point;
+	SpatialIndex.points.radius=NULL;
+	SpatialIndex.legs.num=numLegs;
+	SpatialIndex.legs.center=SpatialIndex.legCenter;
+	SpatialIndex.legs.radius=SpatialIndex.legRadius;
+	for(i=0;i<num;i++) {
+		toUnitVector(sinLats[i],cosLats[i],lons[i],SpatialIndex.point[i]);
+		SpatialIndex.points.item[i]=i;
+	}
+	for(i=0;i<numLegs;i++) {
+		const double *a=SpatialIndex.point[i], *b=SpatialIndex.point[i+1];
+		double *n=SpatialIndex.normal[i], *c=SpatialIndex.legCenter[i];
+		crossProduct(a,b,n);
+		double len=sqrt(dotProduct(n,n));
+		if(len>1e-12) { //otherwise a null or antipodal leg: no plane, only its ends
+			n[0]/=len;
+			n[1]/=len;
+			n[2]/=len;
+		} else n[0]=n[1]=n[2]=0;
+		c[0]=a[0]+b[0];
+		c[1]=a[1]+b[1];
+		c[2]=a[2]+b[2];
+		len=sqrt(dotProduct(c,c));
+		if(len>1e-12) { //the middle of the arc, each point of the arc is nearer to it than the ends
+			c[0]/=len;
+			c[1]/=len;
+			c[2]/=len;
+			SpatialIndex.legRadius[i]=sqrt(chordSquare(c,a));
+		} else { //antipodal ends: the arc can be anywhere
+			c[0]=c[1]=c[2]=0;
+			SpatialIndex.legRadius[i]=1;
+		}
+		SpatialIndex.legs.item[i]=i;
+	}
+	buildTree(&SpatialIndex.points,0,num);
+	buildTree(&SpatialIndex.legs,0,numLegs);
+	return true;
+}
+
+int SpatialIndexNearestPoint(const double lat, const double lon, double *dist) { //returns -1 if the index is not built
+	if(SpatialIndex.arena==NULL) return -1;
+	double q[3], best=HUGE_VAL;
+	int nearest=-1;
+	toUnitVector(sin(lat),cos(lat),lon,q);
+	searchTree(&SpatialIndex.points,0,SpatialIndex.numPoints,q,pointDist2,&best,&nearest);
+	if(dist!=NULL) *dist=chordSquare2Angle(best);
+	return nearest;
+}
+
+int SpatialIndexNearestLeg(const double lat, const double lon, double *dist) { //returns the number of the leg or -1 if there are no legs
+	if(SpatialIndex.arena==NULL || SpatialIndex.numLegs<1) return -1;
+	double q[3], best=HUGE_VAL;
+	int nearest=-1;
+	toUnitVector(sin(lat),cos(lat),lon,q);
+	searchTree(&SpatialIndex.legs,0,SpatialIndex.numLegs,q,legDist2,&best,&nearest);
+	if(dist!=NULL) *dist=chordSquare2Angle(best);
+	return nearest+1; //the leg of the item 0 is the leg 1, ending on the waypoint 1
+}
+
+void SpatialIndexClear(void) {
+	free(SpatialIndex.arena);
+	SpatialIndex.arena=NULL;
+	SpatialIndex.numPoints=0;
+	SpatialIndex.numLegs=0;
+}
@@ -0,0 +1,29 @@
+//============================================================================
+// Name        : SpatialIndex.h
+// Since       : 17/10/2026
+// Author      : Alberto Realis-Luc <alberto.realisluc@gmail.com>
+// Web         : https://www.alus.it/airnavigator/
+// Copyright   : (C) 2010-2026 Alberto Realis-Luc
+// License     : GNU GPL v2
+// Repository  : https://github.com/alus-it/AirNavigator.git
+// Last change : 17/10/2026
+// Description : Header of the spatial index of the flight plan: SpatialIndex.c
+//============================================================================
+
+#ifndef SPATIALINDEX_H_
+#define SPATIALINDEX_H_
+
+#include "Common.h"
+
+// Index of the waypoints and of the legs of the flight plan, built by the Navigator
+// each time the route is calculated. The nearest waypoint and the nearest leg to a
+// position are found in logarithmic time instead of checking all of them.
+// The legs are the great circle arcs between consecutive waypoints: the leg n goes
+// from the waypoint n-1 to the waypoint n, so the first leg is the number 1.
+
+bool SpatialIndexBuild(const double *sinLats, const double *cosLats, const double *lons, const int num);
+int SpatialIndexNearestPoint(const double lat, const double lon, double *dist);
+int SpatialIndexNearestLeg(const double lat, const double lon, double *dist);
+void SpatialIndexClear(void);
+
+#endif /* SPATIALINDEX_H_ */
@@ -6,7 +6,7 @@
 // Copyright   : (C) 2010-2020 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 29/11/2013
+// Last change : 17/10/2026
 // Description : Touch screen reader
 //============================================================================
 
@@ -16,6 +16,8 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <signal.h>
+#include <errno.h>
+#include <sys/time.h>
 #include <sys/ioctl.h>
 #include <barcelona/Barc_ts.h>
 //#include <barcelona/Barc_Battery.h>
@@ -127,6 +129,27 @@ short TSreaderGetTouch(TS_EVENT *lastTouch) {
 	return 1;
 }
 
+short TSreaderWaitTouch(TS_EVENT *lastTouch, int timeoutMs) { //as TSreaderGetTouch but returns 0 if nothing touched within the timeout
+	if(TSreader.reading!=1) return -1;
+	struct timeval now;
+	struct timespec until;
+	gettimeofday(&now,NULL);
+	until.tv_sec=now.tv_sec+timeoutMs/1000;
+	until.tv_nsec=(now.tv_usec+(timeoutMs%1000)*1000L)*1000L;
+	if(until.tv_nsec>=1000000000L) {
+		until.tv_sec++;
+		until.tv_nsec-=1000000000L;
+	}
+	pthread_mutex_lock(&TSreader.lastTouchMutex);
+	if(pthread_cond_timedwait(&TSreader.lastTouchSignal,&TSreader.lastTouchMutex,&until)==ETIMEDOUT) {
+		pthread_mutex_unlock(&TSreader.lastTouchMutex);
+		return 0;
+	}
+	*lastTouch=TSreader.lastTouch;
+	pthread_mutex_unlock(&TSreader.lastTouchMutex);
+	return 1;
+}
+
 /*
 //Other useful function for tomtom devices but not working
 short checkBattery(short *batVolt, short *refVolt, short *chargeCurr) {
@@ -6,7 +6,7 @@
 // Copyright   : (C) 2010-2020 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 29/11/2013
+// Last change : 17/10/2026
 // Description : Header of TSreader.c the touch screen reader
 //============================================================================
 
@@ -20,6 +20,7 @@
 short TSreaderStart(void);
 void TSreaderClose(void);
 short TSreaderGetTouch(TS_EVENT *lastTouch);
+short TSreaderWaitTouch(TS_EVENT *lastTouch, int timeoutMs);
 
 //short checkBattery(short *batVolt, short *refVolt, short *chargeCurr);
 
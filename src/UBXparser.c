@@ -0,0 +1,253 @@
+//============================================================================
+// Name        : UBXparser.c
+// Since       : 17/10/2026
+// Author      : Alberto Realis-Luc <alberto.realisluc@gmail.com>
+// Web         : https://www.alus.it/airnavigator/
+// Copyright   : (C) 2010-2026 Alberto Realis-Luc
+// License     : GNU GPL v2
+// Repository  : https://github.com/alus-it/AirNavigator.git
+// Last change : 17/10/2026
+// Description : Parses UBX messages from a u-blox GPS receiver and configures it
+//============================================================================
+
+//#define PRINT_MESSAGES
+
+#include <string.h>
+#include <unistd.h>
+#include "UBXparser.h"
+#include "GPSreceiver.h"
+#include "AirCalc.h"
+#include "BlackBox.h"
+
+#define UBX_SYNC_1      0xB5
+#define UBX_SYNC_2      0x62
+#define UBX_HEADER_LEN  6 //sync chars, class, ID and payload length
+#define UBX_TRAILER_LEN 2 //checksum
+
+#define UBX_CLASS_NAV   0x01
+#define UBX_CLASS_ACK   0x05
+#define UBX_CLASS_CFG   0x06
+#define UBX_CLASS_NMEA  0xF0
+
+#define UBX_NAV_DOP     0x04
+#define UBX_NAV_DOP_LEN 18
+#define UBX_NAV_PVT     0x07
+#define UBX_NAV_PVT_LEN 92
+#define UBX_NAV_SAT     0x35
+#define UBX_NAV_SAT_HEADER_LEN 8
+#define UBX_NAV_SAT_SV_LEN     12
+#define UBX_ACK_NAK     0x00
+#define UBX_ACK_ACK     0x01
+#define UBX_ACK_LEN     2
+#define UBX_CFG_MSG     0x01
+#define UBX_CFG_RATE    0x08
+
+#define UBX_GNSS_GPS    0 //gnssId of the GPS satellites in NAV-SAT
+
+#define NMEA_STANDARD_MESSAGES 6 //GGA, GLL, GSA, GSV, RMC and VTG have IDs from 0 to 5 in the NMEA class
+
+
+struct UBXparserStruct {
+	struct UBXparserStats stats;
+};
+
+void decodeNavPVT(const unsigned char *p);
+void decodeNavSat(const unsigned char *p, int len);
+void decodeNavDOP(const unsigned char *p);
+void decodeAck(const unsigned char *p, bool acknowledged);
+void calcUBXchecksum(const unsigned char *data, int len, unsigned char *ckA, unsigned char *ckB);
+bool sendUBX(int fd, unsigned char msgClass, unsigned char msgId, const unsigned char *payload, int len);
+bool setMessageRate(int fd, unsigned char msgClass, unsigned char msgId, unsigned char rate);
+unsigned int getUBXu16(const unsigned char *p);
+int getUBXs16(const unsigned char *p);
+unsigned long getUBXu32(const unsigned char *p);
+long getUBXs32(const unsigned char *p);
+
+static struct UBXparserStruct UBXparser = {
+	.stats={0,0,0,0,0}
+};
+
+bool UBXparserProcessFrame(const unsigned char *frame, int len) { //a complete frame: the payload is decoded where it is
+	unsigned char ckA, ckB;
+	if(len<UBX_HEADER_LEN+UBX_TRAILER_LEN || frame[0]!=UBX_SYNC_1 || frame[1]!=UBX_SYNC_2 || (int)getUBXu16(frame+4)!=len-UBX_HEADER_LEN-UBX_TRAILER_LEN) {
+		UBXparser.stats.wrongFrames++;
+		return false;
+	}
+	calcUBXchecksum(frame+2,len-2-UBX_TRAILER_LEN,&ckA,&ckB); //from the class to the end of the payload
+	if(ckA!=frame[len-2] || ckB!=frame[len-1]) {
+		UBXparser.stats.wrongFrames++;
+		return false;
+	}
+	UBXparser.stats.frames++;
+	const unsigned char *payload=frame+UBX_HEADER_LEN;
+	int payloadLen=len-UBX_HEADER_LEN-UBX_TRAILER_LEN;
+	if(frame[2]==UBX_CLASS_NAV) switch(frame[3]) {
+		case UBX_NAV_PVT:
+			if(payloadLen==UBX_NAV_PVT_LEN) {
+				decodeNavPVT(payload);
+				return true;
+			}
+			break;
+		case UBX_NAV_SAT:
+			if(payloadLen>=UBX_NAV_SAT_HEADER_LEN && payloadLen==UBX_NAV_SAT_HEADER_LEN+payload[5]*UBX_NAV_SAT_SV_LEN) {
+				decodeNavSat(payload,payloadLen);
+				return true;
+			}
+			break;
+		case UBX_NAV_DOP:
+			if(payloadLen==UBX_NAV_DOP_LEN) {
+				decodeNavDOP(payload);
+				return true;
+			}
+			break;
+		default:
+			break;
+	} else if(frame[2]==UBX_CLASS_ACK && payloadLen==UBX_ACK_LEN && (frame[3]==UBX_ACK_ACK || frame[3]==UBX_ACK_NAK)) {
+		decodeAck(payload,frame[3]==UBX_ACK_ACK);
+		return true;
+	}
+	UBXparser.stats.ignoredFrames++;
+	#ifdef PRINT_MESSAGES
+	printLog("UBXparser: ignored message class: 0x%02X ID: 0x%02X of length: %d\n",frame[2],frame[3],payloadLen);
+	#endif
+	return true;
+}
+
+bool UBXparserConfigure(int fd, int rateHz) { //switch a u-blox receiver to UBX navigation messages at the required rate
+	unsigned char rate[6];
+	int i, measRateMs;
+	bool ok=true;
+	if(rateHz<1) rateHz=1;
+	else if(rateHz>UBX_MAX_RATE) rateHz=UBX_MAX_RATE;
+	for(i=0;i<NMEA_STANDARD_MESSAGES;i++) ok&=setMessageRate(fd,UBX_CLASS_NMEA,i,0); //no more NMEA: it would saturate the link
+	ok&=setMessageRate(fd,UBX_CLASS_NAV,UBX_NAV_PVT,1); //each navigation solution
+	ok&=setMessageRate(fd,UBX_CLASS_NAV,UBX_NAV_DOP,1);
+	ok&=setMessageRate(fd,UBX_CLASS_NAV,UBX_NAV_SAT,rateHz); //satellites once per second
+	measRateMs=1000/rateHz;
+	rate[0]=measRateMs&0xFF; //CFG-RATE: measurement rate in ms, ...
+	rate[1]=measRateMs>>8;
+	rate[2]=1; //... one navigation solution each measurement ...
+	rate[3]=0;
+	rate[4]=1; //... aligned to GPS time
+	rate[5]=0;
+	ok&=sendUBX(fd,UBX_CLASS_CFG,UBX_CFG_RATE,rate,sizeof(rate));
+	if(ok) printLog("UBXparser: receiver configured for UBX navigation messages at %d Hz.\n",rateHz);
+	else printLog("UBXparser: ERROR unable to send the configuration to the receiver.\n");
+	return ok;
+}
+
+void UBXparserGetStats(struct UBXparserStats *stats) { //to be called by the GPS thread
+	*stats=UBXparser.stats;
+}
+
+void decodeNavPVT(const unsigned char *p) { //position, velocity and time solution
+	unsigned int valid=p[11], fixType=p[20], flags=p[21];
+	updateNumOfActiveSats(p[23]);
+	if(fixType==0 || fixType>4 || (fixType>1 && !(flags&0x01))) { //no fix, time only or not gnssFixOK
+		updateFixMode(MODE_NO_FIX);
+		return;
+	}
+	updateFixMode((fixType==2 || fixType==1)?MODE_2D_FIX:MODE_3D_FIX); //2D, dead reckoning only, 3D or GNSS with dead reckoning
+	bool dateChanged=false;
+	if(valid&0x01) dateChanged=updateDate(p[7],p[6],getUBXu16(p+4)); //valid date
+	if(valid&0x02) { //valid time: seconds are rounded, nano is the signed correction
+		float timestamp=p[8]*3600+p[9]*60+p[10]+getUBXs32(p+16)/1e9;
+		if(timestamp<0) timestamp+=86400;
+		int hour, minute;
+		float second;
+		convertTimestamp2HourMinSec(timestamp,&hour,&minute,&second);
+		updateTime(timestamp,hour,minute,second); //updateTime must be done always before of updatePosition
+	}
+	if(valid&0x08) { //valid magnetic declination, East positive
+		int magDec=getUBXs16(p+88);
+		gps.isMagVarToEast=(magDec>=0);
+		gps.magneticVariation=(magDec>=0?magDec:-magDec)/100.0;
+	}
+	bool posChanged=updateLatLon(getUBXs32(p+28)/1e7,getUBXs32(p+24)/1e7,dateChanged); //deg*10^7
+	bool altChanged=updateAltitudes(getUBXs32(p+32)/1000.0,getUBXs32(p+36)/1000.0); //mm on the ellipsoid and on m.s.l.
+	updateTrack(getUBXs32(p+60)/1000.0,getUBXs32(p+64)/1e5); //ground speed mm/s and heading of motion deg*10^5
+	gps.climbFtMin=ms2FtMin(-getUBXs32(p+56)/1000.0); //down velocity mm/s
+	float hAcc=getUBXu32(p+40)/1000.0; //horizontal and vertical accuracy in mm
+	updatePositionErrors(hAcc,hAcc,getUBXu32(p+44)/1000.0);
+	gps.pdop=getUBXu16(p+76)/100.0;
+	if(posChanged||altChanged) {
+		UBXparser.stats.fixes++;
+		GPSreceiverNavigate();
+	}
+	BlackBoxCommit();
+}
+
+void decodeNavSat(const unsigned char *p, int len) { //satellites in view
+	int i, j, numSvs=p[5];
+	for(i=0;i<MAX_NUM_SAT;i++) for(j=SAT_ELEVATION;j<=SAT_SNR;j++) gps.satellites[i][j]=-1; //reset all sats
+	for(i=0;i<numSvs;i++) {
+		const unsigned char *sv=p+UBX_NAV_SAT_HEADER_LEN+i*UBX_NAV_SAT_SV_LEN;
+		int svId=sv[1];
+		if(sv[0]!=UBX_GNSS_GPS || svId<1 || svId>MAX_NUM_SAT) continue; //our table has only the GPS satellites
+		gps.satellites[svId-1][SAT_SNR]=sv[2]; //C/No dB-Hz
+		gps.satellites[svId-1][SAT_ELEVATION]=(signed char)sv[3]; //deg
+		gps.satellites[svId-1][SAT_AZIMUTH]=getUBXs16(sv+4); //deg
+	}
+	updateNumOfTotalSatsInView(numSvs);
+}
+
+void decodeNavDOP(const unsigned char *p) { //dilutions of precision *100
+	gps.pdop=getUBXu16(p+6)/100.0;
+	gps.vdop=getUBXu16(p+10)/100.0;
+	gps.hdop=getUBXu16(p+12)/100.0;
+}
+
+void decodeAck(const unsigned char *p, bool acknowledged) {
+	if(!acknowledged) {
+		UBXparser.stats.rejectedCfg++;
+		printLog("UBXparser: WARNING the receiver rejected the message class: 0x%02X ID: 0x%02X\n",p[0],p[1]);
+	}
+}
+
+void calcUBXchecksum(const unsigned char *data, int len, unsigned char *ckA, unsigned char *ckB) { //8 bit Fletcher
+	unsigned char a=0, b=0;
+	for(int i=0;i<len;i++) {
+		a+=data[i];
+		b+=a;
+	}
+	*ckA=a;
+	*ckB=b;
+}
+
+bool sendUBX(int fd, unsigned char msgClass, unsigned char msgId, const unsigned char *payload, int len) { //configuration messages are short
+	unsigned char frame[UBX_HEADER_LEN+16+UBX_TRAILER_LEN];
+	if(len>16) return false;
+	frame[0]=UBX_SYNC_1;
+	frame[1]=UBX_SYNC_2;
+	frame[2]=msgClass;
+	frame[3]=msgId;
+	frame[4]=len&0xFF; //little endian
+	frame[5]=len>>8;
+	memcpy(frame+UBX_HEADER_LEN,payload,len);
+	calcUBXchecksum(frame+2,len+4,&frame[UBX_HEADER_LEN+len],&frame[UBX_HEADER_LEN+len+1]);
+	return write(fd,frame,UBX_HEADER_LEN+len+UBX_TRAILER_LEN)==UBX_HEADER_LEN+len+UBX_TRAILER_LEN;
+}
+
+bool setMessageRate(int fd, unsigned char msgClass, unsigned char msgId, unsigned char rate) { //CFG-MSG: rate on the current port, as number of navigation solutions
+	unsigned char msg[3];
+	msg[0]=msgClass;
+	msg[1]=msgId;
+	msg[2]=rate;
+	return sendUBX(fd,UBX_CLASS_CFG,UBX_CFG_MSG,msg,sizeof(msg));
+}
+
+unsigned int getUBXu16(const unsigned char *p) { //UBX fields are little endian and not aligned
+	return p[0]|(p[1]<<8);
+}
+
+int getUBXs16(const unsigned char *p) {
+	return (short)getUBXu16(p);
+}
+
+unsigned long getUBXu32(const unsigned char *p) {
+	return p[0]|((unsigned long)p[1]<<8)|((unsigned long)p[2]<<16)|((unsigned long)p[3]<<24);
+}
+
+long getUBXs32(const unsigned char *p) {
+	return (long)(int)getUBXu32(p);
+}
@@ -0,0 +1,33 @@
+//============================================================================
+// Name        : UBXparser.h
+// Since       : 17/10/2026
+// Author      : Alberto Realis-Luc <alberto.realisluc@gmail.com>
+// Web         : https://www.alus.it/airnavigator/
+// Copyright   : (C) 2010-2026 Alberto Realis-Luc
+// License     : GNU GPL v2
+// Repository  : https://github.com/alus-it/AirNavigator.git
+// Last change : 17/10/2026
+// Description : Header of the parser of u-blox UBX messages: UBXparser.c
+//============================================================================
+
+#ifndef UBXPARSER_H_
+#define UBXPARSER_H_
+
+#include "Common.h"
+
+#define UBX_MAX_PAYLOAD 1024 //enough for NAV-SAT with 84 satellites
+#define UBX_MAX_RATE    25   //Hz, maximum navigation rate that can be configured
+
+struct UBXparserStats {
+	unsigned long frames;        //frames received with the right checksum
+	unsigned long wrongFrames;   //frames discarded because of wrong length or checksum
+	unsigned long ignoredFrames; //frames of messages not decoded or with an unexpected length
+	unsigned long fixes;         //new positions or altitudes given to the navigator
+	unsigned long rejectedCfg;   //configuration messages not acknowledged by the receiver
+};
+
+bool UBXparserProcessFrame(const unsigned char *frame, int len);
+bool UBXparserConfigure(int fd, int rateHz);
+void UBXparserGetStats(struct UBXparserStats *stats);
+
+#endif /* UBXPARSER_H_ */
@@ -6,7 +6,7 @@
 // Copyright   : (C) 2010-2020 Alberto Realis-Luc
 // License     : GNU GPL v2
 // Repository  : https://github.com/alus-it/AirNavigator.git
-// Last change : 28/2/2016
+// Last change : 17/10/2026
 // Description : main function of the AirNavigator program for TomTom devices
 //============================================================================
 
@@ -16,7 +16,6 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
-#include <dirent.h>
 #include <pthread.h>
 #include "Common.h"
 #include "Configuration.h"
@@ -26,19 +25,17 @@
 #include "Navigator.h"
 #include "AirCalc.h"
 #include "BlackBox.h"
-#include "HSI.h"
+#include "Renderer.h"
+#include "RouteCatalog.h"
 
 #ifndef VERSION
 #define VERSION "0.3.2"
 #endif
 
+#define LOAD_REDRAW_MS 250 //period to redraw the progress of the flight plan being loaded
 
-typedef struct fileName {
-	int seqNo;             //sequence number
-	char *name;            //name of the file
-	struct fileName *prev; //Pointer to the previous filename in the list
-	struct fileName *next; //Pointer to the next filename in the list
-} *fileEntry;
+#define ROUTE_ROW_Y      36 //first row of the flight plans in the select route screen
+#define ROUTE_ROW_HEIGHT 12
 
 struct mainStruct {
 	enum mainStatus status;           //Main status, it is the screen shown: main menu, HSI or select GPX file
@@ -102,56 +99,46 @@ int main(int argc, char** argv) {
 	}
 	printLog("Screen resolution: %dx%d pixel\n",screen.width,screen.height); //logFile screen resolution
 	loadConfig(); //Load configuration
-	fileEntry fileList=NULL, currFile=NULL; //the list of the found GPX flight plans and the pointer to the current one
-	int numGPXfiles=0;
-	struct dirent *entry=NULL;
-	char *routesPath; //... prepare the list of available flight plans found in the routes folder
+	BlackBoxRecover(); //GPX of the tracks not closed because of a power loss
+	int currRoute=0; //index in the catalog of the selected flight plan
+	char *routeName=NULL; //name of the flight plan loaded or being loaded
+	char *routesPath; //... prepare the catalog of available flight plans found in the routes folder
 	asprintf(&routesPath,"%sRoutes",BASE_PATH);
-	DIR *dir = opendir(routesPath);
-	free(routesPath);
-	if(dir!=NULL) {
-		int len;
-		while((entry=readdir(dir))!=NULL) { //make the list of GPX files...
-			len=strlen(entry->d_name);
-			if(len>3)
-				if( (entry->d_name[len-3]=='G' || entry->d_name[len-3]=='g') &&
-						(entry->d_name[len-2]=='P' || entry->d_name[len-2]=='p') &&
-						(entry->d_name[len-1]=='X' || entry->d_name[len-1]=='x')) {
-					fileEntry newFile=(fileEntry)malloc(sizeof(struct fileName));
-					newFile->name=strdup(entry->d_name);
-					newFile->seqNo=numGPXfiles;
-					newFile->next=NULL;
-					if(numGPXfiles==0) { //it's the first
-							fileList=newFile;
-							newFile->prev=NULL;
-					} else {
-							currFile->next=newFile;
-							newFile->prev=currFile; //link to the previous
-					}
-					currFile=newFile;
-					numGPXfiles++;
-				}
-		}
-		closedir(dir);
-		if(numGPXfiles==0) showMessage(config.colorSchema.warning,true,"WARNING: No GPX flight plan files found.");
-		else {
-			showMessage(config.colorSchema.ok,true,"Found %d GPX flight plan files.",numGPXfiles);
-			currFile=fileList;
-		}
+	if(RouteCatalogOpen(routesPath)) {
+		if(RouteCatalogCount()==0) showMessage(config.colorSchema.warning,true,"WARNING: No GPX flight plan files found.");
+		else showMessage(config.colorSchema.ok,true,"Found %d GPX flight plan files.",RouteCatalogCount());
 	} else showMessage(config.colorSchema.caution,true,"ERROR: could not open the Routes directory.");
+	free(routesPath);
+	if(!RendererStart()) showMessage(config.colorSchema.caution,true,"ERROR: HSI renderer failed to start."); //Start the render thread
 	if(!GPSreceiverStart()) showMessage(config.colorSchema.caution,true,"ERROR: GPSreceiver failed to start."); //Start GPSrecveiver
 	//TODO: if GPS failed to start many buttons should be disabled...
 	bool doExit=false;
 	TS_EVENT lastTouch; //data of the last event from the touch screen
 	char *toLoad=NULL; //the path to the chosen GPX file to be loaded
 	int numWPloaded=0; //the number of waypoints loaded from the selected flight plan
+	int loadProgress=0; //percent of the flight plan being loaded in background
 	while(!doExit) { //Main loop
+		if(NavGetLoadStatus(NULL)==NAV_LOAD_DONE) { //the flight plan has been loaded in background
+			int loaded=NavLoadFlightPlanEnd();
+			if(loaded>0) {
+				numWPloaded=loaded;
+				showMessage(config.colorSchema.ok,true,"Loaded route: %s - %d WayPoints",routeName,numWPloaded);
+			} else if(loaded==NAV_LOAD_CANCELED) showMessage(config.colorSchema.warning,false,"Loading of the route canceled.");
+			else showMessage(config.colorSchema.caution,true,"ERROR: while opening: %s",toLoad);
+			free(toLoad);
+			toLoad=NULL;
+			mainData.status=MAIN_DISPLAY_MENU;
+		}
+		RouteCatalogRefresh(&currRoute); //flight plans added, removed or changed meanwhile
+		if(mainData.status==MAIN_DISPLAY_SELECT_ROUTE && NavGetLoadStatus(NULL)==NAV_LOAD_IDLE)
+			RouteCatalogGet(currRoute,true); //start to read the info of the selected flight plan, if not yet done
+		FBrenderLock(); //the render thread could be drawing the HSI
 		FBrenderClear(0,screen.height,config.colorSchema.background);
 		switch(mainData.status) { //Depending on status display the proper screen
 			case MAIN_DISPLAY_MENU:
 				FBrenderBlitText(10,10,config.colorSchema.dirMarker,config.colorSchema.background,false,"AirNavigator v.%s",VERSION);
 				FBrenderBlitText(200,10,config.colorSchema.magneticDir,config.colorSchema.background,true,"http://www.alus.it/airnavigator");
-				DrawButton(20,50,numGPXfiles>0,"Load flight plan");
+				DrawButton(20,50,RouteCatalogCount()>0,"Load flight plan");
 				DrawButton(20,90,NavGetStatus()==NAV_STATUS_TO_START_NAV,"Start navigation");
 				DrawButton(20,130,numWPloaded>1,"Reverse flight plan");
 				DrawButton(20,170,numWPloaded>0,"Unload flight plan");
@@ -161,18 +148,36 @@ int main(int argc, char** argv) {
 				DrawButton(220,210,true,"EXIT");
 				if(mainData.bottomBarMsg!=NULL) FBrenderBlitText(10,260,mainData.bottomBarMsgColor,config.colorSchema.background,false,"%s                                                         ",mainData.bottomBarMsg); //render confirmation msg
 				break;
-			case MAIN_DISPLAY_SELECT_ROUTE: //Display the select GPX flight plan screen
-				FBrenderBlitText(20,20,config.colorSchema.dirMarker,config.colorSchema.background,0,"Select and load the desired GPX flight plan");
-				FBrenderBlitText(20,35,config.colorSchema.text,config.colorSchema.background,0,"%d GPX flight plans found.",numGPXfiles);
-				FBrenderBlitText(20,60,config.colorSchema.text,config.colorSchema.background,0,"Selected GPX flight plan:");
-				FBrenderBlitText(20,70,config.colorSchema.warning,config.colorSchema.background,0,"%s                                         ",currFile->name); //print the name of the current file
-				DrawButton(20,90,currFile->prev!=NULL,"<< Previous");
-				DrawButton(220,90,currFile->next!=NULL,"    Next >>");
-				DrawButton(220,210,currFile!=NULL,"    LOAD");
-				DrawButton(20,210,true,"Back to menu");
-			break;
-			case MAIN_DISPLAY_HSI: //Display HSI
-				NavRedrawNavInfo();
+			case MAIN_DISPLAY_SELECT_ROUTE: { //Display the select GPX flight plan screen: a page of the catalog
+				int numRoutes=RouteCatalogCount(), firstRow=currRoute-currRoute%ROUTE_CATALOG_PAGE_ROWS, i;
+				const struct RouteInfo *route;
+				FBrenderBlitText(20,10,config.colorSchema.dirMarker,config.colorSchema.background,0,"Select and load the desired GPX flight plan");
+				FBrenderBlitText(20,22,config.colorSchema.text,config.colorSchema.background,0,"%d GPX flight plans found - page %d/%d",numRoutes,firstRow/ROUTE_CATALOG_PAGE_ROWS+1,(numRoutes+ROUTE_CATALOG_PAGE_ROWS-1)/ROUTE_CATALOG_PAGE_ROWS);
+				for(i=0;i<ROUTE_CATALOG_PAGE_ROWS && (route=RouteCatalogGet(firstRow+i,false))!=NULL;i++) //the selected one in another color
+					FBrenderBlitText(20,ROUTE_ROW_Y+i*ROUTE_ROW_HEIGHT,firstRow+i==currRoute?config.colorSchema.warning:config.colorSchema.text,config.colorSchema.background,0,"%.55s",route->fileName);
+				route=RouteCatalogGet(currRoute,false);
+				if(NavGetLoadStatus(&loadProgress)==NAV_LOAD_RUNNING) { //progress of the loader and only the button to cancel it
+					FBrenderBlitText(20,124,config.colorSchema.text,config.colorSchema.background,0,"Loading flight plan: %3d%%",loadProgress);
+					FillRect(20,136,20+360*loadProgress/100,148,config.colorSchema.ok);
+					DrawButton(20,170,false,"<< Previous page");
+					DrawButton(220,170,false,"  Next page >>");
+					DrawButton(220,210,true,"   CANCEL");
+					DrawButton(20,210,false,"Back to menu");
+				} else {
+					if(route!=NULL && route->infoRead) { //info of the selected flight plan
+						if(route->infoValid) {
+							FBrenderBlitText(20,124,config.colorSchema.text,config.colorSchema.background,0,"%d WayPoints - %.1f Km",route->info.numWayPoints,route->info.totalDistKm);
+							FBrenderBlitText(20,136,config.colorSchema.text,config.colorSchema.background,0,"From %s to %s",route->info.departure,route->info.destination);
+						} else FBrenderBlitText(20,124,config.colorSchema.caution,config.colorSchema.background,0,"No flight plan found in this file");
+					} else if(route!=NULL) FBrenderBlitText(20,124,config.colorSchema.text,config.colorSchema.background,0,"..."); //being read in background
+					DrawButton(20,170,firstRow>0,"<< Previous page");
+					DrawButton(220,170,firstRow+ROUTE_CATALOG_PAGE_ROWS<numRoutes,"  Next page >>");
+					DrawButton(220,210,route!=NULL && !RouteCatalogInfoPending(),"    LOAD");
+					DrawButton(20,210,true,"Back to menu");
+				}
+			} break;
+			case MAIN_DISPLAY_HSI: //Display HSI: it will be drawn by the render thread
+				RendererRedraw();
 				break;
 			case MAIN_DISPLAY_SUNRISE_SUNSET: // Display ephemerides
 				NavRedrawEphemeridalInfo();
@@ -181,11 +186,14 @@ int main(int argc, char** argv) {
 				break;
 		} //end of display switch
 		FBrenderFlush();
-		TSreaderGetTouch(&lastTouch); //wait that the user touches the screen and get the coordinates of the touch
+		FBrenderUnlock();
+		if(NavGetLoadStatus(NULL)!=NAV_LOAD_IDLE || RouteCatalogInfoPending()) { //while loading a flight plan redraw its progress, or its info when read
+			if(TSreaderWaitTouch(&lastTouch,LOAD_REDRAW_MS)!=1) continue;
+		} else TSreaderGetTouch(&lastTouch); //wait that the user touches the screen and get the coordinates of the touch
 		switch(mainData.status) { //depending on which screen we are process the input touch
 			case MAIN_DISPLAY_MENU: //here process main menu input
 				if(lastTouch.x>=20 && lastTouch.x<=200) { //touched the first column of buttons
-					if(lastTouch.y>=50 && lastTouch.y<=80 && numGPXfiles>0) mainData.status=MAIN_DISPLAY_SELECT_ROUTE; //touched load route button
+					if(lastTouch.y>=50 && lastTouch.y<=80 && RouteCatalogCount()>0) mainData.status=MAIN_DISPLAY_SELECT_ROUTE; //touched load route button
 					if(lastTouch.y>=90 && lastTouch.y<=120 && NavGetStatus()==NAV_STATUS_TO_START_NAV) { //touched start navigation button
 						NavStartNavigation();
 						mainData.status=MAIN_DISPLAY_HSI;
@@ -197,7 +205,7 @@ int main(int argc, char** argv) {
 					if(lastTouch.y>=170 && lastTouch.y<=200 && numWPloaded>0) { //touched unload route button
 						NavClearRoute();
 						numWPloaded=0;
-						currFile=fileList;
+						currRoute=0;
 						showMessage(config.colorSchema.ok,false,"Route unloaded.");
 					}
 				} else if(lastTouch.x>=220 && lastTouch.x<=400) { //touched second column of buttons
@@ -223,37 +231,46 @@ int main(int argc, char** argv) {
 					if(lastTouch.y>=210 && lastTouch.y<=240) { //touched exit button
 						doExit=true;
 						showMessage(config.colorSchema.warning,false,"Exit: releasing all... Goodbye!"); //Show goodbye message
+						FBrenderLock();
 						FBrenderBlitText(10,260,mainData.bottomBarMsgColor,config.colorSchema.background,false,"%s                                                         ",mainData.bottomBarMsg);
 						FBrenderFlush();
+						FBrenderUnlock();
 					}
 				}
 				break;
 			case MAIN_DISPLAY_SELECT_ROUTE: //here process user input in select route screen
-				if(lastTouch.y>=90 && lastTouch.y<=120) { //user touched at the height of prev and next buttons
-					if(lastTouch.x>=20 && lastTouch.x<=200 && currFile->prev!=NULL) currFile=currFile->prev;  //user touched prev button
-					else if(lastTouch.x>=220 && lastTouch.x<=400 && currFile->next!=NULL) currFile=currFile->next; //user touched next button
+				if(NavGetLoadStatus(NULL)!=NAV_LOAD_IDLE) { //while loading only the cancel button is active
+					if(lastTouch.y>=210 && lastTouch.y<=240 && lastTouch.x>=220 && lastTouch.x<=400) NavCancelLoad();
+				} else if(lastTouch.y>=ROUTE_ROW_Y && lastTouch.y<ROUTE_ROW_Y+ROUTE_CATALOG_PAGE_ROWS*ROUTE_ROW_HEIGHT) { //user touched a flight plan of the page: select it
+					int row=currRoute-currRoute%ROUTE_CATALOG_PAGE_ROWS+(lastTouch.y-ROUTE_ROW_Y)/ROUTE_ROW_HEIGHT;
+					if(row<RouteCatalogCount()) currRoute=row;
+				} else if(lastTouch.y>=170 && lastTouch.y<=200) { //user touched at the height of prev and next page buttons
+					int firstRow=currRoute-currRoute%ROUTE_CATALOG_PAGE_ROWS;
+					if(lastTouch.x>=20 && lastTouch.x<=200 && firstRow>0) currRoute=firstRow-ROUTE_CATALOG_PAGE_ROWS;  //user touched prev page button
+					else if(lastTouch.x>=220 && lastTouch.x<=400 && firstRow+ROUTE_CATALOG_PAGE_ROWS<RouteCatalogCount()) currRoute=firstRow+ROUTE_CATALOG_PAGE_ROWS; //user touched next page button
 				} else if(lastTouch.y>=210 && lastTouch.y<=240) { //user touched at the height of back, load buttons
 					if(lastTouch.x>=20 && lastTouch.x<=200) {  //user touched back button
 						mainData.status=MAIN_DISPLAY_MENU; //go back to main menu
 						free(mainData.bottomBarMsg); //remove previous message
 						mainData.bottomBarMsg=NULL;
-					} else if(lastTouch.x>=220 && lastTouch.x<=400) { //user touched LOAD button
-						asprintf(&toLoad,"%s%s%s",BASE_PATH,"Routes/",currFile->name);
-						numWPloaded=NavLoadFlightPlan(toLoad); //Attempt to load the flight plan
-						if(numWPloaded<1) { //if load route failed
+					} else if(lastTouch.x>=220 && lastTouch.x<=400 && RouteCatalogGet(currRoute,false)!=NULL && !RouteCatalogInfoPending()) { //user touched LOAD button, not while the cache of a plan can be written
+						toLoad=RouteCatalogPath(currRoute);
+						free(routeName);
+						routeName=strdup(RouteCatalogGet(currRoute,false)->fileName);
+						if(!NavLoadFlightPlanStart(toLoad)) { //Attempt to load the flight plan in background: the main loop will take the result
 							if(toLoad!=NULL) showMessage(config.colorSchema.caution,true,"ERROR: while opening: %s",toLoad);
 							else showMessage(config.colorSchema.caution,true,"ERROR: NULL pointer to the route file to be loaded.");
-						} else showMessage(config.colorSchema.ok,true,"Loaded route: %s - %d WayPoints",currFile->name,numWPloaded);
-						free(toLoad);
-						toLoad=NULL;
-						mainData.status=MAIN_DISPLAY_MENU;
+							free(toLoad);
+							toLoad=NULL;
+							mainData.status=MAIN_DISPLAY_MENU;
+						}
 					}
 				}
 				break;
 			case MAIN_DISPLAY_HSI: //here process the user input the HSI screen
 			case MAIN_DISPLAY_SUNRISE_SUNSET: // and in the ephemeides screen
 				mainData.status=MAIN_DISPLAY_MENU; //a touch anywhere here brings back to main menu
-				if(numWPloaded>0) showMessage(config.colorSchema.ok,false,"Loaded route: %s - %d WayPoints",currFile->name,numWPloaded);
+				if(numWPloaded>0) showMessage(config.colorSchema.ok,false,"Loaded route: %s - %d WayPoints",routeName,numWPloaded);
 				else { //Nothing to display
 					free(mainData.bottomBarMsg);
 					mainData.bottomBarMsg=NULL;
@@ -265,18 +282,16 @@ int main(int argc, char** argv) {
 		} //end of user input processing switch
 	} //end of main loop
 	GPSreceiverClose(); //Clean and Close all ...
+	RendererClose();
 	free(config.GPSdevName);
+	free(config.GPSreplayFile);
 	NavClose();
 	BlackBoxClose();
 	free(config.tomtomModel);
 	free(config.serialNumber);
 	free(mainData.bottomBarMsg);
-	if(numGPXfiles>0) do { //free the list of GPX files
-		currFile=fileList;
-		free(currFile->name);
-		fileList=currFile->next;
-		free(currFile);
-	} while(fileList!=NULL);
+	free(routeName);
+	RouteCatalogClose();
 	releaseAll();
 	exit(EXIT_SUCCESS);
 }
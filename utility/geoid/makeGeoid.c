@@ -0,0 +1,93 @@
+//============================================================================
+// Name        : makeGeoid.c
+// Since       : 17/10/2026
+// Author      : Alberto Realis-Luc <alberto.realisluc@gmail.com>
+// Web         : https://www.alus.it/airnavigator/
+// Copyright   : (C) 2010-2026 Alberto Realis-Luc
+// License     : GNU GPL v2
+// Repository  : https://github.com/alus-it/AirNavigator.git
+// Last change : 17/10/2026
+// Description : Converts a geoid grid in the ASCII format of the NGA (as the
+//               EGM96 15' WW15MGH.GRD) in the geoid.dat file of AirNavigator
+//============================================================================
+
+// Build with: gcc -O2 -Wall makeGeoid.c -lm -o makeGeoid
+// Usage:      ./makeGeoid WW15MGH.GRD geoid.dat [step]
+// The optional step keeps one sample each step in both directions: 2 makes a
+// 0.5 degrees grid of 520 KB from the 15' grid of 2 MB.
+//
+// geoid.dat: "GEOD", width and height as little endian 16 bit integers, then
+// height rows from 90N to 90S, each of width samples from 0E eastward, of the
+// geoidal separation in cm as little endian 16 bit integers.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define MAX_SIZE 10800 //same limit of Geoidal.c
+
+int main(int argc, char** argv) {
+	double south,north,west,east,dlat,dlon;
+	if(argc<3) {
+		printf("Usage: %s input.GRD geoid.dat [step]\n",argv[0]);
+		return EXIT_FAILURE;
+	}
+	int step=(argc>3)?atoi(argv[3]):1;
+	if(step<1) step=1;
+	FILE *in=fopen(argv[1],"r");
+	if(in==NULL) {
+		printf("ERROR: Unable to open %s\n",argv[1]);
+		return EXIT_FAILURE;
+	}
+	if(fscanf(in,"%lf %lf %lf %lf %lf %lf",&south,&north,&west,&east,&dlat,&dlon)!=6 || dlat<=0 || dlon<=0) {
+		printf("ERROR: %s has not the header of a NGA grid\n",argv[1]);
+		fclose(in);
+		return EXIT_FAILURE;
+	}
+	if(south!=-90 || north!=90 || west!=0 || (east!=360 && east!=360-dlon)) {
+		printf("ERROR: the grid must cover the whole Earth from 0E\n");
+		fclose(in);
+		return EXIT_FAILURE;
+	}
+	int rows=(int)floor(180/dlat+0.5)+1, cols=(int)floor((east-west)/dlon+0.5)+1;
+	int width=(int)floor(360/dlon+0.5); //when the grid ends at 360E its last column is again 0E
+	if(width%step!=0 || (rows-1)%step!=0 || width/step>MAX_SIZE || (rows-1)/step>MAX_SIZE) {
+		printf("ERROR: step %d not possible on this grid\n",step);
+		fclose(in);
+		return EXIT_FAILURE;
+	}
+	short *grid=(short*)malloc(rows*width*sizeof(short));
+	if(grid==NULL) {
+		printf("ERROR: not enough memory\n");
+		fclose(in);
+		return EXIT_FAILURE;
+	}
+	for(int r=0;r<rows;r++) for(int c=0;c<cols;c++) {
+		double value;
+		if(fscanf(in,"%lf",&value)!=1) {
+			printf("ERROR: %s ends at row %d column %d\n",argv[1],r,c);
+			fclose(in);
+			free(grid);
+			return EXIT_FAILURE;
+		}
+		if(c<width) grid[r*width+c]=(short)floor(value*100+0.5);
+	}
+	fclose(in);
+	FILE *out=fopen(argv[2],"wb");
+	if(out==NULL) {
+		printf("ERROR: Unable to write %s\n",argv[2]);
+		free(grid);
+		return EXIT_FAILURE;
+	}
+	int outWidth=width/step, outHeight=(rows-1)/step+1;
+	unsigned char header[8]={'G','E','O','D',outWidth&0xFF,outWidth>>8,outHeight&0xFF,outHeight>>8};
+	fwrite(header,sizeof(header),1,out);
+	for(int r=0;r<rows;r+=step) for(int c=0;c<width;c+=step) {
+		unsigned char sample[2]={grid[r*width+c]&0xFF,(grid[r*width+c]>>8)&0xFF};
+		fwrite(sample,2,1,out);
+	}
+	fclose(out);
+	free(grid);
+	printf("Written %s: %d x %d samples\n",argv[2],outWidth,outHeight);
+	return EXIT_SUCCESS;
+}